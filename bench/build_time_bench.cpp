@@ -0,0 +1,92 @@
+// Compiles the same Mat-heavy translation units with and without the extern template
+// declarations of mat3.hpp, mat4.hpp, vec3.hpp and vec4.hpp, and reports the compile time and
+// object size of each configuration. The compiler and include directory come from CMake.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace
+{
+  constexpr int unit_count = 16;
+
+  constexpr const char *unit_source = R"(#include <pjmath/mat3.hpp>
+#include <pjmath/mat4.hpp>
+
+using namespace pjmath;
+
+Vec4 transform(const Mat4 &a, const Mat4 &b, const Vec4 &v)
+{
+  Mat4 c = a * b;
+  c *= a;
+  c += b;
+  c = -(c - a);
+  c.addScaled(a, 2).lerp(b, 0.5);
+  return c.pow(3) * v + Mat4::identity().transposed() * v + v * 2.0;
+}
+
+Vec3 rotate(const Mat3 &a, const Mat3 &b, const Vec3 &v)
+{
+  Mat3 c = a * b;
+  c *= a;
+  c.transpose();
+  return c.pow(2) * v + Mat3::diagonal(2) * v - v + Vec3::one() + Vec3::zero() * c.sum();
+}
+
+real_t reduce(const Mat4 &m)
+{
+  return m.row(1).at(0, 0) + m.col(2).at(1, 0) + m.sum() + Mat4::filled(1).sum();
+}
+)";
+
+  struct Result
+  {
+    double seconds = 0;
+    uintmax_t bytes = 0;
+  };
+
+  Result compileAll(const std::filesystem::path &directory, const std::string &flags)
+  {
+    Result result;
+    auto start = std::chrono::steady_clock::now();
+    for (int unit = 0; unit < unit_count; unit++)
+    {
+      std::filesystem::path source = directory / ("unit" + std::to_string(unit) + ".cpp");
+      std::filesystem::path object = directory / ("unit" + std::to_string(unit) + ".o");
+      std::string command = std::string(PJMATH_CXX_COMPILER) + " -std=gnu++20 " + flags + " -I" +
+                            PJMATH_INCLUDE_DIR + " -c " + source.string() + " -o " + object.string();
+      if (std::system(command.c_str()) != 0)
+      {
+        std::fprintf(stderr, "failed: %s\n", command.c_str());
+        std::exit(1);
+      }
+      result.bytes += std::filesystem::file_size(object);
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+  }
+}
+
+int main()
+{
+  std::filesystem::path directory = std::filesystem::temp_directory_path() / "pjmath_build_time_bench";
+  std::filesystem::create_directories(directory);
+  for (int unit = 0; unit < unit_count; unit++)
+  {
+    std::ofstream(directory / ("unit" + std::to_string(unit) + ".cpp")) << unit_source;
+  }
+
+  std::printf("%d translation units\n", unit_count);
+  for (const char *optimization : {"-O0", "-O2"})
+  {
+    Result shared = compileAll(directory, optimization);
+    Result local = compileAll(directory, std::string(optimization) + " -DPJMATH_NO_EXTERN_TEMPLATES");
+    std::printf("%s extern templates    %8.3f s %10ju bytes of objects\n", optimization, shared.seconds, shared.bytes);
+    std::printf("%s instantiated per TU %8.3f s %10ju bytes of objects\n", optimization, local.seconds, local.bytes);
+  }
+
+  std::filesystem::remove_all(directory);
+}
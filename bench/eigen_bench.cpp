@@ -0,0 +1,69 @@
+#include <pjmath/eigen.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace pjmath;
+
+namespace
+{
+  template <typename F>
+  double secondsFor(F &&f)
+  {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  void report(const char *name, size_t count, double seconds, real_t checksum)
+  {
+    std::printf("%-10s %12.3f Mmat/s  (checksum %g)\n", name, count / seconds * 1e-6, checksum);
+  }
+}
+
+int main()
+{
+  constexpr size_t count = 1 << 20;
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<real_t> value(-1, 1);
+
+  std::vector<Mat3> matrices;
+  SymmetricMat3Array packed;
+  for (size_t i = 0; i < count; i++)
+  {
+    real_t xx = value(rng), yy = value(rng), zz = value(rng), xy = value(rng), xz = value(rng), yz = value(rng);
+    matrices.push_back(Mat3{xx, xy, xz, xy, yy, yz, xz, yz, zz});
+    packed.push_back(std::array<real_t, 6>{xx, yy, zz, xy, xz, yz});
+  }
+
+  real_t checksum = 0;
+  double seconds = secondsFor([&] {
+    for (const Mat3 &a : matrices)
+    {
+      checksum += symmetricEigen(a).values[0];
+    }
+  });
+  report("analytic", count, seconds, checksum);
+
+  checksum = 0;
+  seconds = secondsFor([&] {
+    for (const Mat3 &a : matrices)
+    {
+      checksum += symmetricEigenJacobi(a).values[0];
+    }
+  });
+  report("jacobi", count, seconds, checksum);
+
+  SoAVec3Array values;
+  SoAVecArray<9> vectors;
+  seconds = secondsFor([&] { symmetricEigen(packed, values, vectors); });
+  checksum = 0;
+  for (real_t v : values.x())
+  {
+    checksum += v;
+  }
+  report("batch", count, seconds, checksum);
+  return 0;
+}
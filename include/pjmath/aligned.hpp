@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace pjmath
+{
+  /**
+   * @brief Alignment used for arrays processed by SIMD kernels, one cache line
+   */
+  constexpr size_t simd_alignment = 64;
+
+  /**
+   * @brief Allocator which aligns every allocation to @a Alignment bytes
+   *
+   * @tparam T Allocated type
+   * @tparam Alignment Alignment in bytes, a power of two
+   */
+  template <typename T, size_t Alignment = simd_alignment>
+  class AlignedAllocator
+  {
+  public:
+    using value_type = T; ///< Allocated type
+
+    static_assert((Alignment & (Alignment - 1)) == 0);
+
+    /**
+     * @brief Rebinds the allocator to another type with the same alignment
+     */
+    template <typename U>
+    struct rebind
+    {
+      using other = AlignedAllocator<U, Alignment>; ///< Rebound allocator type
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &)
+    {
+    }
+
+    /**
+     * @brief Allocates aligned storage for @a n objects
+     */
+    T *allocate(size_t n)
+    {
+      return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    /**
+     * @brief Releases storage obtained from @ref allocate
+     */
+    void deallocate(T *p, size_t)
+    {
+      ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const
+    {
+      return true;
+    }
+  };
+
+  /**
+   * @brief A `std::vector` whose storage is aligned for SIMD kernels
+   */
+  template <typename T>
+  using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+}
@@ -0,0 +1,340 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+#include "definitions.hpp"
+#include "dispatch.hpp"
+#include "kernels.hpp"
+#include "mat.hpp"
+#include "mat4.hpp"
+#include "vector.hpp"
+
+/**
+ * Operations over arrays of matrices and vectors.
+ *
+ * `Mat` and `Vector` types are plain `std::array`s with no extra members, so an array of
+ * them is one contiguous run of scalars. Element-wise batch operations use that to run a
+ * single flat kernel over the whole batch rather than one small loop per object.
+ *
+ * Operations on real_t points, transforms and vectors run the kernels of
+ * dispatch.hpp, compiled for the best instruction set level of the host.
+ */
+namespace pjmath
+{
+  namespace detail
+  {
+    /**
+     * @brief Reinterprets an array of matrices or vectors as the scalars they contain
+     *
+     * @tparam T Matrix or vector type, possibly const
+     * @param objects Array of objects
+     * @return The elements of every object, in order
+     */
+    template <typename T>
+    auto flatten(std::span<T> objects)
+    {
+      using Value = std::remove_const_t<typename T::value_type>;
+      using Scalar = std::conditional_t<std::is_const_v<T>, const Value, Value>;
+      constexpr size_t count = sizeof(T) / sizeof(Value);
+
+      static_assert(std::is_base_of_v<std::array<Value, count>, std::remove_const_t<T>>);
+      static_assert(sizeof(T) == sizeof(std::array<Value, count>));
+
+      return std::span<Scalar>(reinterpret_cast<Scalar *>(objects.data()), objects.size() * count);
+    }
+
+    template <typename A, typename B>
+    void checkBatchSize(std::span<A> a, std::span<B> b)
+    {
+      if (a.size() != b.size())
+      {
+        throw std::invalid_argument("batch sizes do not match");
+      }
+    }
+  }
+
+  /**
+   * @brief Computes @a y[i] += @a x[i] * @a s for every object in the batch
+   *
+   * @tparam T Matrix or vector type
+   * @param y Accumulated objects
+   * @param x Objects to scale and add
+   * @param s Scale factor
+   */
+  template <typename T>
+  void addScaled(std::span<T> y, std::span<const T> x, typename T::value_type s)
+  {
+    detail::checkBatchSize(y, x);
+    auto out = detail::flatten(y);
+    kernels::addScaled(out.data(), detail::flatten(x).data(), s, out.size());
+  }
+
+  /**
+   * @brief Computes @a y[i] += @a a[i] * @a b[i] element-wise for every object in the batch
+   *
+   * @tparam T Matrix or vector type
+   * @param y Accumulated objects
+   * @param a Left factors
+   * @param b Right factors
+   */
+  template <typename T>
+  void madd(std::span<T> y, std::span<const T> a, std::span<const T> b)
+  {
+    detail::checkBatchSize(y, a);
+    detail::checkBatchSize(y, b);
+    auto out = detail::flatten(y);
+    kernels::madd(out.data(), detail::flatten(a).data(), detail::flatten(b).data(), out.size());
+  }
+
+  /**
+   * @brief Computes @a y[i] = @a y[i] * @a m[i] + @a c[i] element-wise for every object in the batch
+   *
+   * @tparam T Matrix or vector type
+   * @param y Objects to update
+   * @param m Element-wise factors
+   * @param c Addends
+   */
+  template <typename T>
+  void fma(std::span<T> y, std::span<const T> m, std::span<const T> c)
+  {
+    detail::checkBatchSize(y, m);
+    detail::checkBatchSize(y, c);
+    auto out = detail::flatten(y);
+    kernels::fma(out.data(), detail::flatten(m).data(), detail::flatten(c).data(), out.size());
+  }
+
+  /**
+   * @brief Computes @a out[i] = lerp(@a a[i], @a b[i], @a t) for every object in the batch
+   *
+   * @a out may be the same array as @a a or @a b.
+   *
+   * @tparam T Matrix or vector type
+   * @param out Interpolated objects
+   * @param a Objects reached when @a t is zero
+   * @param b Objects reached when @a t is one
+   * @param t Interpolation factor
+   */
+  template <typename T>
+  void lerp(std::span<T> out, std::span<const T> a, std::span<const T> b, typename T::value_type t)
+  {
+    detail::checkBatchSize(out, a);
+    detail::checkBatchSize(out, b);
+    auto y = detail::flatten(out);
+    kernels::lerp(y.data(), detail::flatten(a).data(), detail::flatten(b).data(), t, y.size());
+  }
+
+  /**
+   * @brief Linearly interpolates between two matrices in a single pass
+   *
+   * @param a Matrix returned when @a t is zero
+   * @param b Matrix returned when @a t is one
+   * @param t Interpolation factor
+   * @return The interpolated matrix
+   */
+  template <typename E, size_t M, size_t N, typename D>
+  typename Mat<E, M, N, D>::Self lerp(const Mat<E, M, N, D> &a, const Mat<E, M, N, D> &b,
+                                      const std::type_identity_t<E> &t)
+  {
+    typename Mat<E, M, N, D>::Self out;
+    kernels::lerp(out.data(), a.data(), b.data(), t, out.size());
+    return out;
+  }
+
+  /**
+   * @brief Linearly interpolates between two vectors in a single pass
+   *
+   * @param a Vector returned when @a t is zero
+   * @param b Vector returned when @a t is one
+   * @param t Interpolation factor
+   * @return The interpolated vector
+   */
+  template <size_t N, typename VectorType, typename ValueType>
+  VectorType lerp(const Vector<N, VectorType, ValueType> &a, const Vector<N, VectorType, ValueType> &b,
+                  std::type_identity_t<ValueType> t)
+  {
+    VectorType out;
+    kernels::lerp(out.data(), a.data(), b.data(), t, N);
+    return out;
+  }
+
+  /**
+   * @brief Computes @a out[i] = dot(@a a[i], @a b[i]) for every pair in the batch
+   *
+   * @tparam T Vector type, or a matrix type whose elements are treated as one vector
+   * @param a First vector of every pair
+   * @param b Second vector of every pair
+   * @param out Receives one dot product per pair
+   */
+  template <typename T>
+  void dot(std::span<const T> a, std::span<const T> b, std::span<typename T::value_type> out)
+  {
+    using Value = typename T::value_type;
+    detail::checkBatchSize(a, b);
+    detail::checkBatchSize(a, out);
+    kernels::dots<sizeof(T) / sizeof(Value)>(detail::flatten(a).data(), detail::flatten(b).data(),
+                                             out.data(), out.size());
+  }
+
+  /**
+   * @brief Normalizes every vector in the batch in place
+   *
+   * Vectors of zero length are left unchanged, as @ref Vector::Normalize does.
+   *
+   * @tparam T Vector type, or a matrix type whose elements are treated as one vector
+   * @param vectors Vectors to normalize
+   * @param mode Accuracy mode, see @ref NormalizeMode for the error bounds
+   */
+  template <typename T>
+  void normalize(std::span<T> vectors, NormalizeMode mode = NormalizeMode::exact)
+  {
+    using Value = typename T::value_type;
+    constexpr size_t width = sizeof(T) / sizeof(Value);
+    if constexpr (width == 3 && std::is_same_v<Value, real_t>)
+    {
+      if (mode == NormalizeMode::exact)
+      {
+        dispatch::normalize3(detail::flatten(vectors).data(), vectors.size());
+        return;
+      }
+    }
+    kernels::normalize<width>(detail::flatten(vectors).data(), vectors.size(), mode);
+  }
+
+  /**
+   * @brief Transforms every point of the batch by a 4x4 matrix, as (x, y, z, 1)
+   *
+   * The result is divided by its w when the bottom row of @a m is not (0, 0, 0, 1), affine
+   * transforms skip the division. @a points and @a out may be the same array.
+   *
+   * @tparam T Three dimensional vector type
+   * @param m Transform
+   * @param points Points to transform
+   * @param out Receives the transformed points
+   */
+  template <typename T>
+  void transformPoints(const Mat4 &m, std::span<const T> points, std::span<T> out)
+  {
+    using Value = typename T::value_type;
+    static_assert(sizeof(T) == 3 * sizeof(Value));
+    detail::checkBatchSize(points, out);
+
+    const Value *in = detail::flatten(points).data();
+    Value *result = detail::flatten(out).data();
+    if constexpr (std::is_same_v<Value, real_t>)
+    {
+      dispatch::transformPoints(m.data(), in, result, points.size());
+    }
+    else
+    {
+      Value a[16];
+      for (size_t k = 0; k < 16; k++)
+      {
+        a[k] = Value(m[k]);
+      }
+      bool affine = a[12] == 0 && a[13] == 0 && a[14] == 0 && a[15] == 1;
+
+      for (size_t i = 0; i < points.size(); i++)
+      {
+        Value x = in[3 * i];
+        Value y = in[3 * i + 1];
+        Value z = in[3 * i + 2];
+        Value tx = a[0] * x + a[1] * y + a[2] * z + a[3];
+        Value ty = a[4] * x + a[5] * y + a[6] * z + a[7];
+        Value tz = a[8] * x + a[9] * y + a[10] * z + a[11];
+        if (!affine)
+        {
+          Value inverseW = Value(1) / (a[12] * x + a[13] * y + a[14] * z + a[15]);
+          tx *= inverseW;
+          ty *= inverseW;
+          tz *= inverseW;
+        }
+        result[3 * i] = tx;
+        result[3 * i + 1] = ty;
+        result[3 * i + 2] = tz;
+      }
+    }
+  }
+
+  /**
+   * @brief Computes @a out[i] = @a a[i] * @a b[i] for every pair of transforms in the batch
+   *
+   * @a out may be the same array as @a a or @a b.
+   *
+   * @param a Left factors
+   * @param b Right factors
+   * @param out Receives the products
+   */
+  inline void multiply(std::span<const Mat4> a, std::span<const Mat4> b, std::span<Mat4> out)
+  {
+    detail::checkBatchSize(a, b);
+    detail::checkBatchSize(a, out);
+    dispatch::multiply4x4(detail::flatten(a).data(), detail::flatten(b).data(), detail::flatten(out).data(),
+                          out.size());
+  }
+
+  /**
+   * @brief Computes the sine and cosine of every angle in the batch
+   *
+   * Within 2 ulp of `std::sin` and `std::cos`.
+   *
+   * @param x Angles, in radians
+   * @param sines Receives the sines, may not alias @a x
+   * @param cosines Receives the cosines, may not alias @a x
+   */
+  inline void sinCos(std::span<const real_t> x, std::span<real_t> sines, std::span<real_t> cosines)
+  {
+    detail::checkBatchSize(x, sines);
+    detail::checkBatchSize(x, cosines);
+    dispatch::sinCos(x.data(), sines.data(), cosines.data(), x.size());
+  }
+
+  /**
+   * @brief Sums an array
+   *
+   * Fast mode runs the dispatched kernel, reproducible mode also runs on the current
+   * executor and gives the same bits for any thread count, see @ref Summation.
+   *
+   * @param x Values to sum
+   * @param mode Accuracy mode of the summation
+   */
+  inline real_t sum(std::span<const real_t> x, Summation mode = Summation::fast)
+  {
+    switch (mode)
+    {
+    case Summation::fast:
+      return dispatch::sum(x.data(), x.size());
+    case Summation::reproducible:
+      return dispatch::reproducibleSum(x.data(), x.size());
+    default:
+      return kernels::sum(x.data(), x.size(), mode);
+    }
+  }
+
+  /**
+   * @brief Dot product of two arrays, with the same modes as @ref sum
+   *
+   * The fast mode never fuses products into the additions, so unlike `Vector::Dot` its result
+   * does not depend on `FP_FAST_FMA`, and the two can differ in builds where it is defined.
+   *
+   * @param a First array
+   * @param b Second array
+   * @param mode Accuracy mode of the summation
+   */
+  inline real_t dot(std::span<const real_t> a, std::span<const real_t> b, Summation mode = Summation::fast)
+  {
+    detail::checkBatchSize(a, b);
+    switch (mode)
+    {
+    case Summation::fast:
+      return dispatch::dot(a.data(), b.data(), a.size());
+    case Summation::reproducible:
+      return dispatch::reproducibleDot(a.data(), b.data(), a.size());
+    default:
+      return kernels::dot(a.data(), b.data(), a.size(), mode);
+    }
+  }
+}
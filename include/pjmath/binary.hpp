@@ -0,0 +1,222 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "definitions.hpp"
+#include "mat4.hpp"
+#include "vec3.hpp"
+#include "vector.hpp"
+
+/**
+ * Binary container for arrays of pjmath types.
+ *
+ * Layout, every integer little-endian:
+ *
+ *   header     64 bytes: magic "PJMATHB\0", format version u32, real_t size u32, table offset u64,
+ *              array count u64, zero padding
+ *   arrays     raw elements of each array in native layout, each starting on a 64 byte boundary
+ *   table      one 64 byte entry per array: name (NUL padded, 40 bytes), element kind u32,
+ *              element size u32, element count u64, data offset u64
+ *
+ * The table is written last, so a writer streams the arrays without knowing their sizes up front.
+ */
+namespace pjmath
+{
+  /**
+   * @brief Version written to and accepted from the header
+   */
+  constexpr uint32_t binary_format_version = 1;
+
+  /**
+   * @brief Alignment in bytes of the header, every array and the table
+   */
+  constexpr size_t binary_alignment = 64;
+
+  /**
+   * @brief Longest array name, in bytes
+   */
+  constexpr size_t binary_max_name = 39;
+
+  /**
+   * @brief Type of the elements of an array
+   */
+  enum class BinaryElement : uint32_t
+  {
+    real = 1,    ///< real_t
+    vec3 = 2,    ///< Vec3
+    vector3 = 3, ///< Vector3
+    mat4 = 4,    ///< Mat4
+  };
+
+  namespace detail
+  {
+    template <typename T>
+    struct binary_element;
+
+    template <>
+    struct binary_element<real_t>
+    {
+      static constexpr BinaryElement value = BinaryElement::real;
+    };
+
+    template <>
+    struct binary_element<Vec3>
+    {
+      static constexpr BinaryElement value = BinaryElement::vec3;
+    };
+
+    template <>
+    struct binary_element<Vector3>
+    {
+      static constexpr BinaryElement value = BinaryElement::vector3;
+    };
+
+    template <>
+    struct binary_element<Mat4>
+    {
+      static constexpr BinaryElement value = BinaryElement::mat4;
+    };
+  }
+
+  /**
+   * @brief Streams arrays into a binary container file
+   *
+   * Arrays are written one at a time: @ref beginArray starts one, @ref write appends elements
+   * to it as often as needed, and the next @ref beginArray or @ref close ends it. Only the table
+   * of arrays is held in memory. Failed writes throw std::runtime_error.
+   */
+  class BinaryWriter
+  {
+  public:
+    /**
+     * @brief Creates or truncates @a path and writes a provisional header
+     */
+    explicit BinaryWriter(const std::string &path);
+
+    BinaryWriter(const BinaryWriter &) = delete;
+    BinaryWriter &operator=(const BinaryWriter &) = delete;
+
+    /**
+     * @brief Closes the file if @ref close was not called, errors are ignored
+     */
+    ~BinaryWriter();
+
+    /**
+     * @brief Starts a new array of @a T named @a name
+     *
+     * @throws std::invalid_argument if the name is empty, too long or already used
+     */
+    template <typename T>
+    void beginArray(std::string_view name)
+    {
+      beginArray(name, detail::binary_element<T>::value, sizeof(T));
+    }
+
+    /**
+     * @brief Appends elements to the current array
+     *
+     * @throws std::logic_error if no array of @a T is being written
+     */
+    template <typename T>
+    void write(std::span<const T> elements)
+    {
+      write(detail::binary_element<T>::value, elements.data(), elements.size());
+    }
+
+    /**
+     * @brief Ends the current array, writes the table and the final header and closes the file
+     */
+    void close();
+
+  private:
+    struct Entry
+    {
+      std::string name{};
+      BinaryElement kind = BinaryElement::real;
+      uint32_t elementSize = 0;
+      uint64_t count = 0;
+      uint64_t offset = 0;
+    };
+
+    void beginArray(std::string_view name, BinaryElement kind, size_t elementSize);
+    void write(BinaryElement kind, const void *data, size_t count);
+    void pad();
+    void check();
+
+    std::ofstream file_{};
+    std::string path_{};
+    std::vector<Entry> entries_{};
+    uint64_t position_ = 0;
+    bool open_ = false;
+  };
+
+  /**
+   * @brief Read only memory mapping of a binary container file
+   *
+   * The file is validated when opened. Arrays are returned as spans straight into the
+   * mapping, so they stay valid as long as the file object lives.
+   */
+  class MappedBinaryFile
+  {
+  public:
+    /**
+     * @brief Description of one array of the file
+     */
+    struct ArrayInfo
+    {
+      std::string name{};                       ///< Name given when writing
+      BinaryElement kind = BinaryElement::real; ///< Type of the elements
+      uint64_t count = 0;                       ///< Number of elements
+    };
+
+    /**
+     * @brief Maps @a path and validates its header and table
+     *
+     * @throws std::runtime_error if the file cannot be mapped or is not a valid container
+     */
+    explicit MappedBinaryFile(const std::string &path);
+
+    MappedBinaryFile(MappedBinaryFile &&other) noexcept;
+    MappedBinaryFile &operator=(MappedBinaryFile &&other) noexcept;
+    MappedBinaryFile(const MappedBinaryFile &) = delete;
+    MappedBinaryFile &operator=(const MappedBinaryFile &) = delete;
+
+    ~MappedBinaryFile();
+
+    /**
+     * @return Every array of the file, in the order they were written
+     */
+    const std::vector<ArrayInfo> &arrays() const
+    {
+      return arrays_;
+    }
+
+    /**
+     * @brief Gets an array without copying it
+     *
+     * @throws std::runtime_error if there is no array named @a name or its elements are not @a T
+     */
+    template <typename T>
+    std::span<const T> array(std::string_view name) const
+    {
+      size_t i = find(name, detail::binary_element<T>::value);
+      return std::span<const T>(reinterpret_cast<const T *>(data_ + offsets_[i]), size_t(arrays_[i].count));
+    }
+
+  private:
+    size_t find(std::string_view name, BinaryElement kind) const;
+    void unmap();
+
+    const unsigned char *data_ = nullptr;
+    size_t size_ = 0;
+    std::vector<ArrayInfo> arrays_{};
+    std::vector<uint64_t> offsets_{};
+  };
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace pjmath
+{
+  /**
+   * @brief Blocking first in first out queue of limited capacity, links the stages of a pipeline
+   *
+   * Producers block while the queue is full, so a fast stage cannot run arbitrarily far ahead
+   * of a slow one. Closing the queue wakes every waiting thread: further pushes fail and pops
+   * drain the remaining items before reporting the end.
+   */
+  template <typename T>
+  class BoundedQueue
+  {
+  public:
+    /**
+     * @param capacity Largest number of queued items, at least one
+     */
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity > 0 ? capacity : 1)
+    {
+    }
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    /**
+     * @brief Appends an item, waiting for space if the queue is full
+     *
+     * @return False if the queue was closed, the item is then dropped
+     */
+    bool push(T item)
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      waitFor(not_full_, lock, [this] { return closed_ || items_.size() < capacity_; });
+      if (closed_)
+      {
+        return false;
+      }
+      items_.push_back(std::move(item));
+      lock.unlock();
+      not_empty_.notify_one();
+      return true;
+    }
+
+    /**
+     * @brief Removes the oldest item, waiting for one if the queue is empty
+     *
+     * @return The item, or nothing once the queue is closed and empty
+     */
+    std::optional<T> pop()
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      waitFor(not_empty_, lock, [this] { return closed_ || !items_.empty(); });
+      if (items_.empty())
+      {
+        return std::nullopt;
+      }
+      T item = std::move(items_.front());
+      items_.pop_front();
+      lock.unlock();
+      not_full_.notify_one();
+      return item;
+    }
+
+    /**
+     * @brief Ends the stream, see the class description
+     */
+    void close()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+      }
+      not_full_.notify_all();
+      not_empty_.notify_all();
+    }
+
+  private:
+    /**
+     * @brief Sleeps on @a condition until @a ready holds
+     *
+     * Goes through the steady clock overload with no deadline, which libstdc++ implements
+     * inline, so binaries still load against a libstdc++ older than the compiler's.
+     */
+    template <typename Ready>
+    static void waitFor(std::condition_variable &condition, std::unique_lock<std::mutex> &lock, Ready ready)
+    {
+      condition.wait_until(lock, std::chrono::steady_clock::time_point::max(), ready);
+    }
+
+    std::mutex mutex_{};
+    std::condition_variable not_full_{};  ///< Signalled when an item is popped
+    std::condition_variable not_empty_{}; ///< Signalled when an item is pushed
+    std::deque<T> items_{};
+    size_t capacity_;
+    bool closed_ = false;
+  };
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "aligned.hpp"
+#include "definitions.hpp"
+#include "geometry.hpp"
+#include "soa.hpp"
+#include "vec3.hpp"
+#include "vector.hpp"
+
+namespace pjmath
+{
+  /**
+   * @brief Closest intersection of a ray with a triangle mesh
+   */
+  struct RayHit
+  {
+    static constexpr uint32_t none = std::numeric_limits<uint32_t>::max(); ///< Triangle index of a miss
+
+    uint32_t triangle = none;                           ///< Index of the hit triangle in the mesh
+    real_t t = std::numeric_limits<real_t>::infinity(); ///< Ray parameter of the hit point
+    real_t u = 0;                                       ///< Barycentric weight of the second vertex
+    real_t v = 0;                                       ///< Barycentric weight of the third vertex
+
+    /**
+     * @return True if the ray hit a triangle
+     */
+    bool hit() const
+    {
+      return triangle != none;
+    }
+  };
+
+  /**
+   * @brief Parameters of the surface area heuristic used to build a @ref Bvh
+   */
+  struct BvhBuildOptions
+  {
+    size_t maxLeafSize = 8;           ///< Leaves larger than this are always split
+    size_t binCount = 16;             ///< Number of centroid bins evaluated per axis
+    real_t traversalCost = 1;         ///< Cost of visiting an interior node
+    real_t intersectionCost = 1;      ///< Cost of one ray-triangle test
+    size_t parallelThreshold = 16384; ///< Subtrees with at least this many triangles build on two threads
+  };
+
+  /**
+   * @brief Bounding volume hierarchy over a triangle mesh
+   *
+   * Built top-down with binned surface area heuristic splits, the two halves of large
+   * subtrees building in parallel. Nodes are stored depth first in one array so the first
+   * child of a node directly follows it, and triangles are reordered into leaf order and
+   * stored as structure of arrays of one vertex and two edges, the form Möller–Trumbore
+   * consumes, so a leaf is a short contiguous run of every column.
+   */
+  class Bvh
+  {
+  public:
+    /**
+     * @brief Node of the flattened hierarchy, one cache line with double precision bounds
+     */
+    struct Node
+    {
+      real_t min[3];   ///< Corner of the node bounds with the smallest coordinates
+      real_t max[3];   ///< Corner of the node bounds with the largest coordinates
+      uint32_t offset; ///< First triangle of a leaf, or index of the second child of an interior node
+      uint32_t count;  ///< Number of triangles of a leaf, zero for an interior node
+      uint32_t axis;   ///< Axis the children of an interior node were split along
+
+      /**
+       * @return True if the node holds triangles rather than children
+       */
+      bool isLeaf() const
+      {
+        return count != 0;
+      }
+    };
+
+    /**
+     * @brief Number of rays traversed together by the batch @ref intersect
+     */
+    static constexpr size_t packet_size = 8;
+
+    /**
+     * @brief Splits deeper than this use the object median, bounding the traversal stack
+     */
+    static constexpr size_t max_sah_depth = 64;
+
+    /**
+     * @brief Constructs an empty hierarchy which no ray hits
+     */
+    Bvh() = default;
+
+    /**
+     * @brief Builds the hierarchy of an indexed triangle mesh
+     *
+     * @param vertices Vertex positions
+     * @param indices Three vertex indices per triangle
+     * @param options Build parameters
+     * @throws std::invalid_argument if the number of indices is not a multiple of three
+     * @throws std::out_of_range if an index does not name a vertex
+     */
+    Bvh(std::span<const Vector3> vertices, std::span<const uint32_t> indices, const BvhBuildOptions &options = {})
+    {
+      build(detail::coordinates(vertices), vertices.size(), indices, options);
+    }
+
+    /**
+     * @copydoc Bvh(std::span<const Vector3>, std::span<const uint32_t>, const BvhBuildOptions &)
+     */
+    Bvh(std::span<const Vec3> vertices, std::span<const uint32_t> indices, const BvhBuildOptions &options = {})
+    {
+      build(detail::coordinates(vertices), vertices.size(), indices, options);
+    }
+
+    /**
+     * @brief Updates the hierarchy after the vertices moved, keeping its topology
+     *
+     * Much cheaper than a rebuild, but traversal slows down as the deformation drifts away
+     * from the pose the hierarchy was built for.
+     *
+     * @param vertices New vertex positions, as many as the hierarchy was built with
+     * @throws std::invalid_argument if the number of vertices changed
+     */
+    void refit(std::span<const Vector3> vertices)
+    {
+      refit(detail::coordinates(vertices), vertices.size());
+    }
+
+    /**
+     * @copydoc refit(std::span<const Vector3>)
+     */
+    void refit(std::span<const Vec3> vertices)
+    {
+      refit(detail::coordinates(vertices), vertices.size());
+    }
+
+    /**
+     * @brief Finds the closest triangle hit by a ray
+     *
+     * Triangles are two sided.
+     *
+     * @param ray Ray to trace
+     * @return The closest hit with a ray parameter in [ray.tMin, ray.tMax), or a miss
+     */
+    RayHit intersect(const Ray &ray) const;
+
+    /**
+     * @brief Finds the closest triangle hit by every ray
+     *
+     * Consecutive rays are traversed as packets of @ref packet_size, sharing node visits,
+     * and packets are spread across threads. Packets of rays with similar origins and
+     * directions, such as neighbouring camera rays, visit the fewest nodes.
+     *
+     * @param rays Rays to trace
+     * @param hits Receives the hit of each ray, as @ref intersect(const Ray &) const would
+     * @throws std::invalid_argument if the sizes of @a rays and @a hits differ
+     */
+    void intersect(std::span<const Ray> rays, std::span<RayHit> hits) const;
+
+    /**
+     * @return Bounds of the whole mesh
+     */
+    Aabb bounds() const;
+
+    /**
+     * @return Nodes in depth first order, the root first
+     */
+    std::span<const Node> nodes() const
+    {
+      return nodes_;
+    }
+
+    /**
+     * @return Number of triangles in the mesh
+     */
+    size_t triangleCount() const
+    {
+      return triangles_.size();
+    }
+
+  private:
+    void build(const real_t *vertices, size_t vertexCount, std::span<const uint32_t> indices,
+               const BvhBuildOptions &options);
+    void refit(const real_t *vertices, size_t vertexCount);
+    void storeTriangles(const real_t *vertices);
+
+    std::vector<Node> nodes_{};
+    std::vector<uint32_t> indices_{};
+    AlignedVector<uint32_t> triangles_{};
+    SoAVec3Array v0_{};
+    SoAVec3Array e1_{};
+    SoAVec3Array e2_{};
+    size_t vertexCount_ = 0;
+  };
+}
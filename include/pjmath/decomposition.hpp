@@ -0,0 +1,734 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "mat.hpp"
+
+/**
+ * Matrix decompositions and linear solvers.
+ *
+ * The fixed-size decompositions unroll every loop at compile time for matrices of order up
+ * to @ref detail::unroll_limit, so solving a small system compiles to straight-line code with
+ * no loop overhead. Larger matrices use ordinary loops, and LU switches to a blocked
+ * factorization over runtime-sized arrays, which is also available directly through
+ * @ref luFactor and @ref luSolve. Solvers substitute through the factors and never form an
+ * inverse.
+ */
+namespace pjmath
+{
+  namespace detail
+  {
+    /**
+     * @brief Largest matrix order whose decomposition loops are unrolled
+     */
+    constexpr size_t unroll_limit = 8;
+
+    template <size_t V>
+    using Index = std::integral_constant<size_t, V>;
+
+    /**
+     * @return @a V as a compile-time constant if loops are unrolled, or as a runtime index
+     */
+    template <bool Unroll, size_t V>
+    constexpr auto index()
+    {
+      if constexpr (Unroll)
+      {
+        return Index<V>{};
+      }
+      else
+      {
+        return V;
+      }
+    }
+
+    template <size_t V>
+    constexpr Index<V + 1> next(Index<V>)
+    {
+      return {};
+    }
+
+    constexpr size_t next(size_t i)
+    {
+      return i + 1;
+    }
+
+    /**
+     * @brief Calls @a f for every index in [Begin, End), unrolled at compile time
+     */
+    template <size_t Begin, size_t End, typename F>
+    void forRange(Index<Begin>, Index<End>, F &&f)
+    {
+      if constexpr (Begin < End)
+      {
+        [&]<size_t... I>(std::index_sequence<I...>)
+        {
+          (f(Index<Begin + I>{}), ...);
+        }(std::make_index_sequence<End - Begin>{});
+      }
+    }
+
+    /**
+     * @brief Calls @a f for every index in [@a begin, @a end)
+     */
+    template <typename F>
+    void forRange(size_t begin, size_t end, F &&f)
+    {
+      for (size_t i = begin; i < end; i++)
+      {
+        f(i);
+      }
+    }
+
+    /**
+     * @brief Calls @a f for every index in [Begin, End) from the last to the first, unrolled at compile time
+     */
+    template <size_t Begin, size_t End, typename F>
+    void forRangeReverse(Index<Begin>, Index<End>, F &&f)
+    {
+      if constexpr (Begin < End)
+      {
+        [&]<size_t... I>(std::index_sequence<I...>)
+        {
+          (f(Index<End - 1 - I>{}), ...);
+        }(std::make_index_sequence<End - Begin>{});
+      }
+    }
+
+    /**
+     * @brief Calls @a f for every index in [@a begin, @a end) from the last to the first
+     */
+    template <typename F>
+    void forRangeReverse(size_t begin, size_t end, F &&f)
+    {
+      for (size_t i = end; i-- > begin;)
+      {
+        f(i);
+      }
+    }
+
+    inline void checkNonSingular(bool singular)
+    {
+      if (singular)
+      {
+        throw std::invalid_argument("matrix is singular");
+      }
+    }
+  }
+
+  /**
+   * @brief Columns of a panel factored at a time by the blocked LU
+   */
+  constexpr size_t lu_block_size = 32;
+
+  /**
+   * @brief Factors a square row-major matrix in place as P A = L U, with partial pivoting
+   *
+   * Blocked right-looking factorization: each panel of @ref lu_block_size columns is factored
+   * on its own, then the trailing matrix is updated by one matrix product whose inner loop
+   * runs along contiguous rows.
+   *
+   * @param a Matrix of order @a n, replaced by U on and above the diagonal and by the unit
+   *        lower triangular L below it
+   * @param n Order of the matrix
+   * @param pivots Receives @a n row swaps, row k was swapped with row pivots[k] at step k
+   * @return False if the matrix is singular, the factors are then incomplete
+   * @throws std::invalid_argument if the spans are too small for a matrix of order @a n
+   */
+  template <typename E>
+  bool luFactor(std::span<E> a, size_t n, std::span<size_t> pivots)
+  {
+    static_assert(std::is_floating_point_v<E>);
+    if (a.size() < n * n || pivots.size() < n)
+    {
+      throw std::invalid_argument("matrix storage is too small");
+    }
+
+    bool regular = true;
+    for (size_t k0 = 0; k0 < n; k0 += lu_block_size)
+    {
+      size_t k1 = std::min(k0 + lu_block_size, n);
+
+      // Factor the panel of columns [k0, k1), swapping whole rows
+      for (size_t k = k0; k < k1; k++)
+      {
+        size_t p = k;
+        for (size_t i = k + 1; i < n; i++)
+        {
+          if (std::fabs(a[i * n + k]) > std::fabs(a[p * n + k]))
+          {
+            p = i;
+          }
+        }
+        pivots[k] = p;
+        if (p != k)
+        {
+          std::swap_ranges(&a[k * n], &a[k * n] + n, &a[p * n]);
+        }
+        if (a[k * n + k] == 0)
+        {
+          regular = false;
+          continue;
+        }
+
+        E inverse = 1 / a[k * n + k];
+        for (size_t i = k + 1; i < n; i++)
+        {
+          E l = a[i * n + k] *= inverse;
+          for (size_t j = k + 1; j < k1; j++)
+          {
+            a[i * n + j] -= l * a[k * n + j];
+          }
+        }
+      }
+
+      // U12 = L11^-1 A12
+      for (size_t k = k0; k < k1; k++)
+      {
+        for (size_t i = k + 1; i < k1; i++)
+        {
+          E l = a[i * n + k];
+          for (size_t j = k1; j < n; j++)
+          {
+            a[i * n + j] -= l * a[k * n + j];
+          }
+        }
+      }
+
+      // A22 -= L21 U12
+      for (size_t i = k1; i < n; i++)
+      {
+        for (size_t k = k0; k < k1; k++)
+        {
+          E l = a[i * n + k];
+          for (size_t j = k1; j < n; j++)
+          {
+            a[i * n + j] -= l * a[k * n + j];
+          }
+        }
+      }
+    }
+    return regular;
+  }
+
+  /**
+   * @brief Solves A X = B in place using the factors computed by @ref luFactor
+   *
+   * @param lu Factors of A
+   * @param n Order of A
+   * @param pivots Row swaps computed by @ref luFactor
+   * @param b Row-major n by @a columns right hand side, replaced by the solution
+   * @param columns Number of right hand side columns
+   * @throws std::invalid_argument if the spans are too small
+   */
+  template <typename E>
+  void luSolve(std::span<const E> lu, size_t n, std::span<const size_t> pivots, std::span<E> b, size_t columns)
+  {
+    if (lu.size() < n * n || pivots.size() < n || b.size() < n * columns)
+    {
+      throw std::invalid_argument("matrix storage is too small");
+    }
+
+    for (size_t k = 0; k < n; k++)
+    {
+      if (pivots[k] != k)
+      {
+        std::swap_ranges(&b[k * columns], &b[k * columns] + columns, &b[pivots[k] * columns]);
+      }
+    }
+    for (size_t k = 0; k < n; k++)
+    {
+      for (size_t i = k + 1; i < n; i++)
+      {
+        E l = lu[i * n + k];
+        for (size_t j = 0; j < columns; j++)
+        {
+          b[i * columns + j] -= l * b[k * columns + j];
+        }
+      }
+    }
+    for (size_t k = n; k-- > 0;)
+    {
+      E pivot = lu[k * n + k];
+      for (size_t j = 0; j < columns; j++)
+      {
+        b[k * columns + j] /= pivot;
+      }
+      for (size_t i = 0; i < k; i++)
+      {
+        E u = lu[i * n + k];
+        for (size_t j = 0; j < columns; j++)
+        {
+          b[i * columns + j] -= u * b[k * columns + j];
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief LU decomposition with partial pivoting, P A = L U
+   *
+   * @tparam E Element type, floating point
+   * @tparam N Order of the matrix
+   */
+  template <typename E, size_t N>
+  class Lu
+  {
+    static constexpr bool unroll = N <= detail::unroll_limit;
+
+  public:
+    static_assert(std::is_floating_point_v<E>);
+
+    /**
+     * @brief Factors @a a
+     */
+    template <typename D>
+    explicit Lu(const Mat<E, N, N, D> &a) : lu_(a)
+    {
+      if constexpr (unroll)
+      {
+        factor();
+      }
+      else
+      {
+        singular_ = !luFactor(std::span<E>(lu_), N, std::span<size_t>(pivots_));
+        for (size_t k = 0; k < N; k++)
+        {
+          sign_ = pivots_[k] != k ? -sign_ : sign_;
+        }
+      }
+    }
+
+    /**
+     * @return True if a pivot was exactly zero, the matrix then has no inverse
+     */
+    bool isSingular() const
+    {
+      return singular_;
+    }
+
+    /**
+     * @return The determinant of the factored matrix
+     */
+    E determinant() const
+    {
+      E product = E(sign_);
+      for (size_t k = 0; k < N; k++)
+      {
+        product *= lu_[k * N + k];
+      }
+      return product;
+    }
+
+    /**
+     * @brief Solves A X = B
+     *
+     * @param b Right hand side, one system per column
+     * @return The solution X, of the same type as @a b
+     * @throws std::invalid_argument if the matrix is singular
+     */
+    template <size_t K, typename D>
+    typename Mat<E, N, K, D>::Self solve(const Mat<E, N, K, D> &b) const
+    {
+      detail::checkNonSingular(singular_);
+      typename Mat<E, N, K, D>::Self x;
+      E *xs = x.data();
+      std::copy(b.begin(), b.end(), xs);
+      const E *m = lu_.data();
+      auto zero = detail::index<unroll, 0>();
+      auto n = detail::index<unroll, N>();
+      auto k0 = detail::index<K <= detail::unroll_limit, 0>();
+      auto columns = detail::index<K <= detail::unroll_limit, K>();
+
+      detail::forRange(zero, n, [&](auto k) {
+        if (pivots_[k] != k)
+        {
+          detail::forRange(k0, columns, [&](auto j) { std::swap(xs[k * K + j], xs[pivots_[k] * K + j]); });
+        }
+      });
+      detail::forRange(zero, n, [&](auto k) {
+        detail::forRange(detail::next(k), n, [&](auto i) {
+          E l = m[i * N + k];
+          detail::forRange(k0, columns, [&](auto j) { xs[i * K + j] -= l * xs[k * K + j]; });
+        });
+      });
+      detail::forRangeReverse(zero, n, [&](auto k) {
+        E pivot = m[k * N + k];
+        detail::forRange(k0, columns, [&](auto j) { xs[k * K + j] /= pivot; });
+        detail::forRange(zero, k, [&](auto i) {
+          E u = m[i * N + k];
+          detail::forRange(k0, columns, [&](auto j) { xs[i * K + j] -= u * xs[k * K + j]; });
+        });
+      });
+      return x;
+    }
+
+    /**
+     * @return U on and above the diagonal and the unit lower triangular L below it
+     */
+    const Mat<E, N, N> &packed() const
+    {
+      return lu_;
+    }
+
+    /**
+     * @return Row swaps, row k was swapped with row pivots()[k] at step k
+     */
+    const std::array<size_t, N> &pivots() const
+    {
+      return pivots_;
+    }
+
+  private:
+    void factor()
+    {
+      E *m = lu_.data();
+      auto n = detail::index<unroll, N>();
+      detail::forRange(detail::index<unroll, 0>(), n, [&](auto k) {
+        size_t p = k;
+        detail::forRange(detail::next(k), n, [&](auto i) {
+          if (std::fabs(m[i * N + k]) > std::fabs(m[p * N + k]))
+          {
+            p = i;
+          }
+        });
+        pivots_[k] = p;
+        if (p != k)
+        {
+          sign_ = -sign_;
+          detail::forRange(detail::index<unroll, 0>(), n, [&](auto j) { std::swap(m[k * N + j], m[p * N + j]); });
+        }
+        if (m[k * N + k] == 0)
+        {
+          singular_ = true;
+          return;
+        }
+
+        E inverse = 1 / m[k * N + k];
+        detail::forRange(detail::next(k), n, [&](auto i) {
+          E l = m[i * N + k] *= inverse;
+          detail::forRange(detail::next(k), n, [&](auto j) { m[i * N + j] -= l * m[k * N + j]; });
+        });
+      });
+    }
+
+    Mat<E, N, N> lu_;
+    std::array<size_t, N> pivots_{};
+    int sign_ = 1;
+    bool singular_ = false;
+  };
+
+  template <typename E, size_t N, typename D>
+  Lu(const Mat<E, N, N, D> &) -> Lu<E, N>;
+
+  /**
+   * @brief Cholesky decomposition of a symmetric positive definite matrix, A = L Lᵀ
+   *
+   * Only the lower triangle of the matrix is read.
+   *
+   * @tparam E Element type, floating point
+   * @tparam N Order of the matrix
+   */
+  template <typename E, size_t N>
+  class Cholesky
+  {
+    static constexpr bool unroll = N <= detail::unroll_limit;
+
+  public:
+    static_assert(std::is_floating_point_v<E>);
+
+    /**
+     * @brief Factors @a a
+     */
+    template <typename D>
+    explicit Cholesky(const Mat<E, N, N, D> &a) : l_(a)
+    {
+      E *m = l_.data();
+      auto zero = detail::index<unroll, 0>();
+      auto n = detail::index<unroll, N>();
+      detail::forRange(zero, n, [&](auto j) {
+        if (!positive_)
+        {
+          return;
+        }
+        E diagonal = m[j * N + j];
+        detail::forRange(zero, j, [&](auto k) { diagonal -= m[j * N + k] * m[j * N + k]; });
+        if (!(diagonal > 0))
+        {
+          positive_ = false;
+          return;
+        }
+        E root = std::sqrt(diagonal);
+        m[j * N + j] = root;
+        detail::forRange(detail::next(j), n, [&](auto i) {
+          E sum = m[i * N + j];
+          detail::forRange(zero, j, [&](auto k) { sum -= m[i * N + k] * m[j * N + k]; });
+          m[i * N + j] = sum / root;
+        });
+      });
+    }
+
+    /**
+     * @return False if the matrix was not positive definite, the factor is then incomplete
+     */
+    bool isPositiveDefinite() const
+    {
+      return positive_;
+    }
+
+    /**
+     * @return The lower triangular factor L
+     */
+    Mat<E, N, N> lower() const
+    {
+      Mat<E, N, N> l = l_;
+      for (size_t i = 0; i < N; i++)
+      {
+        for (size_t j = i + 1; j < N; j++)
+        {
+          l[i * N + j] = 0;
+        }
+      }
+      return l;
+    }
+
+    /**
+     * @brief Solves A X = B
+     *
+     * @param b Right hand side, one system per column
+     * @return The solution X, of the same type as @a b
+     * @throws std::invalid_argument if the matrix is not positive definite
+     */
+    template <size_t K, typename D>
+    typename Mat<E, N, K, D>::Self solve(const Mat<E, N, K, D> &b) const
+    {
+      if (!positive_)
+      {
+        throw std::invalid_argument("matrix is not positive definite");
+      }
+      typename Mat<E, N, K, D>::Self x;
+      E *xs = x.data();
+      std::copy(b.begin(), b.end(), xs);
+      const E *m = l_.data();
+      auto zero = detail::index<unroll, 0>();
+      auto n = detail::index<unroll, N>();
+      auto k0 = detail::index<K <= detail::unroll_limit, 0>();
+      auto columns = detail::index<K <= detail::unroll_limit, K>();
+
+      detail::forRange(zero, n, [&](auto k) {
+        E diagonal = m[k * N + k];
+        detail::forRange(k0, columns, [&](auto j) { xs[k * K + j] /= diagonal; });
+        detail::forRange(detail::next(k), n, [&](auto i) {
+          E l = m[i * N + k];
+          detail::forRange(k0, columns, [&](auto j) { xs[i * K + j] -= l * xs[k * K + j]; });
+        });
+      });
+      detail::forRangeReverse(zero, n, [&](auto k) {
+        E diagonal = m[k * N + k];
+        detail::forRange(k0, columns, [&](auto j) { xs[k * K + j] /= diagonal; });
+        detail::forRange(zero, k, [&](auto i) {
+          E l = m[k * N + i];
+          detail::forRange(k0, columns, [&](auto j) { xs[i * K + j] -= l * xs[k * K + j]; });
+        });
+      });
+      return x;
+    }
+
+  private:
+    Mat<E, N, N> l_;
+    bool positive_ = true;
+  };
+
+  template <typename E, size_t N, typename D>
+  Cholesky(const Mat<E, N, N, D> &) -> Cholesky<E, N>;
+
+  /**
+   * @brief Householder QR decomposition, A = Q R, of a matrix with at least as many rows as columns
+   *
+   * @tparam E Element type, floating point
+   * @tparam M Number of rows
+   * @tparam N Number of columns
+   */
+  template <typename E, size_t M, size_t N>
+  class Qr
+  {
+    static constexpr bool unroll = M <= detail::unroll_limit;
+
+  public:
+    static_assert(std::is_floating_point_v<E>);
+    static_assert(M >= N);
+
+    /**
+     * @brief Factors @a a
+     */
+    template <typename D>
+    explicit Qr(const Mat<E, M, N, D> &a) : qr_(a)
+    {
+      E *m = qr_.data();
+      auto zero = detail::index<unroll, 0>();
+      auto rows = detail::index<unroll, M>();
+      auto columns = detail::index<unroll, N>();
+      detail::forRange(zero, columns, [&](auto k) {
+        // Reflector v with v[k] = 1 mapping column k below the diagonal onto beta e_k
+        E x0 = m[k * N + k];
+        E norm = x0 * x0;
+        detail::forRange(detail::next(k), rows, [&](auto i) { norm += m[i * N + k] * m[i * N + k]; });
+        norm = std::sqrt(norm);
+        if (norm == 0)
+        {
+          tau_[k] = 0;
+          return;
+        }
+        E beta = -std::copysign(norm, x0);
+        tau_[k] = (beta - x0) / beta;
+        E scale = 1 / (x0 - beta);
+        detail::forRange(detail::next(k), rows, [&](auto i) { m[i * N + k] *= scale; });
+        m[k * N + k] = beta;
+
+        // Apply I - tau v vᵀ to the remaining columns
+        detail::forRange(detail::next(k), columns, [&](auto j) {
+          E w = m[k * N + j];
+          detail::forRange(detail::next(k), rows, [&](auto i) { w += m[i * N + k] * m[i * N + j]; });
+          w *= tau_[k];
+          m[k * N + j] -= w;
+          detail::forRange(detail::next(k), rows, [&](auto i) { m[i * N + j] -= m[i * N + k] * w; });
+        });
+      });
+    }
+
+    /**
+     * @return True if a diagonal element of R is exactly zero, the columns are then linearly dependent
+     */
+    bool isRankDeficient() const
+    {
+      for (size_t k = 0; k < N; k++)
+      {
+        if (qr_[k * N + k] == 0)
+        {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /**
+     * @return The upper triangular factor R
+     */
+    Mat<E, N, N> r() const
+    {
+      Mat<E, N, N> r;
+      for (size_t i = 0; i < N; i++)
+      {
+        for (size_t j = i; j < N; j++)
+        {
+          r[i * N + j] = qr_[i * N + j];
+        }
+      }
+      return r;
+    }
+
+    /**
+     * @return The first N columns of the orthogonal factor Q
+     */
+    Mat<E, M, N> q() const
+    {
+      Mat<E, M, N> q;
+      for (size_t k = 0; k < N; k++)
+      {
+        q[k * N + k] = 1;
+      }
+      for (size_t k = N; k-- > 0;)
+      {
+        for (size_t j = 0; j < N; j++)
+        {
+          E w = q[k * N + j];
+          for (size_t i = k + 1; i < M; i++)
+          {
+            w += qr_[i * N + k] * q[i * N + j];
+          }
+          w *= tau_[k];
+          q[k * N + j] -= w;
+          for (size_t i = k + 1; i < M; i++)
+          {
+            q[i * N + j] -= qr_[i * N + k] * w;
+          }
+        }
+      }
+      return q;
+    }
+
+    /**
+     * @brief Solves A X = B in the least squares sense
+     *
+     * @param b Right hand side, one system per column
+     * @return The X minimizing the norm of A X - B, exact when A is square and regular
+     * @throws std::invalid_argument if the matrix is rank deficient
+     */
+    template <size_t K, typename D>
+    Mat<E, N, K> solve(const Mat<E, M, K, D> &b) const
+    {
+      detail::checkNonSingular(isRankDeficient());
+      Mat<E, M, K> y = b;
+      E *ys = y.data();
+      const E *m = qr_.data();
+      auto zero = detail::index<unroll, 0>();
+      auto rows = detail::index<unroll, M>();
+      auto n = detail::index<unroll, N>();
+      auto k0 = detail::index<K <= detail::unroll_limit, 0>();
+      auto columns = detail::index<K <= detail::unroll_limit, K>();
+
+      // y = Qᵀ b
+      detail::forRange(zero, n, [&](auto k) {
+        detail::forRange(k0, columns, [&](auto j) {
+          E w = ys[k * K + j];
+          detail::forRange(detail::next(k), rows, [&](auto i) { w += m[i * N + k] * ys[i * K + j]; });
+          w *= tau_[k];
+          ys[k * K + j] -= w;
+          detail::forRange(detail::next(k), rows, [&](auto i) { ys[i * K + j] -= m[i * N + k] * w; });
+        });
+      });
+
+      // R x = y
+      Mat<E, N, K> x;
+      E *xs = x.data();
+      std::copy(ys, ys + N * K, xs);
+      detail::forRangeReverse(zero, n, [&](auto k) {
+        E diagonal = m[k * N + k];
+        detail::forRange(k0, columns, [&](auto j) { xs[k * K + j] /= diagonal; });
+        detail::forRange(zero, k, [&](auto i) {
+          E u = m[i * N + k];
+          detail::forRange(k0, columns, [&](auto j) { xs[i * K + j] -= u * xs[k * K + j]; });
+        });
+      });
+      return x;
+    }
+
+  private:
+    Mat<E, M, N> qr_;
+    std::array<E, N> tau_{};
+  };
+
+  template <typename E, size_t M, size_t N, typename D>
+  Qr(const Mat<E, M, N, D> &) -> Qr<E, M, N>;
+
+  /**
+   * @brief Solves the square system A X = B by LU decomposition with partial pivoting
+   *
+   * @param a Coefficient matrix
+   * @param b Right hand side, one system per column
+   * @return The solution X, of the same type as @a b
+   * @throws std::invalid_argument if @a a is singular
+   */
+  template <typename E, size_t N, typename DA, size_t K, typename DB>
+  typename Mat<E, N, K, DB>::Self solve(const Mat<E, N, N, DA> &a, const Mat<E, N, K, DB> &b)
+  {
+    return Lu<E, N>(a).solve(b);
+  }
+}
@@ -8,4 +8,24 @@ namespace pjmath
 {
   constexpr real_t CMP_EPSILON = 0.00001;
   constexpr real_t PI = 3.14159265f;
+
+  /**
+   * @brief Accuracy mode for sums and dot products
+   */
+  enum class Summation
+  {
+    fast,         ///< Several independent accumulators so the loop vectorizes, error grows linearly with length
+    pairwise,     ///< Recursive halving over vectorized blocks, error grows with the logarithm of the length
+    kahan,        ///< Compensated (Neumaier) summation, error is independent of length
+    reproducible, ///< Fixed-size blocks combined by a fixed pairwise tree, the same bits for any thread count or instruction set level
+  };
+
+  /**
+   * @brief Accuracy mode for batch normalization
+   */
+  enum class NormalizeMode
+  {
+    exact, ///< Square root and one division per vector, length within 2 ulp of one
+    fast,  ///< Hardware reciprocal square root estimate refined by Newton's method, length within 2.5e-7 of one
+  };
 } // namespace pjmath
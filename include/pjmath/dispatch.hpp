@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "definitions.hpp"
+
+/**
+ * Kernels compiled for several instruction set levels and picked at run time.
+ *
+ * The library is built for the baseline x86-64 target, plus one copy of each kernel for
+ * SSE4.2, AVX2 with FMA and F16C, and AVX-512. The best level the processor supports is
+ * chosen on first use. Every level performs the same operations in the same order, without
+ * contracting them into fused multiply-adds, so results do not depend on the host.
+ *
+ * Setting the `PJMATH_ISA` environment variable to `baseline`, `sse4.2`, `avx2` or
+ * `avx512` caps the level chosen at startup, for testing the fallbacks on a newer host.
+ *
+ * Only the functions below are dispatched: the batch functions of batch.hpp built on them,
+ * the half conversions of packed.hpp and the eigen-solver's sines and cosines. Templates
+ * defined in headers, such as `Mat::sum`, `Vector::Dot`, `kernels::normalize` in fast mode
+ * and the operations of soa.hpp, are compiled for whatever target the including code is
+ * built for.
+ */
+namespace pjmath
+{
+  /**
+   * @brief Instruction set levels the kernels are compiled for, in increasing order
+   */
+  enum class Isa
+  {
+    baseline, ///< Whatever the library is built for, SSE2 on x86-64
+    sse42,    ///< SSE4.2 and POPCNT
+    avx2,     ///< AVX2, FMA and F16C
+    avx512,   ///< AVX-512 F, DQ, VL and BW, on top of avx2
+  };
+
+  /**
+   * @return The name of @a isa, as accepted by `PJMATH_ISA`
+   */
+  const char *isaName(Isa isa);
+
+  /**
+   * @return Whether the kernels of @a isa were built and the processor can run them
+   */
+  bool isaSupported(Isa isa);
+
+  /**
+   * @return The level the kernels currently run at
+   */
+  Isa activeIsa();
+
+  /**
+   * @brief Switches every kernel to @a isa
+   *
+   * Meant for tests and benchmarks, not safe while kernels are running on other threads.
+   *
+   * @throws std::invalid_argument If @a isa is not supported
+   */
+  void setIsa(Isa isa);
+
+  namespace dispatch
+  {
+    /**
+     * @brief Transforms @a count packed xyz points by a row-major 4x4 matrix, see @ref transformPoints
+     *
+     * @a points and @a out may be the same array.
+     */
+    void transformPoints(const real_t *m, const real_t *points, real_t *out, size_t count);
+
+    /**
+     * @brief Computes @a out[i] = @a a[i] * @a b[i] for @a count packed row-major 4x4 matrices
+     *
+     * @a out may be the same array as @a a or @a b.
+     */
+    void multiply4x4(const real_t *a, const real_t *b, real_t *out, size_t count);
+
+    /**
+     * @brief Computes the sine and cosine of @a n values
+     *
+     * Within 2 ulp of `std::sin` and `std::cos`. Outputs may not alias @a x.
+     */
+    void sinCos(const real_t *x, real_t *sines, real_t *cosines, size_t n);
+
+    /**
+     * @brief Sums @a n values, as `kernels::sum` does in fast mode
+     */
+    real_t sum(const real_t *x, size_t n);
+
+    /**
+     * @brief Dot product of @a n values, with the accumulators of `kernels::dot` in fast mode
+     *
+     * Every product is rounded before it is added, never fused, so the result can differ
+     * from `kernels::dot` when the including code is built with `FP_FAST_FMA` defined.
+     */
+    real_t dot(const real_t *a, const real_t *b, size_t n);
+
+    /**
+     * @brief Sums @a n values in parallel, as `kernels::sum` does in reproducible mode
+     *
+     * Blocks are summed on any thread and combined by a tree fixed by @a n, so the result
+     * has the same bits for every executor, thread count and instruction set level.
+     */
+    real_t reproducibleSum(const real_t *x, size_t n);
+
+    /**
+     * @brief Dot product of @a n values in parallel, as `kernels::dot` does in reproducible mode
+     *
+     * Same bits for every executor, thread count and instruction set level.
+     */
+    real_t reproducibleDot(const real_t *a, const real_t *b, size_t n);
+
+    /**
+     * @brief Normalizes @a count packed xyz vectors in place, zero vectors are left unchanged
+     */
+    void normalize3(real_t *xyz, size_t count);
+
+    /**
+     * @brief Rounds @a n values to half precision and stores their binary16 encodings
+     *
+     * Uses the F16C conversion instructions from the avx2 level up, which round the same way
+     * as the portable conversion of the lower levels.
+     */
+    void encodeHalf(const real_t *values, uint16_t *bits, size_t n);
+
+    /**
+     * @brief Expands @a n binary16 encodings, exactly
+     */
+    void decodeHalf(const uint16_t *bits, real_t *values, size_t n);
+  }
+}
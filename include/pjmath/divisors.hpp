@@ -1,5 +1,6 @@
 
 #include "definitions.hpp"
+#include "instrument.hpp"
 
 #include <set>
 #include <cstdint>
@@ -10,6 +11,7 @@ namespace pjmath
   std::set<Integer> properDivisorsOf(Integer number)
   {
     static_assert(std::is_integral_v<Integer>);
+    PJMATH_COUNT(divisors);
     std::set<Integer> divisors;
 
     for (Integer possibleDivisor = 2; possibleDivisor < number; possibleDivisor++)
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+
+#include "definitions.hpp"
+#include "mat3.hpp"
+#include "soa.hpp"
+#include "vec3.hpp"
+
+namespace pjmath
+{
+  /**
+   * @brief Eigen-decomposition of a symmetric 3x3 matrix, A = V diag(values) Vᵀ
+   */
+  struct SymmetricEigen
+  {
+    Vec3 values;  ///< Eigenvalues in ascending order
+    Mat3 vectors; ///< Orthonormal eigenvectors as columns, in the order of @ref values, with determinant +1
+  };
+
+  /**
+   * @brief Symmetric 3x3 matrices stored as structure of arrays
+   *
+   * The six columns hold the xx, yy, zz, xy, xz and yz elements of every matrix.
+   */
+  using SymmetricMat3Array = SoAVecArray<6>;
+
+  /**
+   * @brief Relative eigenvalue gap below which @ref symmetricEigen falls back to Jacobi rotations
+   *
+   * Closed-form eigenvalues lose accuracy as two of them merge, and the eigenvectors computed
+   * from them lose it quadratically, so pairs closer than this fraction of the largest matrix
+   * element are resolved iteratively instead.
+   */
+  constexpr real_t eigen_degenerate_gap = 1e-3;
+
+  /**
+   * @brief Decomposes a symmetric matrix in closed form
+   *
+   * Eigenvalues come from the trigonometric solution of the characteristic cubic and
+   * eigenvectors from cross products of the rows of A - λI. Nearly repeated eigenvalues,
+   * see @ref eigen_degenerate_gap, fall back to @ref symmetricEigenJacobi.
+   *
+   * @param a Symmetric matrix, only the upper triangle is read
+   * @return Eigenvalues and eigenvectors of @a a
+   */
+  SymmetricEigen symmetricEigen(const Mat3 &a);
+
+  /**
+   * @brief Decomposes a symmetric matrix with cyclic Jacobi rotations
+   *
+   * Slower than @ref symmetricEigen but accurate for any spacing of the eigenvalues.
+   *
+   * @param a Symmetric matrix, only the upper triangle is read
+   * @param maxSweeps Largest number of sweeps over the three off-diagonal elements
+   * @return Eigenvalues and eigenvectors of @a a
+   */
+  SymmetricEigen symmetricEigenJacobi(const Mat3 &a, size_t maxSweeps = 16);
+
+  /**
+   * @brief Decomposes every matrix of an array in closed form, see @ref symmetricEigen(const Mat3 &)
+   *
+   * Matrices are processed in blocks of columns spread across threads. Each stage runs over a
+   * whole block with selects instead of branches, so it vectorizes, and only matrices with
+   * nearly repeated eigenvalues fall back to Jacobi rotations one at a time. Results have the
+   * same bits as decomposing each matrix on its own.
+   *
+   * @param matrices Matrices to decompose
+   * @param values Resized to hold the ascending eigenvalues of each matrix
+   * @param vectors Resized to hold the eigenvectors of each matrix, as the nine row-major
+   *        elements of a matrix whose columns are the eigenvectors
+   */
+  void symmetricEigen(const SymmetricMat3Array &matrices, SoAVec3Array &values, SoAVecArray<9> &vectors);
+}
@@ -0,0 +1,557 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+
+#include "aligned.hpp"
+#include "definitions.hpp"
+#include "mat3.hpp"
+#include "mat4.hpp"
+#include "soa.hpp"
+#include "vec3.hpp"
+#include "vec4.hpp"
+
+namespace pjmath
+{
+  /**
+   * @brief Axis aligned bounding box
+   */
+  struct Aabb
+  {
+    Vec3 min; ///< Corner with the smallest coordinates
+    Vec3 max; ///< Corner with the largest coordinates
+
+    /**
+     * @brief Constructs a box which contains nothing, expanding it by a point yields that point
+     */
+    static Aabb empty()
+    {
+      constexpr real_t inf = std::numeric_limits<real_t>::infinity();
+      return Aabb{Vec3{inf, inf, inf}, Vec3{-inf, -inf, -inf}};
+    }
+
+    /**
+     * @brief Constructs a box from its center and half extents
+     */
+    static Aabb fromCenterExtent(const Vec3 &center, const Vec3 &extent)
+    {
+      return Aabb{center - extent, center + extent};
+    }
+
+    /**
+     * @return True if the box contains no point
+     */
+    bool isEmpty() const
+    {
+      return min.x() > max.x() || min.y() > max.y() || min.z() > max.z();
+    }
+
+    /**
+     * @return The center of the box
+     */
+    Vec3 center() const
+    {
+      return (min + max) * 0.5;
+    }
+
+    /**
+     * @return Half the size of the box along each axis
+     */
+    Vec3 extent() const
+    {
+      return (max - min) * 0.5;
+    }
+
+    /**
+     * @brief Grows the box to contain @a point
+     */
+    void expand(const Vec3 &point)
+    {
+      for (size_t k = 0; k < 3; k++)
+      {
+        min.at(k) = std::fmin(min.at(k), point.at(k));
+        max.at(k) = std::fmax(max.at(k), point.at(k));
+      }
+    }
+
+    /**
+     * @brief Grows the box to contain @a box
+     */
+    void expand(const Aabb &box)
+    {
+      for (size_t k = 0; k < 3; k++)
+      {
+        min.at(k) = std::fmin(min.at(k), box.min.at(k));
+        max.at(k) = std::fmax(max.at(k), box.max.at(k));
+      }
+    }
+
+    /**
+     * @return True if @a point is inside or on the boundary of the box
+     */
+    bool contains(const Vec3 &point) const
+    {
+      return point.x() >= min.x() && point.x() <= max.x() &&
+             point.y() >= min.y() && point.y() <= max.y() &&
+             point.z() >= min.z() && point.z() <= max.z();
+    }
+
+    /**
+     * @brief Computes the bounding box of this box after an affine transform
+     *
+     * Transforms the center and accumulates the absolute value of the linear part applied
+     * to the extents (Arvo's method), which is exact and avoids transforming eight corners.
+     *
+     * @param transform Affine transform, the bottom row must be (0, 0, 0, 1)
+     * @return The smallest box containing the transformed box
+     */
+    Aabb transformed(const Mat4 &transform) const
+    {
+      Mat3 linear = transform.block<0, 0, 3, 3>();
+      Vec3 translation = transform.block<0, 3, 3, 1>();
+      Mat3 absolute = linear;
+      for (real_t &value : absolute)
+      {
+        value = std::fabs(value);
+      }
+
+      return fromCenterExtent(linear * center() + translation, absolute * extent());
+    }
+  };
+
+  /**
+   * @brief Bounding sphere
+   */
+  struct Sphere
+  {
+    Vec3 center;   ///< Center of the sphere
+    real_t radius; ///< Radius of the sphere
+  };
+
+  /**
+   * @brief Plane of the points p where dot(normal, p) + distance == 0
+   *
+   * Points on the side the normal points to have a positive signed distance.
+   */
+  struct Plane
+  {
+    Vec3 normal{};       ///< Plane normal
+    real_t distance = 0; ///< Negated distance of the plane from the origin along the normal
+
+    /**
+     * @return Distance from the plane to @a point, scaled by the length of the normal
+     */
+    real_t signedDistance(const Vec3 &point) const
+    {
+      return normal.x() * point.x() + normal.y() * point.y() + normal.z() * point.z() + distance;
+    }
+
+    /**
+     * @brief Scales the plane equation so the normal has unit length
+     *
+     * @return A reference to this
+     */
+    Plane &normalize()
+    {
+      real_t length = std::sqrt(normal.x() * normal.x() + normal.y() * normal.y() + normal.z() * normal.z());
+      if (length > 0)
+      {
+        normal *= 1 / length;
+        distance /= length;
+      }
+      return *this;
+    }
+  };
+
+  /**
+   * @brief Half line of the points origin + t * direction, for t in [tMin, tMax]
+   */
+  struct Ray
+  {
+    Vec3 origin;                                           ///< Start point of the ray
+    Vec3 direction;                                        ///< Direction of the ray, need not be normalized
+    real_t tMin = 0;                                       ///< Smallest accepted ray parameter
+    real_t tMax = std::numeric_limits<real_t>::infinity(); ///< Largest accepted ray parameter
+  };
+
+  /**
+   * @brief Depth range of clip space produced by a projection matrix
+   */
+  enum class ClipDepth
+  {
+    negativeOneToOne, ///< OpenGL convention, -w <= z <= w
+    zeroToOne,        ///< Direct3D and Vulkan convention, 0 <= z <= w
+  };
+
+  /**
+   * @brief An array of axis aligned boxes stored as structure of arrays
+   *
+   * Boxes are kept as centers and half extents, which is the form the frustum test and
+   * the affine transform both consume directly.
+   */
+  class AabbArray
+  {
+  public:
+    /**
+     * @return Number of boxes
+     */
+    size_t size() const
+    {
+      return centers_.size();
+    }
+
+    /**
+     * @brief Appends a box
+     */
+    void push_back(const Aabb &box)
+    {
+      centers_.push_back(box.center());
+      extents_.push_back(box.extent());
+    }
+
+    /**
+     * @return Box @a i
+     */
+    Aabb operator[](size_t i) const
+    {
+      return Aabb::fromCenterExtent(centers_[i], extents_[i]);
+    }
+
+    /**
+     * @return Centers of every box
+     */
+    const SoAVec3Array &centers() const
+    {
+      return centers_;
+    }
+
+    /**
+     * @return Half extents of every box
+     */
+    const SoAVec3Array &extents() const
+    {
+      return extents_;
+    }
+
+    /**
+     * @brief Applies an affine transform to every box, see @ref Aabb::transformed
+     *
+     * @param transform Affine transform, the bottom row must be (0, 0, 0, 1)
+     */
+    void transform(const Mat4 &transform)
+    {
+      real_t *cx = centers_.x().data();
+      real_t *cy = centers_.y().data();
+      real_t *cz = centers_.z().data();
+      real_t *ex = extents_.x().data();
+      real_t *ey = extents_.y().data();
+      real_t *ez = extents_.z().data();
+
+      const real_t *m = transform.data();
+      real_t a[9];
+      for (size_t k = 0; k < 9; k++)
+      {
+        a[k] = std::fabs(m[(k / 3) * 4 + k % 3]);
+      }
+
+      for (size_t i = 0; i < size(); i++)
+      {
+        real_t x = cx[i];
+        real_t y = cy[i];
+        real_t z = cz[i];
+        cx[i] = m[0] * x + m[1] * y + m[2] * z + m[3];
+        cy[i] = m[4] * x + m[5] * y + m[6] * z + m[7];
+        cz[i] = m[8] * x + m[9] * y + m[10] * z + m[11];
+
+        x = ex[i];
+        y = ey[i];
+        z = ez[i];
+        ex[i] = a[0] * x + a[1] * y + a[2] * z;
+        ey[i] = a[3] * x + a[4] * y + a[5] * z;
+        ez[i] = a[6] * x + a[7] * y + a[8] * z;
+      }
+    }
+
+  private:
+    SoAVec3Array centers_;
+    SoAVec3Array extents_;
+  };
+
+  /**
+   * @brief An array of spheres stored as structure of arrays
+   */
+  class SphereArray
+  {
+  public:
+    /**
+     * @return Number of spheres
+     */
+    size_t size() const
+    {
+      return centers_.size();
+    }
+
+    /**
+     * @brief Appends a sphere
+     */
+    void push_back(const Sphere &sphere)
+    {
+      centers_.push_back(sphere.center);
+      radii_.push_back(sphere.radius);
+    }
+
+    /**
+     * @return Sphere @a i
+     */
+    Sphere operator[](size_t i) const
+    {
+      return Sphere{centers_[i], radii_[i]};
+    }
+
+    /**
+     * @return Centers of every sphere
+     */
+    const SoAVec3Array &centers() const
+    {
+      return centers_;
+    }
+
+    /**
+     * @return Radii of every sphere
+     */
+    std::span<const real_t> radii() const
+    {
+      return radii_;
+    }
+
+  private:
+    SoAVec3Array centers_;
+    AlignedVector<real_t> radii_;
+  };
+
+  /**
+   * @brief A view frustum bounded by six inward facing planes
+   */
+  class Frustum
+  {
+  public:
+    /**
+     * @brief Indices of the planes in @ref planes
+     */
+    enum Side
+    {
+      left,
+      right,
+      bottom,
+      top,
+      near,
+      far,
+    };
+
+    std::array<Plane, 6> planes{}; ///< Normalized planes whose normals point into the frustum
+
+    /**
+     * @brief Number of bits, and so of shapes, in each word of a visibility mask
+     */
+    static constexpr size_t batch_size = 64;
+
+    /**
+     * @brief Extracts the frustum planes from a view-projection matrix (Gribb-Hartmann)
+     *
+     * The matrix maps column vectors to clip space, `clip = viewProjection * point`.
+     *
+     * @param viewProjection Combined view and projection matrix
+     * @param depth Depth range of the clip space the matrix produces
+     * @return The frustum of the points visible through the matrix
+     */
+    static Frustum fromMatrix(const Mat4 &viewProjection, ClipDepth depth = ClipDepth::negativeOneToOne)
+    {
+      auto row = [&viewProjection](size_t r) { return Vec4(viewProjection.row(r).transposedView()); };
+      auto plane = [](const Vec4 &v) { return Plane{Vec3{v.x(), v.y(), v.z()}, v.w()}.normalize(); };
+
+      Frustum frustum;
+      frustum.planes[left] = plane(row(3) + row(0));
+      frustum.planes[right] = plane(row(3) - row(0));
+      frustum.planes[bottom] = plane(row(3) + row(1));
+      frustum.planes[top] = plane(row(3) - row(1));
+      frustum.planes[near] = plane(depth == ClipDepth::zeroToOne ? row(2) : row(3) + row(2));
+      frustum.planes[far] = plane(row(3) - row(2));
+      return frustum;
+    }
+
+    /**
+     * @return False if @a box is certainly outside the frustum
+     */
+    bool intersects(const Aabb &box) const
+    {
+      Vec3 center = box.center();
+      Vec3 extent = box.extent();
+      for (const Plane &plane : planes)
+      {
+        real_t reach = std::fabs(plane.normal.x()) * extent.x() +
+                       std::fabs(plane.normal.y()) * extent.y() +
+                       std::fabs(plane.normal.z()) * extent.z();
+        if (plane.signedDistance(center) + reach < 0)
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    /**
+     * @return False if @a sphere is certainly outside the frustum
+     */
+    bool intersects(const Sphere &sphere) const
+    {
+      for (const Plane &plane : planes)
+      {
+        if (plane.signedDistance(sphere.center) + sphere.radius < 0)
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    /**
+     * @brief Tests every box against the frustum
+     *
+     * Boxes are processed @ref batch_size at a time. Every box evaluates all six planes in
+     * one branch-free pass over the center and extent columns, so consecutive boxes fill the
+     * SIMD lanes.
+     *
+     * @param boxes Boxes to test
+     * @param visible Receives one word per batch, bit i of word b is set if box
+     *        b * @ref batch_size + i may intersect the frustum. Bits past the last box are
+     *        cleared, including any words past the last batch.
+     */
+    void cull(const AabbArray &boxes, std::span<uint64_t> visible) const
+    {
+      checkMaskSize(boxes.size(), visible.size());
+
+      const real_t *cx = boxes.centers().x().data();
+      const real_t *cy = boxes.centers().y().data();
+      const real_t *cz = boxes.centers().z().data();
+      const real_t *ex = boxes.extents().x().data();
+      const real_t *ey = boxes.extents().y().data();
+      const real_t *ez = boxes.extents().z().data();
+
+      Coefficients c = coefficients();
+      size_t word = 0;
+      for (size_t first = 0; first < boxes.size(); first += batch_size, word++)
+      {
+        size_t n = boxes.size() - first < batch_size ? boxes.size() - first : batch_size;
+        uint8_t inside[batch_size];
+        for (size_t i = 0; i < n; i++)
+        {
+          size_t j = first + i;
+          real_t nearest = std::numeric_limits<real_t>::infinity();
+          for (size_t p = 0; p < 6; p++)
+          {
+            real_t d = c.nx[p] * cx[j] + c.ny[p] * cy[j] + c.nz[p] * cz[j] + c.d[p] +
+                       c.ax[p] * ex[j] + c.ay[p] * ey[j] + c.az[p] * ez[j];
+            nearest = d < nearest ? d : nearest;
+          }
+          inside[i] = nearest >= 0;
+        }
+        visible[word] = pack(inside, n);
+      }
+      clearFrom(visible, word);
+    }
+
+    /**
+     * @brief Tests every sphere against the frustum
+     *
+     * @param spheres Spheres to test
+     * @param visible Receives one word per batch, as in @ref cull for boxes
+     */
+    void cull(const SphereArray &spheres, std::span<uint64_t> visible) const
+    {
+      checkMaskSize(spheres.size(), visible.size());
+
+      const real_t *cx = spheres.centers().x().data();
+      const real_t *cy = spheres.centers().y().data();
+      const real_t *cz = spheres.centers().z().data();
+      const real_t *r = spheres.radii().data();
+
+      Coefficients c = coefficients();
+      size_t word = 0;
+      for (size_t first = 0; first < spheres.size(); first += batch_size, word++)
+      {
+        size_t n = spheres.size() - first < batch_size ? spheres.size() - first : batch_size;
+        uint8_t inside[batch_size];
+        for (size_t i = 0; i < n; i++)
+        {
+          size_t j = first + i;
+          real_t nearest = std::numeric_limits<real_t>::infinity();
+          for (size_t p = 0; p < 6; p++)
+          {
+            real_t d = c.nx[p] * cx[j] + c.ny[p] * cy[j] + c.nz[p] * cz[j] + c.d[p];
+            nearest = d < nearest ? d : nearest;
+          }
+          inside[i] = nearest + r[j] >= 0;
+        }
+        visible[word] = pack(inside, n);
+      }
+      clearFrom(visible, word);
+    }
+
+  private:
+    /**
+     * @brief Plane equations as structure of arrays, with the absolute normals precomputed
+     */
+    struct Coefficients
+    {
+      real_t nx[6], ny[6], nz[6], d[6];
+      real_t ax[6], ay[6], az[6];
+    };
+
+    Coefficients coefficients() const
+    {
+      Coefficients c;
+      for (size_t p = 0; p < 6; p++)
+      {
+        c.nx[p] = planes[p].normal.x();
+        c.ny[p] = planes[p].normal.y();
+        c.nz[p] = planes[p].normal.z();
+        c.d[p] = planes[p].distance;
+        c.ax[p] = std::fabs(c.nx[p]);
+        c.ay[p] = std::fabs(c.ny[p]);
+        c.az[p] = std::fabs(c.nz[p]);
+      }
+      return c;
+    }
+
+    static uint64_t pack(const uint8_t *inside, size_t n)
+    {
+      uint64_t mask = 0;
+      for (size_t i = 0; i < n; i++)
+      {
+        mask |= uint64_t(inside[i]) << i;
+      }
+      return mask;
+    }
+
+    static void clearFrom(std::span<uint64_t> visible, size_t word)
+    {
+      for (; word < visible.size(); word++)
+      {
+        visible[word] = 0;
+      }
+    }
+
+    static void checkMaskSize(size_t shapes, size_t words)
+    {
+      if (words * batch_size < shapes)
+      {
+        throw std::invalid_argument("visibility mask is too small");
+      }
+    }
+  };
+}
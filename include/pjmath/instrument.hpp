@@ -0,0 +1,165 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+/**
+ * Operation counters and scoped timers for profiling code built on pjmath.
+ *
+ * Hooks in the header-only types are the @ref PJMATH_COUNT and @ref PJMATH_SCOPED_TIMER
+ * macros, which expand to nothing unless PJMATH_INSTRUMENT is defined (the CMake option of the
+ * same name defines it for the library and everything linking it). Counters are per thread and
+ * bumped without atomic read-modify-write, so an instrumented build stays cheap enough to
+ * profile with.
+ */
+namespace pjmath::instrument
+{
+#ifdef PJMATH_INSTRUMENT
+  constexpr bool enabled = true; ///< True if the hooks are compiled in
+#else
+  constexpr bool enabled = false; ///< True if the hooks are compiled in
+#endif
+
+  /**
+   * @brief Operations counted by the hooks
+   */
+  enum class Counter : size_t
+  {
+    mat_multiply,     ///< Matrix products, `Mat::operator*`
+    mat_elementwise,  ///< Element-wise matrix updates, including the fused ones
+    mat_copy,         ///< Matrix copies and assignments, moves count too as they copy the elements
+    vector_normalize, ///< Calls to `Vector::Normalize`
+    divisors,         ///< Calls to `divisorsOf` or `properDivisorsOf`
+  };
+
+  /**
+   * @brief Number of @ref Counter values
+   */
+  constexpr size_t counter_count = 5;
+
+  /**
+   * @brief Accumulated time of one named timer
+   */
+  struct TimerTotal
+  {
+    uint64_t calls = 0;       ///< Number of timed scopes
+    uint64_t nanoseconds = 0; ///< Total time spent in them
+  };
+
+  /**
+   * @brief Counter and timer values at one point in time
+   */
+  struct Snapshot
+  {
+    std::array<uint64_t, counter_count> counters{}; ///< Value of each @ref Counter
+    std::map<std::string, TimerTotal> timers{};      ///< Totals of each timer, by name
+
+    /**
+     * @return Value of @a counter
+     */
+    uint64_t operator[](Counter counter) const
+    {
+      return counters[size_t(counter)];
+    }
+  };
+
+  /**
+   * @return Counters and timers of the calling thread
+   */
+  Snapshot snapshot();
+
+  /**
+   * @return Counters and timers summed over every thread, including threads which have exited
+   */
+  Snapshot totalSnapshot();
+
+  /**
+   * @brief Zeroes the counters and timers of the calling thread
+   */
+  void reset();
+
+  /**
+   * @brief Zeroes the counters and timers of every thread, updates racing with it may be lost
+   */
+  void resetAll();
+
+  namespace detail
+  {
+    struct ThreadCounters
+    {
+      std::array<std::atomic<uint64_t>, counter_count> counts{};
+      bool registered = false;
+    };
+
+    extern constinit thread_local ThreadCounters thread_counters;
+
+    void registerThread();
+    void addTime(const char *name, uint64_t nanoseconds);
+
+    /**
+     * @brief Bumps a counter of the calling thread, only this thread writes it so a relaxed
+     *        load and store suffice
+     */
+    inline void increment(Counter counter)
+    {
+      ThreadCounters &local = thread_counters;
+      if (!local.registered)
+      {
+        registerThread();
+      }
+      std::atomic<uint64_t> &count = local.counts[size_t(counter)];
+      count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Adds the time from its construction to its destruction to the timer @a name
+   */
+  class ScopedTimer
+  {
+  public:
+    /**
+     * @param name Timer name, must outlive the timer
+     */
+    explicit ScopedTimer(const char *name) : name_(name), start_(std::chrono::steady_clock::now())
+    {
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    ~ScopedTimer()
+    {
+      auto elapsed = std::chrono::steady_clock::now() - start_;
+      detail::addTime(name_, uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+  private:
+    const char *name_;
+    std::chrono::steady_clock::time_point start_;
+  };
+}
+
+#define PJMATH_INSTRUMENT_CONCAT_(a, b) a##b
+#define PJMATH_INSTRUMENT_CONCAT(a, b) PJMATH_INSTRUMENT_CONCAT_(a, b)
+
+#ifdef PJMATH_INSTRUMENT
+/**
+ * @brief Bumps the @ref pjmath::instrument::Counter named @a counter
+ */
+#define PJMATH_COUNT(counter) ::pjmath::instrument::detail::increment(::pjmath::instrument::Counter::counter)
+
+/**
+ * @brief Times the rest of the enclosing scope under the timer @a name
+ */
+#define PJMATH_SCOPED_TIMER(name) \
+  ::pjmath::instrument::ScopedTimer PJMATH_INSTRUMENT_CONCAT(pjmath_scoped_timer_, __LINE__)(name)
+#else
+#define PJMATH_COUNT(counter) static_cast<void>(0)
+#define PJMATH_SCOPED_TIMER(name) static_cast<void>(0)
+#endif
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+#include "definitions.hpp"
+#include "kernels.hpp"
+#include "soa.hpp"
+
+/**
+ * Batch interpolation over structure of arrays, for sampling many animation channels at once.
+ *
+ * Element i of every argument belongs to the same channel, each channel has its own
+ * parameter `t[i]`. Rotations are unit quaternions stored as (x, y, z, w) in a
+ * `SoAVec4Array`. The output may be one of the inputs, each element is read before it is
+ * written, and is resized to the size of the inputs.
+ *
+ * Interleaved `Vector3` or `Vec3` arrays convert with @ref SoAVecArray::fromAoS and
+ * @ref SoAVecArray::toAoS, a single uniform parameter over interleaved arrays is covered by
+ * the batch `lerp` of batch.hpp.
+ */
+namespace pjmath
+{
+  /**
+   * @brief Angles whose cosine is closer to one than this are interpolated linearly by @ref slerp
+   *
+   * Below about 1.4e-3 radians the linear and spherical paths differ by less than 1e-10,
+   * while the division by the sine of the angle starts losing precision.
+   */
+  constexpr real_t slerp_linear_threshold = 1e-6;
+
+  namespace detail
+  {
+    inline void checkInterpolationSize(size_t expected, size_t actual)
+    {
+      if (expected != actual)
+      {
+        throw std::invalid_argument("array sizes do not match");
+      }
+    }
+
+    /**
+     * Weights of the two endpoints in @ref slerp, the sign of the second flips it onto the
+     * hemisphere of the first.
+     */
+    template <typename T>
+    void slerpWeights(T cosine, T t, T &wa, T &wb)
+    {
+      T sign = std::copysign(T(1), cosine);
+      cosine = std::fabs(cosine);
+      if (cosine > T(1) - T(slerp_linear_threshold))
+      {
+        wa = T(1) - t;
+        wb = sign * t;
+        return;
+      }
+      T angle = std::acos(cosine);
+      T inverseSine = T(1) / std::sin(angle);
+      wa = std::sin((T(1) - t) * angle) * inverseSine;
+      wb = sign * std::sin(t * angle) * inverseSine;
+    }
+
+    /**
+     * Scales the quaternions [@a first, @a first + @a count) of @a out to unit length.
+     */
+    template <typename T>
+    void normalizeQuaternions(SoAVecArray<4, T> &out, size_t first, size_t count)
+    {
+      T *x = out.x().data() + first;
+      T *y = out.y().data() + first;
+      T *z = out.z().data() + first;
+      T *w = out.w().data() + first;
+      for (size_t i = 0; i < count; i++)
+      {
+        T inverse = T(1) / std::sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i] + w[i] * w[i]);
+        x[i] *= inverse;
+        y[i] *= inverse;
+        z[i] *= inverse;
+        w[i] *= inverse;
+      }
+    }
+  }
+
+  /**
+   * @brief Computes @a out[i] = @a a[i] + (@a b[i] - @a a[i]) * @a t[i]
+   *
+   * @param a Values at t = 0
+   * @param b Values at t = 1
+   * @param t One parameter per element
+   * @param out Receives the interpolated values
+   */
+  template <size_t D, typename T>
+  void lerp(const SoAVecArray<D, T> &a, const SoAVecArray<D, T> &b,
+            std::span<const std::type_identity_t<T>> t, SoAVecArray<D, T> &out)
+  {
+    size_t count = a.size();
+    detail::checkInterpolationSize(count, b.size());
+    detail::checkInterpolationSize(count, t.size());
+    out.resize(count);
+    for (size_t k = 0; k < D; k++)
+    {
+      const T *ak = a.column(k).data();
+      const T *bk = b.column(k).data();
+      T *ok = out.column(k).data();
+      for (size_t i = 0; i < count; i++)
+      {
+        ok[i] = Fma(bk[i] - ak[i], t[i], ak[i]);
+      }
+    }
+  }
+
+  /**
+   * @brief Normalized linear interpolation of unit quaternions along the shorter arc
+   *
+   * Cheaper than @ref slerp and exact at both ends, but the angular velocity is not constant,
+   * it speeds up towards the middle of the arc. The difference from @ref slerp shrinks with
+   * the cube of the angle between the endpoints.
+   *
+   * @param a Rotations at t = 0
+   * @param b Rotations at t = 1, the sign of q and -q is chosen per element for the shorter arc
+   * @param t One parameter per element
+   * @param out Receives unit quaternions
+   */
+  template <typename T>
+  void nlerp(const SoAVecArray<4, T> &a, const SoAVecArray<4, T> &b,
+             std::span<const std::type_identity_t<T>> t, SoAVecArray<4, T> &out)
+  {
+    size_t count = a.size();
+    detail::checkInterpolationSize(count, b.size());
+    detail::checkInterpolationSize(count, t.size());
+    out.resize(count);
+
+    const T *ax = a.x().data();
+    const T *ay = a.y().data();
+    const T *az = a.z().data();
+    const T *aw = a.w().data();
+    const T *bx = b.x().data();
+    const T *by = b.y().data();
+    const T *bz = b.z().data();
+    const T *bw = b.w().data();
+    T *ox = out.x().data();
+    T *oy = out.y().data();
+    T *oz = out.z().data();
+    T *ow = out.w().data();
+    for (size_t i = 0; i < count; i++)
+    {
+      T cosine = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i] + aw[i] * bw[i];
+      T wa = T(1) - t[i];
+      T wb = std::copysign(T(1), cosine) * t[i];
+      T x = ax[i] * wa + bx[i] * wb;
+      T y = ay[i] * wa + by[i] * wb;
+      T z = az[i] * wa + bz[i] * wb;
+      T w = aw[i] * wa + bw[i] * wb;
+      T inverse = T(1) / std::sqrt(x * x + y * y + z * z + w * w);
+      ox[i] = x * inverse;
+      oy[i] = y * inverse;
+      oz[i] = z * inverse;
+      ow[i] = w * inverse;
+    }
+  }
+
+  /**
+   * @brief Spherical linear interpolation of unit quaternions along the shorter arc
+   *
+   * Rotates at constant angular velocity. Endpoints closer than @ref slerp_linear_threshold
+   * are interpolated linearly, and every result is renormalized so rounding in the inputs
+   * does not accumulate across frames.
+   *
+   * The weights of a block of elements are computed first and then applied to the four
+   * columns, so only the trigonometry is scalar.
+   *
+   * @param a Rotations at t = 0
+   * @param b Rotations at t = 1, the sign of q and -q is chosen per element for the shorter arc
+   * @param t One parameter per element
+   * @param out Receives unit quaternions
+   */
+  template <typename T>
+  void slerp(const SoAVecArray<4, T> &a, const SoAVecArray<4, T> &b,
+             std::span<const std::type_identity_t<T>> t, SoAVecArray<4, T> &out)
+  {
+    size_t count = a.size();
+    detail::checkInterpolationSize(count, b.size());
+    detail::checkInterpolationSize(count, t.size());
+    out.resize(count);
+
+    T wa[kernels::normalize_block];
+    T wb[kernels::normalize_block];
+    for (size_t first = 0; first < count; first += kernels::normalize_block)
+    {
+      size_t n = std::min(kernels::normalize_block, count - first);
+      for (size_t i = 0; i < n; i++)
+      {
+        size_t j = first + i;
+        T cosine = a.x()[j] * b.x()[j] + a.y()[j] * b.y()[j] + a.z()[j] * b.z()[j] + a.w()[j] * b.w()[j];
+        detail::slerpWeights(cosine, t[j], wa[i], wb[i]);
+      }
+      for (size_t k = 0; k < 4; k++)
+      {
+        const T *ak = a.column(k).data() + first;
+        const T *bk = b.column(k).data() + first;
+        T *ok = out.column(k).data() + first;
+        for (size_t i = 0; i < n; i++)
+        {
+          ok[i] = ak[i] * wa[i] + bk[i] * wb[i];
+        }
+      }
+      detail::normalizeQuaternions(out, first, n);
+    }
+  }
+
+  /**
+   * @brief Cubic Hermite interpolation between two keys with given tangents
+   *
+   * Tangents are derivatives with respect to t, so keys spaced d apart in time need their
+   * time derivatives multiplied by d.
+   *
+   * @param p0 Values at t = 0
+   * @param m0 Tangents at t = 0
+   * @param p1 Values at t = 1
+   * @param m1 Tangents at t = 1
+   * @param t One parameter per element
+   * @param out Receives the interpolated values
+   */
+  template <size_t D, typename T>
+  void hermite(const SoAVecArray<D, T> &p0, const SoAVecArray<D, T> &m0, const SoAVecArray<D, T> &p1,
+               const SoAVecArray<D, T> &m1, std::span<const std::type_identity_t<T>> t,
+               SoAVecArray<D, T> &out)
+  {
+    size_t count = p0.size();
+    detail::checkInterpolationSize(count, m0.size());
+    detail::checkInterpolationSize(count, p1.size());
+    detail::checkInterpolationSize(count, m1.size());
+    detail::checkInterpolationSize(count, t.size());
+    out.resize(count);
+    for (size_t k = 0; k < D; k++)
+    {
+      const T *a = p0.column(k).data();
+      const T *ma = m0.column(k).data();
+      const T *b = p1.column(k).data();
+      const T *mb = m1.column(k).data();
+      T *o = out.column(k).data();
+      for (size_t i = 0; i < count; i++)
+      {
+        T s = t[i];
+        T s2 = s * s;
+        T s3 = s2 * s;
+        T h01 = T(3) * s2 - T(2) * s3;
+        T h10 = s3 - T(2) * s2 + s;
+        T h11 = s3 - s2;
+        o[i] = a[i] + (b[i] - a[i]) * h01 + ma[i] * h10 + mb[i] * h11;
+      }
+    }
+  }
+
+  /**
+   * @brief Uniform Catmull-Rom interpolation between @a p1 and @a p2
+   *
+   * The curve passes through every key, with tangents (p2 - p0) / 2 and (p3 - p1) / 2, which
+   * makes it the Hermite curve of evenly spaced keys.
+   *
+   * @param p0 Keys before the segment
+   * @param p1 Values at t = 0
+   * @param p2 Values at t = 1
+   * @param p3 Keys after the segment
+   * @param t One parameter per element
+   * @param out Receives the interpolated values
+   */
+  template <size_t D, typename T>
+  void catmullRom(const SoAVecArray<D, T> &p0, const SoAVecArray<D, T> &p1, const SoAVecArray<D, T> &p2,
+                  const SoAVecArray<D, T> &p3, std::span<const std::type_identity_t<T>> t,
+                  SoAVecArray<D, T> &out)
+  {
+    size_t count = p0.size();
+    detail::checkInterpolationSize(count, p1.size());
+    detail::checkInterpolationSize(count, p2.size());
+    detail::checkInterpolationSize(count, p3.size());
+    detail::checkInterpolationSize(count, t.size());
+    out.resize(count);
+    for (size_t k = 0; k < D; k++)
+    {
+      const T *a = p0.column(k).data();
+      const T *b = p1.column(k).data();
+      const T *c = p2.column(k).data();
+      const T *d = p3.column(k).data();
+      T *o = out.column(k).data();
+      for (size_t i = 0; i < count; i++)
+      {
+        // Horner form of 0.5 (2b + (c - a) t + (2a - 5b + 4c - d) t² + (3b - a - 3c + d) t³)
+        T s = t[i];
+        T c1 = c[i] - a[i];
+        T c2 = T(2) * a[i] - T(5) * b[i] + T(4) * c[i] - d[i];
+        T c3 = T(3) * (b[i] - c[i]) + d[i] - a[i];
+        o[i] = b[i] + T(0.5) * s * (c1 + s * (c2 + s * c3));
+      }
+    }
+  }
+}
@@ -0,0 +1,569 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "definitions.hpp"
+#include "math_funcs.hpp"
+
+/**
+ * Loops shared by the matrix and vector types.
+ *
+ * Matrix kernels work on anything that exposes `row_count`, `column_count`, `row_stride`,
+ * `column_stride` and `data()`, which covers both `Mat` and `MatView`, so views and
+ * transposed views never need to be copied before they take part in an operation.
+ *
+ * Element-wise kernels work on flat arrays, so the same loop serves a single matrix or
+ * vector and a whole batch of them laid out contiguously.
+ */
+namespace pjmath::kernels
+{
+  /**
+   * @brief Computes @a out = @a lhs * @a rhs
+   *
+   * The loop order is chosen at compile time from the operand layouts:
+   * - a transposed left operand (AᵀB) walks the rows of A and B together and scatters into
+   *   the rows of the product,
+   * - a transposed right operand (ABᵀ) computes each element as the dot product of two
+   *   contiguous rows,
+   * - any other layout streams rows of @a rhs into rows of the product.
+   *
+   * Every product element accumulates its terms in ascending order of the inner index,
+   * so all three loop orders give identical results.
+   *
+   * @a out must not alias either operand.
+   *
+   * @tparam Lhs Left matrix or view type
+   * @tparam Rhs Right matrix or view type
+   * @tparam Out Contiguous result matrix type
+   * @param lhs Left operand
+   * @param rhs Right operand
+   * @param out Result matrix, overwritten
+   */
+  template <typename Lhs, typename Rhs, typename Out>
+  void multiply(const Lhs &lhs, const Rhs &rhs, Out &out)
+  {
+    using E = typename Out::value_type;
+    constexpr size_t M = Lhs::row_count;
+    constexpr size_t K = Lhs::column_count;
+    constexpr size_t N = Rhs::column_count;
+    constexpr size_t lrs = Lhs::row_stride;
+    constexpr size_t lcs = Lhs::column_stride;
+    constexpr size_t rrs = Rhs::row_stride;
+    constexpr size_t rcs = Rhs::column_stride;
+
+    static_assert(K == Rhs::row_count);
+    static_assert(Out::row_count == M && Out::column_count == N);
+    static_assert(Out::row_stride == N && Out::column_stride == 1);
+
+    const auto *a = lhs.data();
+    const auto *b = rhs.data();
+    E *c = out.data();
+
+    if constexpr (rrs == 1 && rcs != 1 && lcs == 1)
+    {
+      // ABᵀ, rows of lhs and columns of rhs are both contiguous
+      for (size_t i = 0; i < M; i++)
+      {
+        for (size_t j = 0; j < N; j++)
+        {
+          E sum{};
+          for (size_t k = 0; k < K; k++)
+          {
+            sum += a[i * lrs + k] * b[j * rcs + k];
+          }
+          c[i * N + j] = sum;
+        }
+      }
+    }
+    else
+    {
+      // AᵀB when lhs is transposed, otherwise the plain row-streaming product
+      for (size_t i = 0; i < M * N; i++)
+      {
+        c[i] = E{};
+      }
+      if constexpr (lrs == 1 && lcs != 1)
+      {
+        for (size_t k = 0; k < K; k++)
+        {
+          for (size_t i = 0; i < M; i++)
+          {
+            const E scale = a[k * lcs + i];
+            for (size_t j = 0; j < N; j++)
+            {
+              c[i * N + j] += scale * b[k * rrs + j * rcs];
+            }
+          }
+        }
+      }
+      else
+      {
+        for (size_t i = 0; i < M; i++)
+        {
+          for (size_t k = 0; k < K; k++)
+          {
+            const E scale = a[i * lrs + k * lcs];
+            for (size_t j = 0; j < N; j++)
+            {
+              c[i * N + j] += scale * b[k * rrs + j * rcs];
+            }
+          }
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Computes @a y += @a x * @a s over @a n elements
+   */
+  template <typename T>
+  void addScaled(T *y, const T *x, T s, size_t n)
+  {
+    for (size_t i = 0; i < n; i++)
+    {
+      y[i] = Fma(x[i], s, y[i]);
+    }
+  }
+
+  /**
+   * @brief Computes @a y += @a a * @a b element-wise over @a n elements
+   */
+  template <typename T>
+  void madd(T *y, const T *a, const T *b, size_t n)
+  {
+    for (size_t i = 0; i < n; i++)
+    {
+      y[i] = Fma(a[i], b[i], y[i]);
+    }
+  }
+
+  /**
+   * @brief Computes @a y = @a y * @a m + @a c element-wise over @a n elements
+   */
+  template <typename T>
+  void fma(T *y, const T *m, const T *c, size_t n)
+  {
+    for (size_t i = 0; i < n; i++)
+    {
+      y[i] = Fma(y[i], m[i], c[i]);
+    }
+  }
+
+  /**
+   * @brief Computes @a y = @a a + (@a b - @a a) * @a t over @a n elements
+   *
+   * @a y may alias @a a or @a b.
+   */
+  template <typename T>
+  void lerp(T *y, const T *a, const T *b, T t, size_t n)
+  {
+    for (size_t i = 0; i < n; i++)
+    {
+      y[i] = Fma(b[i] - a[i], t, a[i]);
+    }
+  }
+
+  /**
+   * @brief Number of independent accumulators used by reductions
+   *
+   * Splitting a sum over several accumulators removes the dependency between consecutive
+   * additions, which lets the compiler keep one accumulator per SIMD lane.
+   */
+  constexpr size_t reduction_lanes = 8;
+
+  /**
+   * @brief Number of elements below which pairwise summation stops splitting
+   */
+  constexpr size_t pairwise_block = 128;
+
+  /**
+   * @brief Number of elements in each leaf of the reproducible summation tree
+   */
+  constexpr size_t reproducible_block = 1024;
+
+  /**
+   * @brief Reduces the range [@a begin, @a end) with one accumulator per lane
+   *
+   * @param step Callable returning the accumulator updated with element i
+   */
+  template <typename T, typename Step>
+  T laneReduce(size_t begin, size_t end, Step step)
+  {
+    if (end - begin < reduction_lanes)
+    {
+      T acc{};
+      for (size_t i = begin; i < end; i++)
+      {
+        acc = step(acc, i);
+      }
+      return acc;
+    }
+
+    T acc[reduction_lanes] = {};
+    size_t i = begin;
+    for (; i + reduction_lanes <= end; i += reduction_lanes)
+    {
+      for (size_t lane = 0; lane < reduction_lanes; lane++)
+      {
+        acc[lane] = step(acc[lane], i + lane);
+      }
+    }
+    for (size_t lane = 0; lane < reduction_lanes && i + lane < end; lane++)
+    {
+      acc[lane] = step(acc[lane], i + lane);
+    }
+    for (size_t width = reduction_lanes / 2; width > 0; width /= 2)
+    {
+      for (size_t lane = 0; lane < width; lane++)
+      {
+        acc[lane] += acc[lane + width];
+      }
+    }
+    return acc[0];
+  }
+
+  /**
+   * @brief Reduces the range [@a begin, @a end) by recursive halving
+   *
+   * @param step Callable returning the accumulator updated with element i
+   */
+  template <typename T, typename Step>
+  T pairwiseReduce(size_t begin, size_t end, Step step)
+  {
+    if (end - begin <= pairwise_block)
+    {
+      return laneReduce<T>(begin, end, step);
+    }
+    size_t middle = begin + (end - begin) / 2;
+    return pairwiseReduce<T>(begin, middle, step) + pairwiseReduce<T>(middle, end, step);
+  }
+
+  /**
+   * @brief Combines the blocks [@a firstBlock, @a lastBlock) by recursive halving of the block count
+   *
+   * The shape of the tree only depends on the number of blocks, so any schedule which
+   * computes the same leaves gets the same result.
+   *
+   * @param leaf Callable returning the partial result of block b
+   */
+  template <typename T, typename Leaf>
+  T blockTreeReduce(size_t firstBlock, size_t lastBlock, Leaf leaf)
+  {
+    if (lastBlock - firstBlock == 1)
+    {
+      return leaf(firstBlock);
+    }
+    size_t middle = firstBlock + (lastBlock - firstBlock) / 2;
+    return blockTreeReduce<T>(firstBlock, middle, leaf) + blockTreeReduce<T>(middle, lastBlock, leaf);
+  }
+
+  /**
+   * @brief Reduces @a n elements as blocks of @ref reproducible_block combined by @ref blockTreeReduce
+   *
+   * @param step Callable returning the accumulator updated with element i
+   */
+  template <typename T, typename Step>
+  T reproducibleReduce(size_t n, Step step)
+  {
+    if (n == 0)
+    {
+      return T{};
+    }
+    size_t blocks = (n + reproducible_block - 1) / reproducible_block;
+    return blockTreeReduce<T>(0, blocks, [n, &step](size_t block) {
+      size_t begin = block * reproducible_block;
+      return laneReduce<T>(begin, std::min(n, begin + reproducible_block), step);
+    });
+  }
+
+  /**
+   * @brief Neumaier compensated sum of @a n terms
+   *
+   * @param term Callable returning the value of term i and the rounding error already
+   *        made computing it
+   */
+  template <typename T, typename Term>
+  T compensatedReduce(size_t n, Term term)
+  {
+    T sum{};
+    T compensation{};
+    for (size_t i = 0; i < n; i++)
+    {
+      T error{};
+      T value = term(i, error);
+      T total = sum + value;
+      if (std::abs(sum) >= std::abs(value))
+      {
+        compensation += (sum - total) + value;
+      }
+      else
+      {
+        compensation += (value - total) + sum;
+      }
+      compensation += error;
+      sum = total;
+    }
+    return sum + compensation;
+  }
+
+  /**
+   * @brief Sums @a n elements
+   *
+   * @param x Elements
+   * @param n Number of elements
+   * @param mode Accuracy mode, ignored for integral types which are always exact
+   * @return The sum of the elements
+   */
+  template <typename T>
+  T sum(const T *x, size_t n, Summation mode = Summation::fast)
+  {
+    auto step = [x](T acc, size_t i) { return acc + x[i]; };
+
+    if constexpr (std::is_floating_point_v<T>)
+    {
+      if (mode == Summation::pairwise)
+      {
+        return pairwiseReduce<T>(0, n, step);
+      }
+      if (mode == Summation::kahan)
+      {
+        return compensatedReduce<T>(n, [x](size_t i, T &) { return x[i]; });
+      }
+      if (mode == Summation::reproducible)
+      {
+        return reproducibleReduce<T>(n, step);
+      }
+    }
+    return laneReduce<T>(0, n, step);
+  }
+
+  /**
+   * @brief Computes the dot product of two arrays of @a n elements
+   *
+   * In kahan mode the rounding error of every product is also recovered exactly with
+   * `std::fma`, so the result is as accurate as if computed in twice the precision. Targets
+   * without an fma instruction pay for a software fma there.
+   *
+   * In reproducible mode every product is stored through a volatile, so it is rounded before
+   * it is added even when the including translation unit lets the compiler contract them into
+   * fused multiply-adds. `dot` over spans runs the same reduction vectorized and in parallel.
+   *
+   * @param a First array
+   * @param b Second array
+   * @param n Number of elements
+   * @param mode Accuracy mode, ignored for integral types which are always exact
+   * @return The dot product
+   */
+  template <typename T>
+  T dot(const T *a, const T *b, size_t n, Summation mode = Summation::fast)
+  {
+    auto step = [a, b](T acc, size_t i) { return Fma(a[i], b[i], acc); };
+
+    if constexpr (std::is_floating_point_v<T>)
+    {
+      if (mode == Summation::pairwise)
+      {
+        return pairwiseReduce<T>(0, n, step);
+      }
+      if (mode == Summation::kahan)
+      {
+        auto term = [a, b](size_t i, T &error) {
+          T product = a[i] * b[i];
+          error = std::fma(a[i], b[i], -product);
+          return product;
+        };
+        return compensatedReduce<T>(n, term);
+      }
+      if (mode == Summation::reproducible)
+      {
+        return reproducibleReduce<T>(n, [a, b](T acc, size_t i) {
+          volatile T product = a[i] * b[i];
+          return product + acc;
+        });
+      }
+    }
+    return laneReduce<T>(0, n, step);
+  }
+
+  /**
+   * @brief Computes the dot products of @a count pairs of contiguous Width element vectors
+   *
+   * @tparam Width Number of elements in each vector
+   * @param a First vector of every pair, packed
+   * @param b Second vector of every pair, packed
+   * @param out Receives one dot product per pair
+   * @param count Number of pairs
+   */
+  template <size_t Width, typename T>
+  void dots(const T *a, const T *b, T *out, size_t count)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      T acc{};
+      for (size_t k = 0; k < Width; k++)
+      {
+        acc = Fma(a[i * Width + k], b[i * Width + k], acc);
+      }
+      out[i] = acc;
+    }
+  }
+
+  /**
+   * @brief Number of vectors normalized together by @ref normalize
+   */
+  constexpr size_t normalize_block = 64;
+
+  /**
+   * @brief Estimates 1 / sqrt(x) for @a n positive normal single precision values
+   *
+   * Uses the hardware estimate (relative error at most 1.5 * 2^-12) when the target has one,
+   * otherwise the classic bit-level approximation (relative error at most 1.75e-3).
+   *
+   * @return The number of Newton iterations needed to bring the estimate to full single precision
+   */
+  template <typename T>
+  int rsqrtEstimates(const T *x, T *y, size_t n)
+  {
+    size_t i = 0;
+#if defined(__SSE2__)
+    if constexpr (std::is_same_v<T, double>)
+    {
+      for (; i + 4 <= n; i += 4)
+      {
+        __m128 low = _mm_cvtpd_ps(_mm_loadu_pd(x + i));
+        __m128 high = _mm_cvtpd_ps(_mm_loadu_pd(x + i + 2));
+        __m128 estimate = _mm_rsqrt_ps(_mm_movelh_ps(low, high));
+        _mm_storeu_pd(y + i, _mm_cvtps_pd(estimate));
+        _mm_storeu_pd(y + i + 2, _mm_cvtps_pd(_mm_movehl_ps(estimate, estimate)));
+      }
+    }
+    else if constexpr (std::is_same_v<T, float>)
+    {
+      for (; i + 4 <= n; i += 4)
+      {
+        _mm_storeu_ps(y + i, _mm_rsqrt_ps(_mm_loadu_ps(x + i)));
+      }
+    }
+    for (; i < n; i++)
+    {
+      y[i] = static_cast<T>(_mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(static_cast<float>(x[i])))));
+    }
+    return 1;
+#else
+    for (; i < n; i++)
+    {
+      float value = static_cast<float>(x[i]);
+      uint32_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      bits = 0x5f375a86 - (bits >> 1);
+      std::memcpy(&value, &bits, sizeof(value));
+      y[i] = static_cast<T>(value);
+    }
+    return 2;
+#endif
+  }
+
+  /**
+   * @brief Computes the factors which normalize vectors of the given squared lengths
+   *
+   * Each factor is 1 / sqrt(@a lengthSquared[i]), or one when the squared length is not
+   * positive so that zero vectors are left unchanged, as @ref Vector::Normalize does.
+   *
+   * In fast mode, squared lengths outside the single precision normal range fall back to the
+   * exact computation, since the hardware estimate only covers that range.
+   *
+   * @param lengthSquared Squared vector lengths
+   * @param factors Receives the factors, may not alias @a lengthSquared
+   * @param n Number of values
+   * @param mode Accuracy mode, see @ref NormalizeMode for the error bounds
+   */
+  template <typename T>
+  void normalizationFactors(const T *lengthSquared, T *factors, size_t n, NormalizeMode mode)
+  {
+    if (mode == NormalizeMode::fast)
+    {
+      int iterations = rsqrtEstimates(lengthSquared, factors, n);
+      for (int iteration = 0; iteration < iterations; iteration++)
+      {
+        for (size_t i = 0; i < n; i++)
+        {
+          T half = lengthSquared[i] * T(0.5) * factors[i] * factors[i];
+          factors[i] = factors[i] * (T(1.5) - half);
+        }
+      }
+      for (size_t i = 0; i < n; i++)
+      {
+        if (!(lengthSquared[i] >= T(FLT_MIN) && lengthSquared[i] <= T(FLT_MAX)))
+        {
+          factors[i] = T(1) / std::sqrt(lengthSquared[i]);
+        }
+      }
+    }
+    else
+    {
+      for (size_t i = 0; i < n; i++)
+      {
+        factors[i] = T(1) / std::sqrt(lengthSquared[i]);
+      }
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+      factors[i] = lengthSquared[i] > 0 ? factors[i] : T(1);
+    }
+  }
+
+  /**
+   * @brief Normalizes @a count contiguous Width element vectors in place
+   *
+   * Vectors are processed in blocks: squared lengths first, then the factors for the whole
+   * block, then the scaling, so each step is a simple loop over independent values.
+   *
+   * @tparam Width Number of elements in each vector
+   * @param v Vectors, packed
+   * @param count Number of vectors
+   * @param mode Accuracy mode, see @ref NormalizeMode for the error bounds
+   */
+  template <size_t Width, typename T>
+  void normalize(T *v, size_t count, NormalizeMode mode)
+  {
+    T lengthSquared[normalize_block];
+    T factors[normalize_block];
+
+    for (size_t first = 0; first < count; first += normalize_block)
+    {
+      size_t n = count - first < normalize_block ? count - first : normalize_block;
+      T *block = v + first * Width;
+
+      for (size_t i = 0; i < n; i++)
+      {
+        T acc{};
+        for (size_t k = 0; k < Width; k++)
+        {
+          acc = Fma(block[i * Width + k], block[i * Width + k], acc);
+        }
+        lengthSquared[i] = acc;
+      }
+
+      normalizationFactors(lengthSquared, factors, n, mode);
+
+      for (size_t i = 0; i < n; i++)
+      {
+        for (size_t k = 0; k < Width; k++)
+        {
+          block[i * Width + k] *= factors[i];
+        }
+      }
+    }
+  }
+}
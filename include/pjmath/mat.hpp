@@ -4,6 +4,15 @@
 #include <array>
 #include <type_traits>
 #include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+#include "definitions.hpp"
+#include "instrument.hpp"
+#include "kernels.hpp"
+#include "mat_view.hpp"
+#include "modular.hpp"
 
 namespace pjmath
 {
@@ -32,6 +41,8 @@ namespace pjmath
     static constexpr size_type column_count = N;         ///< Number of columns
     static constexpr size_type min_side = M > N ? N : M; ///< The number of rows or columns depending on which is less
     static constexpr size_type max_side = M > N ? M : N; ///< The number of rows or columns depending on which is greater
+    static constexpr size_type row_stride = N;           ///< Distance in elements between consecutive rows
+    static constexpr size_type column_stride = 1;        ///< Distance in elements between consecutive columns
 
     static constexpr bool is_square = row_count == column_count;   ///< True if the matrix is a square matrix
     static constexpr bool is_scalar = is_square && row_count == 1; ///< True if the matrix is a 1 by 1 matrix
@@ -43,10 +54,13 @@ namespace pjmath
     /**
      * @brief Constructs a Matrix from a parameter pack
      * 
+     * Only takes part in overload resolution when every argument converts to @a E, so
+     * objects which merely convert to a matrix use their own conversion instead.
+     * 
      * @tparam T element types
      * @param elems Elements of the matrix
      */
-    template <typename... T>
+    template <typename... T, typename = std::enable_if_t<(std::is_convertible_v<T, E> && ...)>>
     Mat(T... elems) : Array({static_cast<E>(elems)...}) // Cast prevents narrowing conversion warning during int literal->double
     {
     }
@@ -58,6 +72,58 @@ namespace pjmath
     {
     }
 
+    /**
+     * @brief Constructs a matrix from a matrix of the same shape but a different concrete type
+     * 
+     * @tparam D Concrete type of @a other
+     * @param other Matrix to copy from
+     */
+    template <typename D>
+    Mat(const Mat<E, M, N, D> &other) : Array(other)
+    {
+      PJMATH_COUNT(mat_copy);
+    }
+
+#ifdef PJMATH_INSTRUMENT
+    /**
+     * @brief Copy constructor, only declared to count copies in instrumented builds
+     */
+    Mat(const Mat &other) : Array(other)
+    {
+      PJMATH_COUNT(mat_copy);
+    }
+
+    /**
+     * @brief Copy assignment, only declared to count copies in instrumented builds
+     */
+    Mat &operator=(const Mat &other)
+    {
+      PJMATH_COUNT(mat_copy);
+      Array::operator=(other);
+      return *this;
+    }
+#endif
+
+    /**
+     * @brief Constructs a matrix by copying the elements of a view of the same shape
+     * 
+     * @tparam V Element type of the view
+     * @tparam RowStride Row stride of the view
+     * @tparam ColStride Column stride of the view
+     * @param view View to copy from
+     */
+    template <typename V, size_t RowStride, size_t ColStride>
+    Mat(const MatView<V, M, N, RowStride, ColStride> &view) : Array{}
+    {
+      for (size_type row = 0; row < row_count; row++)
+      {
+        for (size_type column = 0; column < column_count; column++)
+        {
+          this->at(row, column) = view.at(row, column);
+        }
+      }
+    }
+
     /**
      * @brief Gets the element at the given row and column
      * 
@@ -116,6 +182,7 @@ namespace pjmath
      */
     Self &operator+=(const Mat &rhs)
     {
+      PJMATH_COUNT(mat_elementwise);
       for (size_type i = 0; i < this->size(); i++)
       {
         this->at(i) += rhs.at(i);
@@ -123,6 +190,29 @@ namespace pjmath
       return *self();
     }
 
+    /**
+     * @brief Element-wise addition
+     * 
+     * @tparam V Element type of the view
+     * @tparam RowStride Row stride of the view
+     * @tparam ColStride Column stride of the view
+     * @param rhs View to be added to this
+     * @return A reference to this
+     */
+    template <typename V, size_t RowStride, size_t ColStride>
+    Self &operator+=(const MatView<V, M, N, RowStride, ColStride> &rhs)
+    {
+      PJMATH_COUNT(mat_elementwise);
+      for (size_type row = 0; row < row_count; row++)
+      {
+        for (size_type column = 0; column < column_count; column++)
+        {
+          this->at(row, column) += rhs.at(row, column);
+        }
+      }
+      return *self();
+    }
+
     /**
      * @brief Element-wise addition
      * 
@@ -131,7 +221,7 @@ namespace pjmath
      */
     Self operator+(const Mat &rhs) const
     {
-      Self mat = *this;
+      Self mat = *self();
       mat += rhs;
       return mat;
     }
@@ -144,6 +234,7 @@ namespace pjmath
      */
     Self &operator-=(const Mat &rhs)
     {
+      PJMATH_COUNT(mat_elementwise);
       for (size_type i = 0; i < this->size(); i++)
       {
         this->at(i) -= rhs.at(i);
@@ -151,6 +242,29 @@ namespace pjmath
       return *self();
     }
 
+    /**
+     * @brief Element-wise subtraction
+     * 
+     * @tparam V Element type of the view
+     * @tparam RowStride Row stride of the view
+     * @tparam ColStride Column stride of the view
+     * @param rhs The minuend
+     * @return A reference to this
+     */
+    template <typename V, size_t RowStride, size_t ColStride>
+    Self &operator-=(const MatView<V, M, N, RowStride, ColStride> &rhs)
+    {
+      PJMATH_COUNT(mat_elementwise);
+      for (size_type row = 0; row < row_count; row++)
+      {
+        for (size_type column = 0; column < column_count; column++)
+        {
+          this->at(row, column) -= rhs.at(row, column);
+        }
+      }
+      return *self();
+    }
+
     /**
      * @brief Element-wise subtraction
      * 
@@ -159,7 +273,7 @@ namespace pjmath
      */
     Self operator-(const Mat &rhs) const
     {
-      Self mat = *this;
+      Self mat = *self();
       mat -= rhs;
       return mat;
     }
@@ -184,6 +298,7 @@ namespace pjmath
      */
     Self &operator*=(const E &v)
     {
+      PJMATH_COUNT(mat_elementwise);
       for (E &e : *this)
       {
         e *= v;
@@ -199,13 +314,73 @@ namespace pjmath
      */
     Self operator*(const E &v) const
     {
-      Self mat = *this;
+      Self mat = *self();
       return mat *= v;
     }
 
+    /**
+     * @brief Adds @a x scaled by @a s to this in a single pass
+     * 
+     * Equivalent to `*this += x * s` without the temporary
+     * 
+     * @param x Matrix to be scaled and added
+     * @param s Scale factor
+     * @return A reference to this
+     */
+    Self &addScaled(const Mat &x, const E &s)
+    {
+      PJMATH_COUNT(mat_elementwise);
+      kernels::addScaled(this->data(), x.data(), s, this->size());
+      return *self();
+    }
+
+    /**
+     * @brief Adds the element-wise product of @a a and @a b to this in a single pass
+     * 
+     * @param a Left factor
+     * @param b Right factor
+     * @return A reference to this
+     */
+    Self &madd(const Mat &a, const Mat &b)
+    {
+      PJMATH_COUNT(mat_elementwise);
+      kernels::madd(this->data(), a.data(), b.data(), this->size());
+      return *self();
+    }
+
+    /**
+     * @brief Multiplies this element-wise by @a m and adds @a c in a single pass
+     * 
+     * @param m Element-wise factor
+     * @param c Addend
+     * @return A reference to this
+     */
+    Self &fma(const Mat &m, const Mat &c)
+    {
+      PJMATH_COUNT(mat_elementwise);
+      kernels::fma(this->data(), m.data(), c.data(), this->size());
+      return *self();
+    }
+
+    /**
+     * @brief Linearly interpolates this towards @a to in a single pass
+     * 
+     * @param to Matrix reached when @a t is one
+     * @param t Interpolation factor
+     * @return A reference to this
+     */
+    Self &lerp(const Mat &to, const E &t)
+    {
+      PJMATH_COUNT(mat_elementwise);
+      kernels::lerp(this->data(), this->data(), to.data(), t, this->size());
+      return *self();
+    }
+
     /**
      * @brief Multiplies this matrix by @a rhs and returns the result
      * 
+     * @a rhs may also be a view, a transposed view is multiplied without being copied
+     * 
      * @tparam Rhs Type of the matrix to multiply by
      * @tparam Product The result matrix type
      * @param rhs The matrix to multiply by
@@ -215,23 +390,15 @@ namespace pjmath
               typename Product =
                   std::conditional_t<column_count == Rhs::column_count,
                                      Self,
-                                     std::conditional_t<row_count == Rhs::row_count, Rhs,
+                                     std::conditional_t<row_count == Rhs::row_count, typename Rhs::Self,
                                                         Mat<E, row_count, Rhs::column_count>>>>
     Product operator*(const Rhs &rhs) const
     {
+      PJMATH_COUNT(mat_multiply);
       static_assert(column_count == Rhs::row_count);
 
-      Product product = Product::zero();
-      for (size_type row = 0; row < Product::row_count; row++)
-      {
-        for (size_type col = 0; col < Product::column_count; col++)
-        {
-          for (size_type i = 0; i < column_count; i++)
-          {
-            product.at(row, col) += this->at(row, i) * rhs.at(i, col);
-          }
-        }
-      }
+      Product product;
+      kernels::multiply(*this, rhs, product);
       return product;
     }
 
@@ -248,6 +415,80 @@ namespace pjmath
       return *self() = *self() * rhs;
     }
 
+    /**
+     * @brief Raises this square matrix to a non-negative integer power
+     *
+     * Uses binary exponentiation, so an exponent of n takes at most 2 log2(n) products. The
+     * products alternate between three buffers instead of constructing a matrix per step.
+     *
+     * @param exponent Power to raise to, zero gives the identity
+     * @return This matrix multiplied by itself @a exponent times
+     */
+    template <typename T = Self>
+    std::enable_if_t<M == N, T> pow(uint64_t exponent) const
+    {
+      if (exponent == 0)
+      {
+        return Self::identity();
+      }
+      return raise(*self(), exponent, [](const Self &lhs, const Self &rhs, Self &out) {
+        PJMATH_COUNT(mat_multiply);
+        kernels::multiply(lhs, rhs, out);
+      });
+    }
+
+    /**
+     * @brief Raises this square integer matrix to a power modulo @a modulus
+     *
+     * Elements are converted to Montgomery form once, each product element then accumulates
+     * its terms at 128-bit width and is reduced once, so no division happens per step. Suited
+     * to linear recurrences and transition matrices raised to exponents up to 2^64 - 1.
+     *
+     * @param exponent Power to raise to, zero gives the identity
+     * @param modulus Odd modulus, greater than one and less than 2^63, typically a prime
+     * @return The power with every element reduced to [0, @a modulus)
+     */
+    template <typename T = Self>
+    std::enable_if_t<M == N && std::is_integral_v<E>, T> powMod(uint64_t exponent, uint64_t modulus) const
+    {
+      using Residues = std::array<uint64_t, M * N>;
+      Montgomery arithmetic(modulus);
+      if (exponent == 0)
+      {
+        return Self::identity();
+      }
+      Residues base;
+      for (size_type i = 0; i < this->size(); i++)
+      {
+        if constexpr (std::is_signed_v<E>)
+        {
+          base[i] = arithmetic.toMontgomery(int64_t((*this)[i]));
+        }
+        else
+        {
+          base[i] = arithmetic.toMontgomery(uint64_t((*this)[i]) % modulus);
+        }
+      }
+
+      Residues power = raise(base, exponent, [&arithmetic](const Residues &lhs, const Residues &rhs, Residues &out) {
+        PJMATH_COUNT(mat_multiply);
+        for (size_type row = 0; row < M; row++)
+        {
+          for (size_type column = 0; column < N; column++)
+          {
+            out[row * N + column] = arithmetic.dot(lhs.data() + row * N, 1, rhs.data() + column, N, N);
+          }
+        }
+      });
+
+      Self result;
+      for (size_type i = 0; i < this->size(); i++)
+      {
+        result[i] = E(arithmetic.fromMontgomery(power[i]));
+      }
+      return result;
+    }
+
     /**
      * @brief Fills every cell in the matrix with @a value
      * 
@@ -324,6 +565,98 @@ namespace pjmath
       return Self::diagonal(1);
     }
 
+    /**
+     * @brief Gets a view of an h by w block of this matrix
+     * 
+     * @tparam r Row of the top left element of the block
+     * @tparam c Column of the top left element of the block
+     * @tparam h Number of rows in the block
+     * @tparam w Number of columns in the block
+     * @return A view which aliases the elements of the block
+     */
+    template <size_type r, size_type c, size_type h, size_type w>
+    MatView<E, h, w, N> block()
+    {
+      static_assert(r + h <= M && c + w <= N);
+      return MatView<E, h, w, N>(this->data() + r * N + c);
+    }
+
+    /**
+     * @brief Gets a read-only view of an h by w block of this matrix
+     * 
+     * @tparam r Row of the top left element of the block
+     * @tparam c Column of the top left element of the block
+     * @tparam h Number of rows in the block
+     * @tparam w Number of columns in the block
+     * @return A view which aliases the elements of the block
+     */
+    template <size_type r, size_type c, size_type h, size_type w>
+    MatView<const E, h, w, N> block() const
+    {
+      static_assert(r + h <= M && c + w <= N);
+      return MatView<const E, h, w, N>(this->data() + r * N + c);
+    }
+
+    /**
+     * @brief Gets a view of a row of this matrix
+     * 
+     * @param r Row
+     * @return A 1 by N view which aliases the row
+     */
+    MatView<E, 1, N, N> row(size_type r)
+    {
+      if (r >= M)
+      {
+        throw std::out_of_range("Mat::row");
+      }
+      return MatView<E, 1, N, N>(this->data() + r * N);
+    }
+
+    /**
+     * @brief Gets a read-only view of a row of this matrix
+     * 
+     * @param r Row
+     * @return A 1 by N view which aliases the row
+     */
+    MatView<const E, 1, N, N> row(size_type r) const
+    {
+      if (r >= M)
+      {
+        throw std::out_of_range("Mat::row");
+      }
+      return MatView<const E, 1, N, N>(this->data() + r * N);
+    }
+
+    /**
+     * @brief Gets a view of a column of this matrix
+     * 
+     * @param c Column
+     * @return An M by 1 view which aliases the column
+     */
+    MatView<E, M, 1, N> col(size_type c)
+    {
+      if (c >= N)
+      {
+        throw std::out_of_range("Mat::col");
+      }
+      return MatView<E, M, 1, N>(this->data() + c);
+    }
+
+    /**
+     * @brief Gets a read-only view of a column of this matrix
+     * 
+     * @param c Column
+     * @return An M by 1 view which aliases the column
+     */
+    MatView<const E, M, 1, N> col(size_type c) const
+    {
+      if (c >= N)
+      {
+        throw std::out_of_range("Mat::col");
+      }
+      return MatView<const E, M, 1, N>(this->data() + c);
+    }
+
     /**
      * @brief Returns the transpose of this matrix
      * 
@@ -342,10 +675,34 @@ namespace pjmath
       return mat;
     }
 
+    /**
+     * @brief Gets a transposed view of this matrix
+     * 
+     * Unlike @ref Mat::transposed nothing is copied, and multiplying by the view selects
+     * a kernel suited to the transposed layout.
+     * 
+     * @return An N by M view which aliases the elements of this matrix
+     */
+    MatView<E, N, M, 1, N> transposedView()
+    {
+      return MatView<E, N, M, 1, N>(this->data());
+    }
+
+    /**
+     * @brief Gets a read-only transposed view of this matrix
+     * 
+     * @return An N by M view which aliases the elements of this matrix
+     */
+    MatView<const E, N, M, 1, N> transposedView() const
+    {
+      return MatView<const E, N, M, 1, N>(this->data());
+    }
+
     /**
      * @brief Transposes the elements of this matrix
      * 
-     * @ref Mat::is_square must be true since this performs the transpose in place
+     * @ref Mat::is_square must be true since this performs the transpose in place.
+     * Only the elements above the diagonal are visited, so each pair is swapped once.
      * 
      * @return A reference to this
      */
@@ -354,29 +711,56 @@ namespace pjmath
     {
       for (size_type row = 0; row < row_count; row++)
       {
-        for (size_type column = 0; column < column_count; column++)
+        for (size_type column = row + 1; column < column_count; column++)
         {
-          E temp = this->at(row, column);
-          this->at(row, column) = this->at(column, row);
-          this->at(column, row) = temp;
+          std::swap((*this)[row * N + column], (*this)[column * N + row]);
         }
       }
-      return *this;
+      return *self();
     }
 
     /**
      * @brief Computes the sum of all elements in the matrix
      * 
+     * @param mode Accuracy mode of the summation
      * @return The sum of all elements in the matrix
      */
-    E sum() const
+    E sum(Summation mode = Summation::fast) const
     {
-      E ret{};
-      for (const E &value : *this)
+      return kernels::sum(this->data(), this->size(), mode);
+    }
+
+  private:
+    /**
+     * Binary exponentiation for a positive @a exponent, `multiply(lhs, rhs, out)` writes a
+     * product into a buffer distinct from both operands. The three buffers rotate so nothing
+     * is copied per step, and the identity is never multiplied in.
+     */
+    template <typename V, typename Multiply>
+    static V raise(V base, uint64_t exponent, Multiply &&multiply)
+    {
+      V scratch;
+      V *square = &base;
+      V *spare = &scratch;
+      for (; (exponent & 1) == 0; exponent >>= 1)
+      {
+        multiply(*square, *square, *spare);
+        std::swap(square, spare);
+      }
+
+      V result = *square;
+      V *power = &result;
+      while ((exponent >>= 1) > 0)
       {
-        ret += value;
+        multiply(*square, *square, *spare);
+        std::swap(square, spare);
+        if (exponent & 1)
+        {
+          multiply(*power, *square, *spare);
+          std::swap(power, spare);
+        }
       }
-      return ret;
+      return *power;
     }
 
   protected:
@@ -1,17 +1,99 @@
-
 #pragma once
 
 #include "mat.hpp"
 #include "definitions.hpp"
+#include "math_funcs.hpp"
+#include "vec3.hpp"
+#include "vec4.hpp"
 
 namespace pjmath
 {
   /**
    * @brief 3x3 Matrix type
+   *
+   * Rotations act on column vectors, `r * v`, and positive angles turn counterclockwise when
+   * looking down the axis towards the origin.
    */
   class Mat3 : public Mat<real_t, 3, 3, Mat3>
   {
   public:
     using Mat::Mat; ///< Inherit constructors
+
+    /**
+     * @brief Rotation about the x axis by @a angle radians
+     */
+    static Mat3 rotationX(real_t angle)
+    {
+      real_t s, c;
+      SinCos(angle, s, c);
+      return Mat3{1, 0, 0,
+                  0, c, -s,
+                  0, s, c};
+    }
+
+    /**
+     * @brief Rotation about the y axis by @a angle radians
+     */
+    static Mat3 rotationY(real_t angle)
+    {
+      real_t s, c;
+      SinCos(angle, s, c);
+      return Mat3{c, 0, s,
+                  0, 1, 0,
+                  -s, 0, c};
+    }
+
+    /**
+     * @brief Rotation about the z axis by @a angle radians
+     */
+    static Mat3 rotationZ(real_t angle)
+    {
+      real_t s, c;
+      SinCos(angle, s, c);
+      return Mat3{c, -s, 0,
+                  s, c, 0,
+                  0, 0, 1};
+    }
+
+    /**
+     * @brief Rotation about an arbitrary axis by @a angle radians, Rodrigues' formula
+     *
+     * @param axis Unit length rotation axis
+     * @param angle Angle in radians
+     */
+    static Mat3 rotation(const Vec3 &axis, real_t angle)
+    {
+      real_t s, c;
+      SinCos(angle, s, c);
+      real_t t = 1 - c;
+      real_t x = axis.x(), y = axis.y(), z = axis.z();
+      real_t txy = t * x * y, txz = t * x * z, tyz = t * y * z;
+      return Mat3{t * x * x + c, txy - s * z, txz + s * y,
+                  txy + s * z, t * y * y + c, tyz - s * x,
+                  txz - s * y, tyz + s * x, t * z * z + c};
+    }
+
+    /**
+     * @brief Rotation of a unit quaternion stored as (x, y, z, w)
+     */
+    static Mat3 fromQuaternion(const Vec4 &q)
+    {
+      real_t x = q.x(), y = q.y(), z = q.z(), w = q.w();
+      real_t xx = 2 * x * x, yy = 2 * y * y, zz = 2 * z * z;
+      real_t xy = 2 * x * y, xz = 2 * x * z, yz = 2 * y * z;
+      real_t wx = 2 * w * x, wy = 2 * w * y, wz = 2 * w * z;
+      return Mat3{1 - yy - zz, xy - wz, xz + wy,
+                  xy + wz, 1 - xx - zz, yz - wx,
+                  xz - wy, yz + wx, 1 - xx - yy};
+    }
   };
-}
\ No newline at end of file
+
+#if !defined(PJMATH_NO_EXTERN_TEMPLATES)
+  // Compiled once into the library, see src/pjmath/mat.cpp
+  extern template class Mat<real_t, 3, 3, Mat3>;
+  extern template Mat3 Mat<real_t, 3, 3, Mat3>::operator*(const Mat3 &) const;
+  extern template Vec3 Mat<real_t, 3, 3, Mat3>::operator*(const Vec3 &) const;
+  extern template Mat3 &Mat<real_t, 3, 3, Mat3>::operator*=(const Mat &);
+  extern template Mat3 Mat<real_t, 3, 3, Mat3>::pow(uint64_t) const;
+#endif
+}
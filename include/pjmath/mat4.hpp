@@ -1,8 +1,10 @@
-
 #pragma once
 
 #include "mat.hpp"
+#include "mat3.hpp"
 #include "definitions.hpp"
+#include "vec3.hpp"
+#include "vec4.hpp"
 
 namespace pjmath
 {
@@ -13,6 +15,40 @@ namespace pjmath
   {
   public:
     using Mat::Mat; ///< Inherit constructors
+
+    /**
+     * @brief Builds T * R * S directly, without the two matrix products
+     *
+     * @param translation Translation, the last column
+     * @param rotation Rotation applied after the scale
+     * @param scale Scale along each axis, applied first
+     * @return The affine transform scaling, then rotating, then translating a point
+     */
+    static Mat4 fromTRS(const Vec3 &translation, const Mat3 &rotation, const Vec3 &scale)
+    {
+      const real_t *r = rotation.data();
+      real_t sx = scale.x(), sy = scale.y(), sz = scale.z();
+      return Mat4{r[0] * sx, r[1] * sy, r[2] * sz, translation.x(),
+                  r[3] * sx, r[4] * sy, r[5] * sz, translation.y(),
+                  r[6] * sx, r[7] * sy, r[8] * sz, translation.z(),
+                  0, 0, 0, 1};
+    }
+
+    /**
+     * @brief Builds T * R * S from a unit quaternion stored as (x, y, z, w)
+     */
+    static Mat4 fromTRS(const Vec3 &translation, const Vec4 &rotation, const Vec3 &scale)
+    {
+      return fromTRS(translation, Mat3::fromQuaternion(rotation), scale);
+    }
   };
 
-}
\ No newline at end of file
+#if !defined(PJMATH_NO_EXTERN_TEMPLATES)
+  // Compiled once into the library, see src/pjmath/mat.cpp
+  extern template class Mat<real_t, 4, 4, Mat4>;
+  extern template Mat4 Mat<real_t, 4, 4, Mat4>::operator*(const Mat4 &) const;
+  extern template Vec4 Mat<real_t, 4, 4, Mat4>::operator*(const Vec4 &) const;
+  extern template Mat4 &Mat<real_t, 4, 4, Mat4>::operator*=(const Mat &);
+  extern template Mat4 Mat<real_t, 4, 4, Mat4>::pow(uint64_t) const;
+#endif
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "mat.hpp"
+
+namespace pjmath
+{
+  namespace detail
+  {
+    /**
+     * @brief Cheapest parenthesization of a chain of Count matrices
+     */
+    template <size_t Count>
+    struct ChainOrder
+    {
+      std::array<std::array<size_t, Count>, Count> split{}; ///< Last product of the range [i, j] is [i, split] * [split + 1, j]
+      size_t cost = 0;                                      ///< Scalar multiplications of the whole chain
+    };
+
+    /**
+     * @brief Classic matrix-chain dynamic programming over the shapes of the operands
+     *
+     * @param dims Matrix i is dims[i] by dims[i + 1]
+     */
+    template <size_t Count>
+    constexpr ChainOrder<Count> optimalChainOrder(const std::array<size_t, Count + 1> &dims)
+    {
+      std::array<std::array<size_t, Count>, Count> best{};
+      ChainOrder<Count> order{};
+      for (size_t length = 2; length <= Count; length++)
+      {
+        for (size_t i = 0; i + length <= Count; i++)
+        {
+          size_t j = i + length - 1;
+          best[i][j] = SIZE_MAX;
+          for (size_t k = i; k < j; k++)
+          {
+            size_t cost = best[i][k] + best[k + 1][j] + dims[i] * dims[k + 1] * dims[j + 1];
+            if (cost < best[i][j])
+            {
+              best[i][j] = cost;
+              order.split[i][j] = k;
+            }
+          }
+        }
+      }
+      order.cost = best[0][Count - 1];
+      return order;
+    }
+
+    template <typename... Operands>
+    constexpr bool chainConforms()
+    {
+      constexpr size_t rows[] = {Operands::row_count...};
+      constexpr size_t columns[] = {Operands::column_count...};
+      for (size_t k = 1; k < sizeof...(Operands); k++)
+      {
+        if (rows[k] != columns[k - 1])
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    template <size_t Count>
+    constexpr size_t leftToRightChainCost(const std::array<size_t, Count + 1> &dims)
+    {
+      size_t cost = 0;
+      for (size_t k = 1; k < Count; k++)
+      {
+        cost += dims[0] * dims[k] * dims[k + 1];
+      }
+      return cost;
+    }
+  }
+
+  /**
+   * @brief Lazily captured product of matrices, evaluated in the cheapest order
+   *
+   * Built with @ref chain, extended with `*`, and evaluated by @ref eval or by conversion to
+   * @ref Product. The parenthesization comes from the operand shapes at compile time, so a
+   * 3x64 * 64x64 * 64x1 chain computes the matrix-vector product first and costs 4288
+   * multiplications instead of 12480 from left to right.
+   *
+   * Only pointers to the operands are kept, they must outlive the evaluation. Evaluating
+   * within the expression that builds the chain is always safe.
+   *
+   * @tparam Operands `Mat` or `MatView` types, in product order
+   */
+  template <typename... Operands>
+  class MatChain
+  {
+    template <typename... Others>
+    friend class MatChain;
+
+    using First = std::tuple_element_t<0, std::tuple<Operands...>>;
+
+  public:
+    static constexpr size_t length = sizeof...(Operands); ///< Number of operands
+
+    /**
+     * @brief Type of the product evaluated from left to right, as `Mat::operator*` deduces it
+     */
+    using Product = std::decay_t<decltype((... * std::declval<const Operands &>()))>;
+
+    static constexpr std::array<size_t, length + 1> dims = {First::row_count, Operands::column_count...};
+
+    static_assert(detail::chainConforms<Operands...>(), "every operand must have as many rows as the previous one has columns");
+
+    static constexpr detail::ChainOrder<length> order = detail::optimalChainOrder<length>(dims);
+
+    static constexpr size_t optimal_cost = order.cost;                                      ///< Multiplications in the chosen order
+    static constexpr size_t left_to_right_cost = detail::leftToRightChainCost<length>(dims); ///< Multiplications from left to right
+
+    /**
+     * @param operands Operands of the product, in order
+     */
+    explicit MatChain(const Operands &...operands) : operands_(&operands...)
+    {
+    }
+
+    /**
+     * @brief Appends an operand to the chain without evaluating anything
+     */
+    template <typename Rhs>
+    MatChain<Operands..., Rhs> operator*(const Rhs &rhs) const
+    {
+      return MatChain<Operands..., Rhs>(std::tuple_cat(operands_, std::tuple<const Rhs *>(&rhs)));
+    }
+
+    /**
+     * @brief Computes the product in the cheapest order
+     */
+    Product eval() const
+    {
+      return Product(evaluate<0, length - 1>());
+    }
+
+    operator Product() const
+    {
+      return eval();
+    }
+
+    /**
+     * @return The index k for which the range [@a i, @a j] is evaluated as [i, k] * [k + 1, j]
+     */
+    static constexpr size_t split(size_t i, size_t j)
+    {
+      return order.split[i][j];
+    }
+
+  private:
+    explicit MatChain(std::tuple<const Operands *...> operands) : operands_(operands)
+    {
+    }
+
+    template <size_t I, size_t J>
+    decltype(auto) evaluate() const
+    {
+      if constexpr (I == J)
+      {
+        return *std::get<I>(operands_);
+      }
+      else
+      {
+        constexpr size_t k = order.split[I][J];
+        return evaluate<I, k>() * evaluate<k + 1, J>();
+      }
+    }
+
+    std::tuple<const Operands *...> operands_;
+  };
+
+  /**
+   * @brief Captures a product of matrices for evaluation in the cheapest order
+   *
+   * `Vec3 y = chain(a, b, c) * x;` evaluates a * b * c * x with the fewest multiplications.
+   *
+   * @param operands Operands of the product, in order
+   */
+  template <typename... Operands>
+  MatChain<Operands...> chain(const Operands &...operands)
+  {
+    static_assert(sizeof...(Operands) > 0);
+    return MatChain<Operands...>(operands...);
+  }
+}
@@ -0,0 +1,332 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+#include "kernels.hpp"
+
+namespace pjmath
+{
+  template <typename E, size_t M, size_t N, typename Derived>
+  class Mat;
+
+  /**
+   * @brief A non-owning view of an M by N region of a matrix
+   *
+   * Views are obtained through @ref Mat::block, @ref Mat::row, @ref Mat::col and
+   * @ref Mat::transposedView. A view aliases
+   * the storage of the matrix it was taken from, writes through the view are visible in that
+   * matrix, and the view must not outlive it.
+   *
+   * Copying a view copies the reference, assigning to a view copies the elements.
+   *
+   * @tparam E Element type, const qualified for a read-only view
+   * @tparam M Number of rows in the view
+   * @tparam N Number of columns in the view
+   * @tparam RowStride Number of elements between the starts of two consecutive rows
+   * @tparam ColStride Number of elements between the starts of two consecutive columns
+   */
+  template <typename E, size_t M, size_t N, size_t RowStride, size_t ColStride = 1>
+  class MatView
+  {
+  public:
+    using value_type = std::remove_const_t<E>;                ///< Element type without qualifiers
+    using size_type = size_t;                                 ///< Index type
+    using Self = Mat<value_type, M, N, void>;                 ///< Owning matrix type produced by operations on the view
+    using Transpose = MatView<E, N, M, ColStride, RowStride>; ///< Type for a transposed view of this view
+
+    static constexpr size_type row_count = M;             ///< Number of rows
+    static constexpr size_type column_count = N;          ///< Number of columns
+    static constexpr size_type row_stride = RowStride;    ///< Distance in elements between consecutive rows
+    static constexpr size_type column_stride = ColStride; ///< Distance in elements between consecutive columns
+
+    static_assert(row_count > 0);
+    static_assert(column_count > 0);
+
+    /**
+     * @brief Constructs a view whose top left element is at @a data
+     *
+     * @param data Pointer to the first element of the view
+     */
+    explicit MatView(E *data) : data_(data)
+    {
+    }
+
+    MatView(const MatView &) = default;
+
+    /**
+     * @brief Copies the elements of @a other into the viewed region
+     *
+     * @param other View of the same shape
+     * @return A reference to this
+     */
+    MatView &operator=(const MatView &other)
+    {
+      return assign(other);
+    }
+
+    /**
+     * @brief Copies the elements of a matrix or view of the same shape into the viewed region
+     *
+     * @tparam Other Matrix or view type
+     * @param other Source of the elements
+     * @return A reference to this
+     */
+    template <typename Other>
+    MatView &operator=(const Other &other)
+    {
+      return assign(other);
+    }
+
+    /**
+     * @return The number of elements in the view
+     */
+    static constexpr size_type size()
+    {
+      return M * N;
+    }
+
+    /**
+     * @return Pointer to the top left element of the view
+     */
+    E *data() const
+    {
+      return data_;
+    }
+
+    /**
+     * @brief Gets the element at the given row and column
+     *
+     * @param r Row
+     * @param c Column
+     * @return Reference to the element
+     */
+    E &at(size_type r, size_type c) const
+    {
+      if (r >= M || c >= N)
+      {
+        throw std::out_of_range("MatView::at");
+      }
+      return element(r, c);
+    }
+
+    /**
+     * @brief Gets the element at the given row and column
+     *
+     * @tparam r Row
+     * @tparam c Column
+     * @return Reference to the element
+     */
+    template <size_type r, size_type c>
+    E &get() const
+    {
+      static_assert(r < M && c < N);
+      return element(r, c);
+    }
+
+    /**
+     * @brief Element-wise addition
+     *
+     * @tparam Other Matrix or view type of the same shape
+     * @param rhs Matrix to be added to the viewed region
+     * @return A reference to this
+     */
+    template <typename Other>
+    MatView &operator+=(const Other &rhs)
+    {
+      static_assert(Other::row_count == M && Other::column_count == N);
+      for (size_type r = 0; r < M; r++)
+      {
+        for (size_type c = 0; c < N; c++)
+        {
+          element(r, c) += rhs.at(r, c);
+        }
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Element-wise subtraction
+     *
+     * @tparam Other Matrix or view type of the same shape
+     * @param rhs The minuend
+     * @return A reference to this
+     */
+    template <typename Other>
+    MatView &operator-=(const Other &rhs)
+    {
+      static_assert(Other::row_count == M && Other::column_count == N);
+      for (size_type r = 0; r < M; r++)
+      {
+        for (size_type c = 0; c < N; c++)
+        {
+          element(r, c) -= rhs.at(r, c);
+        }
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Element-wise multiplication by a scalar
+     *
+     * @param v Multiplication factor
+     * @return A reference to this
+     */
+    MatView &operator*=(const value_type &v)
+    {
+      for (size_type r = 0; r < M; r++)
+      {
+        for (size_type c = 0; c < N; c++)
+        {
+          element(r, c) *= v;
+        }
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Fills every cell in the viewed region with @a value
+     *
+     * @param value The value used to fill
+     * @return A reference to this
+     */
+    MatView &fill(const value_type &value)
+    {
+      for (size_type r = 0; r < M; r++)
+      {
+        for (size_type c = 0; c < N; c++)
+        {
+          element(r, c) = value;
+        }
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Element-wise addition
+     *
+     * @tparam Other Matrix or view type of the same shape
+     * @param rhs Matrix to be added with this
+     * @return A new matrix holding the sum
+     */
+    template <typename Other>
+    Self operator+(const Other &rhs) const
+    {
+      Self mat(*this);
+      mat += rhs;
+      return mat;
+    }
+
+    /**
+     * @brief Element-wise subtraction
+     *
+     * @tparam Other Matrix or view type of the same shape
+     * @param rhs The minuend
+     * @return A new matrix holding the difference
+     */
+    template <typename Other>
+    Self operator-(const Other &rhs) const
+    {
+      Self mat(*this);
+      mat -= rhs;
+      return mat;
+    }
+
+    /**
+     * @brief Element-wise negation
+     *
+     * @return A new matrix where all the elements are negated from this
+     */
+    Self operator-() const
+    {
+      return -Self(*this);
+    }
+
+    /**
+     * @brief Element-wise multiplication by a scalar
+     *
+     * @param v Multiplication factor
+     * @return A new matrix whose elements are the viewed elements multiplied by @a v
+     */
+    Self operator*(const value_type &v) const
+    {
+      Self mat(*this);
+      mat *= v;
+      return mat;
+    }
+
+    /**
+     * @brief Multiplies the viewed region by @a rhs without copying either operand
+     *
+     * @tparam Rhs Type of the matrix or view to multiply by
+     * @tparam Product The result matrix type
+     * @param rhs The matrix to multiply by
+     * @return Result matrix
+     */
+    template <typename Rhs,
+              typename Product =
+                  std::conditional_t<column_count == Rhs::column_count,
+                                     Self,
+                                     std::conditional_t<row_count == Rhs::row_count, typename Rhs::Self,
+                                                        Mat<value_type, row_count, Rhs::column_count, void>>>>
+    Product operator*(const Rhs &rhs) const
+    {
+      static_assert(column_count == Rhs::row_count);
+
+      Product product;
+      kernels::multiply(*this, rhs, product);
+      return product;
+    }
+
+    /**
+     * @brief Gets a transposed view of the viewed region
+     *
+     * @return A view which aliases the same elements with rows and columns swapped
+     */
+    Transpose transposedView() const
+    {
+      return Transpose(data_);
+    }
+
+    /**
+     * @brief Computes the sum of all elements in the viewed region
+     *
+     * @return The sum of all viewed elements
+     */
+    value_type sum() const
+    {
+      value_type ret{};
+      for (size_type r = 0; r < M; r++)
+      {
+        for (size_type c = 0; c < N; c++)
+        {
+          ret += element(r, c);
+        }
+      }
+      return ret;
+    }
+
+  private:
+    E &element(size_type r, size_type c) const
+    {
+      return data_[r * RowStride + c * ColStride];
+    }
+
+    template <typename Other>
+    MatView &assign(const Other &other)
+    {
+      static_assert(Other::row_count == M && Other::column_count == N);
+      for (size_type r = 0; r < M; r++)
+      {
+        for (size_type c = 0; c < N; c++)
+        {
+          element(r, c) = other.at(r, c);
+        }
+      }
+      return *this;
+    }
+
+    E *data_;
+  };
+}
@@ -3,6 +3,7 @@
 #include <math.h>
 
 #include <cstdint>
+#include <type_traits>
 
 #include "definitions.hpp"
 
@@ -18,6 +19,19 @@ namespace pjmath
     return ::sin(x);
   }
 
+  /**
+   * @brief Computes the sine and cosine of @a x with one argument reduction
+   */
+  inline static void SinCos(real_t x, real_t &s, real_t &c)
+  {
+#if defined(__GLIBC__) && defined(_GNU_SOURCE)
+    ::sincos(x, &s, &c);
+#else
+    s = ::sin(x);
+    c = ::cos(x);
+#endif
+  }
+
   inline static real_t Tan(real_t x)
   {
     return ::tan(x);
@@ -37,4 +51,29 @@ namespace pjmath
   {
     return degs * 2.f * PI / 360.f;
   }
+
+  /**
+   * @brief Computes x * y + z
+   *
+   * Floating point arguments are fused into a single rounding when the target has a fast
+   * fma instruction, otherwise this is a plain multiply and add so no slow software fma
+   * is ever called.
+   */
+  template <typename T>
+  inline T Fma(T x, T y, T z)
+  {
+#ifdef FP_FAST_FMA
+    if constexpr (std::is_same_v<T, double>)
+    {
+      return ::fma(x, y, z);
+    }
+#endif
+#ifdef FP_FAST_FMAF
+    if constexpr (std::is_same_v<T, float>)
+    {
+      return ::fmaf(x, y, z);
+    }
+#endif
+    return x * y + z;
+  }
 } // namespace pjmath
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+namespace pjmath
+{
+  /**
+   * @brief Montgomery arithmetic modulo an odd 64-bit modulus
+   *
+   * Values in Montgomery form are stored as `x * 2^64 mod m`, which turns the division of a
+   * modular product into two multiplications and a shift. Convert operands once with
+   * @ref toMontgomery, chain as many @ref multiply and @ref add calls as needed, and convert
+   * back with @ref fromMontgomery.
+   */
+  class Montgomery
+  {
+  public:
+    using wide_type = unsigned __int128;
+
+    /**
+     * @param modulus Odd modulus, greater than one and less than 2^63
+     */
+    explicit Montgomery(uint64_t modulus) : modulus_(modulus)
+    {
+      if (modulus < 3 || modulus % 2 == 0 || modulus >= (uint64_t(1) << 63))
+      {
+        throw std::invalid_argument("Montgomery modulus must be odd and in [3, 2^63)");
+      }
+      // Newton iteration doubles the number of correct low bits of the inverse each step
+      uint64_t inverse = modulus;
+      for (size_t i = 0; i < 5; i++)
+      {
+        inverse *= 2 - modulus * inverse;
+      }
+      negInverse_ = 0 - inverse;
+      uint64_t r = (0 - modulus) % modulus;
+      r2_ = uint64_t(wide_type(r) * r % modulus);
+      limit_ = wide_type(modulus) << 64;
+    }
+
+    /**
+     * @return The modulus
+     */
+    uint64_t modulus() const
+    {
+      return modulus_;
+    }
+
+    /**
+     * @brief Converts a residue in [0, m) to Montgomery form
+     */
+    uint64_t toMontgomery(uint64_t value) const
+    {
+      return multiply(value, r2_);
+    }
+
+    /**
+     * @brief Converts any signed integer to Montgomery form, reducing it first
+     */
+    uint64_t toMontgomery(int64_t value) const
+    {
+      int64_t residue = value % int64_t(modulus_);
+      return toMontgomery(uint64_t(residue < 0 ? residue + int64_t(modulus_) : residue));
+    }
+
+    /**
+     * @brief Converts a value in Montgomery form back to a residue in [0, m)
+     */
+    uint64_t fromMontgomery(uint64_t value) const
+    {
+      return reduce(value);
+    }
+
+    /**
+     * @brief Divides @a value by 2^64 modulo m
+     *
+     * @param value Any value less than m * 2^64
+     * @return A residue in [0, m)
+     */
+    uint64_t reduce(wide_type value) const
+    {
+      uint64_t q = uint64_t(value) * negInverse_;
+      // m < 2^63 keeps the sum below 2^128
+      uint64_t t = uint64_t((value + wide_type(q) * modulus_) >> 64);
+      return t >= modulus_ ? t - modulus_ : t;
+    }
+
+    /**
+     * @brief Multiplies two values in Montgomery form
+     */
+    uint64_t multiply(uint64_t a, uint64_t b) const
+    {
+      return reduce(wide_type(a) * b);
+    }
+
+    /**
+     * @brief Adds two residues, also valid for values in Montgomery form
+     */
+    uint64_t add(uint64_t a, uint64_t b) const
+    {
+      uint64_t sum = a + b;
+      return sum >= modulus_ ? sum - modulus_ : sum;
+    }
+
+    /**
+     * @brief Sum of the products of two strided sequences in Montgomery form
+     *
+     * Products are accumulated at full width and only reduced once at the end.
+     *
+     * @param a First sequence, @a n values @a aStride apart
+     * @param b Second sequence, @a n values @a bStride apart
+     * @return The sum of products in Montgomery form
+     */
+    uint64_t dot(const uint64_t *a, size_t aStride, const uint64_t *b, size_t bStride, size_t n) const
+    {
+      // Subtracting m * 2^64 keeps the sum below the input range of reduce without changing it modulo m
+      wide_type sum = 0;
+      for (size_t k = 0; k < n; k++)
+      {
+        sum += wide_type(a[k * aStride]) * b[k * bStride];
+        if (sum >= limit_)
+        {
+          sum -= limit_;
+        }
+      }
+      return reduce(sum);
+    }
+
+    /**
+     * @brief Raises a value in Montgomery form to a power
+     *
+     * @return @a base to the power of @a exponent, in Montgomery form
+     */
+    uint64_t pow(uint64_t base, uint64_t exponent) const
+    {
+      uint64_t result = toMontgomery(uint64_t(1));
+      while (exponent > 0)
+      {
+        if (exponent & 1)
+        {
+          result = multiply(result, base);
+        }
+        base = multiply(base, base);
+        exponent >>= 1;
+      }
+      return result;
+    }
+
+  private:
+    uint64_t modulus_;
+    uint64_t negInverse_ = 0; ///< -m^-1 mod 2^64
+    uint64_t r2_ = 0;         ///< 2^128 mod m
+    wide_type limit_ = 0;     ///< m * 2^64
+  };
+
+  /**
+   * @brief Computes @a base to the power of @a exponent modulo @a modulus
+   *
+   * @param base Any integer, negative values are reduced to [0, m)
+   * @param exponent Non-negative exponent
+   * @param modulus Odd modulus, greater than one and less than 2^63
+   * @return The residue in [0, m)
+   */
+  template <typename Integer>
+  Integer powMod(Integer base, uint64_t exponent, uint64_t modulus)
+  {
+    static_assert(std::is_integral_v<Integer>);
+    Montgomery arithmetic(modulus);
+    uint64_t value = 0;
+    if constexpr (std::is_signed_v<Integer>)
+    {
+      value = arithmetic.toMontgomery(int64_t(base));
+    }
+    else
+    {
+      value = arithmetic.toMontgomery(uint64_t(base % modulus));
+    }
+    return Integer(arithmetic.fromMontgomery(arithmetic.pow(value, exponent)));
+  }
+}
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+#include "batch.hpp"
+#include "definitions.hpp"
+#include "dispatch.hpp"
+
+/**
+ * Reduced precision storage for bulk vectors.
+ *
+ * The packed types only store values, arithmetic happens on `Vector3` or `Vec3` after
+ * decoding. A double precision three dimensional vector takes 24 bytes, half and bfloat16
+ * vectors take 6 and octahedral unit vectors take 4.
+ *
+ * Values are rounded to single precision before they are packed, so encoding matches the
+ * hardware conversion instructions wherever they are used.
+ */
+namespace pjmath
+{
+  namespace detail
+  {
+    inline uint32_t floatBits(float value)
+    {
+      uint32_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      return bits;
+    }
+
+    inline float bitsFloat(uint32_t bits)
+    {
+      float value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+
+    /**
+     * @brief Rounds a float to the nearest half, ties to even, NaNs become the quiet NaN
+     */
+    inline uint16_t floatToHalf(float value)
+    {
+      uint32_t bits = floatBits(value);
+      uint32_t sign = (bits >> 16) & 0x8000;
+      bits &= 0x7fffffff;
+
+      if (bits >= 0x47800000)
+      {
+        // 2^16 and up, infinities and NaNs
+        return uint16_t(sign | (bits > 0x7f800000 ? 0x7e00 : 0x7c00));
+      }
+      if (bits < 0x38800000)
+      {
+        // Below the smallest normal half, adding 0.5 lets the FPU round the subnormal mantissa
+        float rounded = bitsFloat(bits) + bitsFloat(0x3f000000);
+        return uint16_t(sign | (floatBits(rounded) - 0x3f000000));
+      }
+      // Rebias the exponent and round, a carry out of the mantissa rounds up to infinity
+      uint32_t odd = (bits >> 13) & 1;
+      bits += 0xc8000fffu + odd;
+      return uint16_t(sign | (bits >> 13));
+    }
+
+    inline float halfToFloat(uint16_t half)
+    {
+      uint32_t sign = uint32_t(half & 0x8000) << 16;
+      uint32_t exponent = (half >> 10) & 0x1f;
+      uint32_t mantissa = half & 0x3ff;
+      if (exponent == 0)
+      {
+        float magnitude = float(mantissa) * bitsFloat(0x33800000); // 2^-24
+        return bitsFloat(floatBits(magnitude) | sign);
+      }
+      if (exponent == 31)
+      {
+        return bitsFloat(sign | 0x7f800000 | (mantissa << 13));
+      }
+      return bitsFloat(sign | ((exponent + 112) << 23) | (mantissa << 13));
+    }
+
+    /**
+     * @brief Rounds a float to the nearest bfloat16, ties to even, NaNs stay NaNs
+     */
+    inline uint16_t floatToBFloat16(float value)
+    {
+      uint32_t bits = floatBits(value);
+      if ((bits & 0x7fffffff) > 0x7f800000)
+      {
+        return uint16_t((bits >> 16) | 0x40);
+      }
+      bits += 0x7fff + ((bits >> 16) & 1);
+      return uint16_t(bits >> 16);
+    }
+
+    inline float bFloat16ToFloat(uint16_t value)
+    {
+      return bitsFloat(uint32_t(value) << 16);
+    }
+  }
+
+  /**
+   * @brief IEEE 754 binary16, 11 significant bits and a range of ±65504
+   */
+  class Half
+  {
+  public:
+    Half() = default;
+
+    explicit Half(float value) : bits_(detail::floatToHalf(value))
+    {
+    }
+
+    explicit operator float() const
+    {
+      return detail::halfToFloat(bits_);
+    }
+
+    /**
+     * @return The binary16 encoding
+     */
+    uint16_t bits() const
+    {
+      return bits_;
+    }
+
+    static Half fromBits(uint16_t bits)
+    {
+      Half half;
+      half.bits_ = bits;
+      return half;
+    }
+
+    bool operator==(const Half &) const = default;
+
+  private:
+    uint16_t bits_ = 0;
+  };
+
+  /**
+   * @brief Upper half of an IEEE 754 binary32, 8 significant bits and the full float range
+   */
+  class BFloat16
+  {
+  public:
+    BFloat16() = default;
+
+    explicit BFloat16(float value) : bits_(detail::floatToBFloat16(value))
+    {
+    }
+
+    explicit operator float() const
+    {
+      return detail::bFloat16ToFloat(bits_);
+    }
+
+    /**
+     * @return The upper 16 bits of the binary32 encoding
+     */
+    uint16_t bits() const
+    {
+      return bits_;
+    }
+
+    static BFloat16 fromBits(uint16_t bits)
+    {
+      BFloat16 value;
+      value.bits_ = bits;
+      return value;
+    }
+
+    bool operator==(const BFloat16 &) const = default;
+
+  private:
+    uint16_t bits_ = 0;
+  };
+
+  using Half3 = std::array<Half, 3>;         ///< Three dimensional vector of halves, 6 bytes
+  using BFloat16x3 = std::array<BFloat16, 3>; ///< Three dimensional vector of bfloat16s, 6 bytes
+
+  /**
+   * @brief Unit vector projected onto an octahedron and unfolded onto a square, 4 bytes
+   *
+   * Both coordinates are signed normalized 16-bit integers. The angular error after decoding
+   * is below 7e-5 radians over the whole sphere.
+   */
+  struct Octahedral
+  {
+    int16_t u = 0;
+    int16_t v = 0;
+
+    bool operator==(const Octahedral &) const = default;
+  };
+
+  static_assert(sizeof(Half) == sizeof(uint16_t));
+  static_assert(sizeof(Half3) == 6 && sizeof(BFloat16x3) == 6 && sizeof(Octahedral) == 4);
+
+  namespace detail
+  {
+    void encodeBFloat16(const real_t *values, BFloat16 *out, size_t n);
+    void decodeBFloat16(const BFloat16 *values, real_t *out, size_t n);
+    void encodeOctahedral(const real_t *xyz, Octahedral *out, size_t count);
+    void decodeOctahedral(const Octahedral *values, real_t *xyz, size_t count);
+
+    template <typename T>
+    constexpr void checkPackable()
+    {
+      static_assert(std::is_same_v<std::remove_const_t<typename T::value_type>, real_t>);
+      static_assert(sizeof(T) == 3 * sizeof(real_t));
+    }
+  }
+
+  /**
+   * @brief Rounds every vector to half precision
+   *
+   * Uses the F16C conversion instructions when the active instruction set level has them,
+   * see `dispatch::encodeHalf`.
+   *
+   * @tparam T Three dimensional vector type, `Vector3` or `Vec3`
+   * @param vectors Vectors to encode
+   * @param packed Receives one packed vector per vector
+   */
+  template <typename T>
+  void encodeHalf(std::span<const T> vectors, std::span<Half3> packed)
+  {
+    detail::checkPackable<T>();
+    detail::checkBatchSize(vectors, packed);
+    dispatch::encodeHalf(detail::flatten(vectors).data(), reinterpret_cast<uint16_t *>(packed.data()),
+                         3 * vectors.size());
+  }
+
+  /**
+   * @brief Expands half precision vectors, exactly
+   */
+  template <typename T>
+  void decodeHalf(std::span<const Half3> packed, std::span<T> vectors)
+  {
+    detail::checkPackable<T>();
+    detail::checkBatchSize(packed, vectors);
+    dispatch::decodeHalf(reinterpret_cast<const uint16_t *>(packed.data()), detail::flatten(vectors).data(),
+                         3 * packed.size());
+  }
+
+  /**
+   * @brief Rounds every vector to bfloat16 precision
+   *
+   * @tparam T Three dimensional vector type, `Vector3` or `Vec3`
+   * @param vectors Vectors to encode
+   * @param packed Receives one packed vector per vector
+   */
+  template <typename T>
+  void encodeBFloat16(std::span<const T> vectors, std::span<BFloat16x3> packed)
+  {
+    detail::checkPackable<T>();
+    detail::checkBatchSize(vectors, packed);
+    detail::encodeBFloat16(detail::flatten(vectors).data(), reinterpret_cast<BFloat16 *>(packed.data()),
+                           3 * vectors.size());
+  }
+
+  /**
+   * @brief Expands bfloat16 vectors, exactly
+   */
+  template <typename T>
+  void decodeBFloat16(std::span<const BFloat16x3> packed, std::span<T> vectors)
+  {
+    detail::checkPackable<T>();
+    detail::checkBatchSize(packed, vectors);
+    detail::decodeBFloat16(reinterpret_cast<const BFloat16 *>(packed.data()), detail::flatten(vectors).data(),
+                           3 * packed.size());
+  }
+
+  /**
+   * @brief Encodes unit vectors in octahedral form
+   *
+   * Vectors need not be normalized exactly, only their direction is kept. Zero vectors encode
+   * as +z.
+   *
+   * @tparam T Three dimensional vector type, `Vector3` or `Vec3`
+   * @param vectors Directions to encode
+   * @param packed Receives one encoded direction per vector
+   */
+  template <typename T>
+  void encodeOctahedral(std::span<const T> vectors, std::span<Octahedral> packed)
+  {
+    detail::checkPackable<T>();
+    detail::checkBatchSize(vectors, packed);
+    detail::encodeOctahedral(detail::flatten(vectors).data(), packed.data(), vectors.size());
+  }
+
+  /**
+   * @brief Decodes octahedral directions to unit vectors
+   */
+  template <typename T>
+  void decodeOctahedral(std::span<const Octahedral> packed, std::span<T> vectors)
+  {
+    detail::checkPackable<T>();
+    detail::checkBatchSize(packed, vectors);
+    detail::decodeOctahedral(packed.data(), detail::flatten(vectors).data(), packed.size());
+  }
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+namespace pjmath
+{
+  /**
+   * @brief Non-owning reference to a callable invoked as `body(first, last)` over an index range
+   *
+   * Lets executors take any loop body without the allocation of a `std::function`. The
+   * referenced callable must outlive the reference.
+   */
+  class RangeFunction
+  {
+  public:
+    /**
+     * @param body Callable to refer to, copying a reference goes to the copy constructor instead
+     */
+    template <typename Body, typename = std::enable_if_t<!std::is_same_v<std::remove_cv_t<Body>, RangeFunction>>>
+    explicit RangeFunction(Body &body)
+        : context_(const_cast<void *>(static_cast<const void *>(&body))),
+          call_([](void *context, size_t first, size_t last) { (*static_cast<Body *>(context))(first, last); })
+    {
+    }
+
+    /**
+     * @brief Invokes the referenced callable over [@a first, @a last)
+     */
+    void operator()(size_t first, size_t last) const
+    {
+      call_(context_, first, last);
+    }
+
+  private:
+    void *context_;
+    void (*call_)(void *, size_t, size_t);
+  };
+
+  /**
+   * @brief Runs the parallel loops of the library, see @ref setExecutor
+   */
+  class Executor
+  {
+  public:
+    virtual ~Executor() = default;
+
+    /**
+     * @brief Runs @a body over [@a begin, @a end) split into chunks, and returns once every chunk is done
+     *
+     * Chunks must not overlap and must cover the range. Chunks should hold at least @a grain
+     * indices, except when the whole range is smaller. The first exception thrown by @a body
+     * is rethrown once the loop has stopped.
+     *
+     * @param begin First index
+     * @param end One past the last index, greater than @a begin
+     * @param grain Smallest number of indices worth running as a separate task, at least one
+     * @param body Loop body
+     */
+    virtual void parallelFor(size_t begin, size_t end, size_t grain, RangeFunction body) = 0;
+
+    /**
+     * @return Number of threads which may run chunks at the same time
+     */
+    virtual size_t concurrency() const = 0;
+  };
+
+  /**
+   * @brief Installs the executor used by @ref parallelFor and @ref parallelInvoke
+   *
+   * Lets an application run the library's parallel loops on its own scheduler. The executor
+   * must stay alive until it is replaced, and must not be replaced while a loop is running.
+   *
+   * @param executor Executor to use, or nullptr for the built-in @ref ThreadPool::global
+   */
+  void setExecutor(Executor *executor);
+
+  /**
+   * @return The executor installed with @ref setExecutor, or the built-in pool
+   */
+  Executor &currentExecutor();
+
+  /**
+   * @brief Runs @a body over [@a begin, @a end) split into chunks across the current executor
+   *
+   * Loops may nest: a body which runs another parallel loop shares the same workers rather
+   * than starting threads of its own.
+   *
+   * @param begin First index
+   * @param end One past the last index
+   * @param grain Smallest number of indices worth giving to a thread
+   * @param body Callable invoked as `body(chunkBegin, chunkEnd)`, once per chunk
+   */
+  template <typename Body>
+  void parallelFor(size_t begin, size_t end, size_t grain, Body &&body)
+  {
+    if (begin >= end)
+    {
+      return;
+    }
+    grain = std::max<size_t>(grain, 1);
+    if (end - begin < 2 * grain)
+    {
+      body(begin, end);
+      return;
+    }
+    currentExecutor().parallelFor(begin, end, grain, RangeFunction(body));
+  }
+
+  /**
+   * @brief Runs @a a and @a b, potentially in parallel, and returns when both are done
+   */
+  template <typename A, typename B>
+  void parallelInvoke(A &&a, B &&b)
+  {
+    parallelFor(0, 2, 1, [&a, &b](size_t first, size_t last) {
+      for (size_t i = first; i < last; i++)
+      {
+        if (i == 0)
+        {
+          a();
+        }
+        else
+        {
+          b();
+        }
+      }
+    });
+  }
+}
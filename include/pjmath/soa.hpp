@@ -0,0 +1,520 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+#include "aligned.hpp"
+#include "definitions.hpp"
+#include "kernels.hpp"
+
+namespace pjmath
+{
+  namespace detail
+  {
+    /**
+     * @brief True if @a V is a vector or matrix type made of exactly @a D elements of type @a T
+     */
+    template <typename V, typename T, size_t D>
+    constexpr bool is_packed_vector_v = std::is_base_of_v<std::array<T, D>, V> &&
+                                        sizeof(V) == sizeof(std::array<T, D>);
+
+    /**
+     * @brief Reinterprets an array of three dimensional vectors as interleaved xyz coordinates
+     */
+    template <typename V>
+    const typename V::value_type *coordinates(std::span<const V> vectors)
+    {
+      static_assert(is_packed_vector_v<V, typename V::value_type, 3>);
+      return reinterpret_cast<const typename V::value_type *>(vectors.data());
+    }
+  }
+
+  /**
+   * @brief An array of D dimensional vectors stored as structure of arrays
+   *
+   * Each coordinate lives in its own aligned column, so whole-array operations process
+   * every SIMD lane with useful data instead of the interleaved xyzxyz layout of an array
+   * of `Vector3` or `Vec3`. Elements are accessed through lightweight proxies which convert
+   * to and from the interleaved vector types.
+   *
+   * @tparam D Number of dimensions
+   * @tparam T Coordinate type
+   */
+  template <size_t D, typename T = real_t>
+  class SoAVecArray
+  {
+    using Columns = std::array<AlignedVector<T>, D>;
+
+  public:
+    using value_type = T;     ///< Coordinate type
+    using size_type = size_t; ///< Index type
+
+    static constexpr size_type dimensions = D; ///< Number of dimensions
+
+    static_assert(D > 0);
+
+    /**
+     * @brief Proxy for one vector of the array
+     *
+     * @tparam Owner Column storage, const qualified for a read-only proxy
+     */
+    template <typename Owner>
+    class Element
+    {
+      using Value = std::conditional_t<std::is_const_v<Owner>, const T, T>;
+
+    public:
+      Element(Owner *columns, size_type index) : columns_(columns), index_(index)
+      {
+      }
+
+      Element(const Element &) = default;
+
+      /**
+       * @brief Copies the coordinates of another element
+       */
+      Element &operator=(const Element &other)
+      {
+        for (size_type k = 0; k < D; k++)
+        {
+          (*this)[k] = other[k];
+        }
+        return *this;
+      }
+
+      /**
+       * @brief Copies the coordinates of an interleaved vector
+       *
+       * @tparam V Vector type with D elements
+       */
+      template <typename V, typename = std::enable_if_t<detail::is_packed_vector_v<V, T, D>>>
+      Element &operator=(const V &vector)
+      {
+        for (size_type k = 0; k < D; k++)
+        {
+          (*this)[k] = vector[k];
+        }
+        return *this;
+      }
+
+      /**
+       * @brief Converts to an interleaved vector type
+       *
+       * @tparam V Vector type with D elements, such as `Vector3` or `Vec3`
+       */
+      template <typename V, typename = std::enable_if_t<detail::is_packed_vector_v<V, T, D>>>
+      operator V() const
+      {
+        V vector;
+        for (size_type k = 0; k < D; k++)
+        {
+          vector[k] = (*this)[k];
+        }
+        return vector;
+      }
+
+      /**
+       * @return Reference to coordinate @a k
+       */
+      Value &operator[](size_type k) const
+      {
+        return (*columns_)[k][index_];
+      }
+
+      Value &x() const
+      {
+        return (*this)[0];
+      }
+
+      template <size_t D_ = D, typename std::enable_if<(D_ >= 2), int>::type = 0>
+      Value &y() const
+      {
+        return (*this)[1];
+      }
+
+      template <size_t D_ = D, typename std::enable_if<(D_ >= 3), int>::type = 0>
+      Value &z() const
+      {
+        return (*this)[2];
+      }
+
+      template <size_t D_ = D, typename std::enable_if<(D_ >= 4), int>::type = 0>
+      Value &w() const
+      {
+        return (*this)[3];
+      }
+
+    private:
+      Owner *columns_;
+      size_type index_;
+    };
+
+    using Reference = Element<Columns>;            ///< Proxy for a mutable element
+    using ConstReference = Element<const Columns>; ///< Proxy for a read-only element
+
+    SoAVecArray() = default;
+
+    /**
+     * @brief Constructs an array of @a count zero vectors
+     */
+    explicit SoAVecArray(size_type count) : columns_()
+    {
+      resize(count);
+    }
+
+    /**
+     * @brief Constructs an array from interleaved vectors
+     *
+     * @tparam V Vector type with D elements, such as `Vector3` or `Vec3`
+     * @param vectors Vectors to copy
+     * @return The array holding the same vectors
+     */
+    template <typename V>
+    static SoAVecArray fromAoS(std::span<const V> vectors)
+    {
+      static_assert(detail::is_packed_vector_v<V, T, D>);
+      SoAVecArray array(vectors.size());
+      for (size_type i = 0; i < vectors.size(); i++)
+      {
+        for (size_type k = 0; k < D; k++)
+        {
+          array.columns_[k][i] = vectors[i][k];
+        }
+      }
+      return array;
+    }
+
+    /**
+     * @brief Copies the array into interleaved vectors
+     *
+     * @tparam V Vector type with D elements, such as `Vector3` or `Vec3`
+     * @param vectors Receives the vectors, must have the same size as this
+     */
+    template <typename V>
+    void toAoS(std::span<V> vectors) const
+    {
+      static_assert(detail::is_packed_vector_v<V, T, D>);
+      checkSize(vectors.size());
+      for (size_type i = 0; i < vectors.size(); i++)
+      {
+        for (size_type k = 0; k < D; k++)
+        {
+          vectors[i][k] = columns_[k][i];
+        }
+      }
+    }
+
+    /**
+     * @return Number of vectors in the array
+     */
+    size_type size() const
+    {
+      return columns_[0].size();
+    }
+
+    /**
+     * @return True if the array holds no vectors
+     */
+    bool empty() const
+    {
+      return columns_[0].empty();
+    }
+
+    /**
+     * @brief Resizes the array, new vectors are zero
+     */
+    void resize(size_type count)
+    {
+      for (auto &column : columns_)
+      {
+        column.resize(count);
+      }
+    }
+
+    /**
+     * @brief Reserves storage for @a count vectors in every column
+     */
+    void reserve(size_type count)
+    {
+      for (auto &column : columns_)
+      {
+        column.reserve(count);
+      }
+    }
+
+    /**
+     * @brief Removes every vector
+     */
+    void clear()
+    {
+      for (auto &column : columns_)
+      {
+        column.clear();
+      }
+    }
+
+    /**
+     * @brief Appends an interleaved vector
+     *
+     * @tparam V Vector type with D elements, such as `Vector3` or `Vec3`
+     */
+    template <typename V>
+    void push_back(const V &vector)
+    {
+      static_assert(detail::is_packed_vector_v<V, T, D>);
+      for (size_type k = 0; k < D; k++)
+      {
+        columns_[k].push_back(vector[k]);
+      }
+    }
+
+    Reference operator[](size_type i)
+    {
+      return Reference(&columns_, i);
+    }
+
+    ConstReference operator[](size_type i) const
+    {
+      return ConstReference(&columns_, i);
+    }
+
+    /**
+     * @return Coordinate @a k of every vector
+     */
+    std::span<T> column(size_type k)
+    {
+      return columns_.at(k);
+    }
+
+    /**
+     * @return Coordinate @a k of every vector
+     */
+    std::span<const T> column(size_type k) const
+    {
+      return columns_.at(k);
+    }
+
+    std::span<T> x()
+    {
+      return columns_[0];
+    }
+
+    std::span<const T> x() const
+    {
+      return columns_[0];
+    }
+
+    template <size_t D_ = D, typename std::enable_if<(D_ >= 2), int>::type = 0>
+    std::span<T> y()
+    {
+      return columns_[1];
+    }
+
+    template <size_t D_ = D, typename std::enable_if<(D_ >= 2), int>::type = 0>
+    std::span<const T> y() const
+    {
+      return columns_[1];
+    }
+
+    template <size_t D_ = D, typename std::enable_if<(D_ >= 3), int>::type = 0>
+    std::span<T> z()
+    {
+      return columns_[2];
+    }
+
+    template <size_t D_ = D, typename std::enable_if<(D_ >= 3), int>::type = 0>
+    std::span<const T> z() const
+    {
+      return columns_[2];
+    }
+
+    template <size_t D_ = D, typename std::enable_if<(D_ >= 4), int>::type = 0>
+    std::span<T> w()
+    {
+      return columns_[3];
+    }
+
+    template <size_t D_ = D, typename std::enable_if<(D_ >= 4), int>::type = 0>
+    std::span<const T> w() const
+    {
+      return columns_[3];
+    }
+
+    /**
+     * @brief Adds the vectors of @a other to the vectors of this
+     *
+     * @param other Array of the same size
+     * @return A reference to this
+     */
+    SoAVecArray &operator+=(const SoAVecArray &other)
+    {
+      return addScaled(other, T(1));
+    }
+
+    /**
+     * @brief Subtracts the vectors of @a other from the vectors of this
+     *
+     * @param other Array of the same size
+     * @return A reference to this
+     */
+    SoAVecArray &operator-=(const SoAVecArray &other)
+    {
+      return addScaled(other, T(-1));
+    }
+
+    /**
+     * @brief Scales every vector by @a s
+     *
+     * @param s Scale factor
+     * @return A reference to this
+     */
+    SoAVecArray &operator*=(T s)
+    {
+      for (auto &column : columns_)
+      {
+        for (T &value : column)
+        {
+          value *= s;
+        }
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Adds the vectors of @a other scaled by @a s to the vectors of this in one pass
+     *
+     * @param other Array of the same size
+     * @param s Scale factor
+     * @return A reference to this
+     */
+    SoAVecArray &addScaled(const SoAVecArray &other, T s)
+    {
+      checkSize(other.size());
+      for (size_type k = 0; k < D; k++)
+      {
+        kernels::addScaled(columns_[k].data(), other.columns_[k].data(), s, size());
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Computes the dot product of every pair of vectors of this and @a other
+     *
+     * @param other Array of the same size
+     * @param out Receives one dot product per vector
+     */
+    void dot(const SoAVecArray &other, std::span<T> out) const
+    {
+      checkSize(other.size());
+      checkSize(out.size());
+      for (T &value : out)
+      {
+        value = T{};
+      }
+      for (size_type k = 0; k < D; k++)
+      {
+        kernels::madd(out.data(), columns_[k].data(), other.columns_[k].data(), out.size());
+      }
+    }
+
+    /**
+     * @brief Computes the squared length of every vector
+     *
+     * @param out Receives one squared length per vector
+     */
+    void lengthsSquared(std::span<T> out) const
+    {
+      dot(*this, out);
+    }
+
+    /**
+     * @brief Computes the cross product of every pair of vectors of this and @a other
+     *
+     * @param other Array of the same size
+     * @param out Receives the cross products, may be this or @a other
+     */
+    template <size_t D_ = D, typename std::enable_if<(D_ == 3), int>::type = 0>
+    void cross(const SoAVecArray &other, SoAVecArray &out) const
+    {
+      checkSize(other.size());
+      out.resize(size());
+
+      const T *ax = columns_[0].data();
+      const T *ay = columns_[1].data();
+      const T *az = columns_[2].data();
+      const T *bx = other.columns_[0].data();
+      const T *by = other.columns_[1].data();
+      const T *bz = other.columns_[2].data();
+      T *ox = out.columns_[0].data();
+      T *oy = out.columns_[1].data();
+      T *oz = out.columns_[2].data();
+
+      for (size_type i = 0; i < size(); i++)
+      {
+        T x = ay[i] * bz[i] - az[i] * by[i];
+        T y = az[i] * bx[i] - ax[i] * bz[i];
+        T z = ax[i] * by[i] - ay[i] * bx[i];
+        ox[i] = x;
+        oy[i] = y;
+        oz[i] = z;
+      }
+    }
+
+    /**
+     * @brief Normalizes every vector in place
+     *
+     * Vectors of zero length are left unchanged, as @ref Vector::Normalize does.
+     *
+     * @param mode Accuracy mode, see @ref NormalizeMode for the error bounds
+     */
+    void normalize(NormalizeMode mode = NormalizeMode::exact)
+    {
+      T lengthSquared[kernels::normalize_block];
+      T factors[kernels::normalize_block];
+
+      for (size_type first = 0; first < size(); first += kernels::normalize_block)
+      {
+        size_type n = size() - first < kernels::normalize_block ? size() - first : kernels::normalize_block;
+
+        for (size_type i = 0; i < n; i++)
+        {
+          lengthSquared[i] = T{};
+        }
+        for (size_type k = 0; k < D; k++)
+        {
+          const T *column = columns_[k].data() + first;
+          kernels::madd(lengthSquared, column, column, n);
+        }
+
+        kernels::normalizationFactors(lengthSquared, factors, n, mode);
+
+        for (size_type k = 0; k < D; k++)
+        {
+          T *column = columns_[k].data() + first;
+          for (size_type i = 0; i < n; i++)
+          {
+            column[i] *= factors[i];
+          }
+        }
+      }
+    }
+
+  private:
+    void checkSize(size_type count) const
+    {
+      if (count != size())
+      {
+        throw std::invalid_argument("array sizes do not match");
+      }
+    }
+
+    Columns columns_{};
+  };
+
+  using SoAVec2Array = SoAVecArray<2>; ///< Structure of arrays for 2 dimensional vectors
+  using SoAVec3Array = SoAVecArray<3>; ///< Structure of arrays for 3 dimensional vectors
+  using SoAVec4Array = SoAVecArray<4>; ///< Structure of arrays for 4 dimensional vectors
+}
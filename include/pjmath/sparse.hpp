@@ -0,0 +1,480 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "definitions.hpp"
+#include "mat.hpp"
+
+namespace pjmath
+{
+  class CscMatrix;
+
+  namespace detail
+  {
+    /**
+     * @brief Compressed sparse storage shared by the row and column major matrices
+     *
+     * The nonzeros of major line i (a row of a CSR matrix, a column of a CSC matrix) are
+     * values[offsets[i]] to values[offsets[i + 1] - 1], with their positions along the line
+     * in the same range of indices, sorted and unique. Indices are 32 bit to halve the
+     * memory traffic of the multiply, which is bandwidth bound.
+     */
+    struct CompressedStorage
+    {
+      size_t majorCount = 0;             ///< Number of rows of a CSR matrix, columns of a CSC matrix
+      size_t minorCount = 0;             ///< Number of columns of a CSR matrix, rows of a CSC matrix
+      std::vector<size_t> offsets{0};    ///< Start of each major line, followed by the number of nonzeros
+      std::vector<uint32_t> indices{};   ///< Minor index of each nonzero
+      std::vector<real_t> values{};      ///< Value of each nonzero
+
+      /**
+       * @brief Checks the invariants above, throws std::invalid_argument if one is broken
+       */
+      void validate() const;
+
+      /**
+       * @return Element at (@a major, @a minor), zero if it is not stored
+       */
+      real_t at(size_t major, size_t minor) const;
+
+      /**
+       * @return The same matrix compressed along the other dimension
+       */
+      CompressedStorage transposed() const;
+
+      /**
+       * @brief Computes y[i] = sum over line i of value * x[index], one line per output
+       */
+      void gather(std::span<const real_t> x, std::span<real_t> y) const;
+
+      /**
+       * @brief Computes y[index] = sum over every line i of value * x[i]
+       */
+      void scatter(std::span<const real_t> x, std::span<real_t> y) const;
+
+      /**
+       * @brief Compresses coordinate triplets, duplicates are summed in insertion order
+       */
+      static CompressedStorage compress(size_t majorCount, size_t minorCount, std::span<const uint32_t> major,
+                                        std::span<const uint32_t> minor, std::span<const real_t> values);
+    };
+  }
+
+  /**
+   * @brief Sparse matrix in compressed sparse row format
+   *
+   * Multiplying by a vector reads each row once and gathers from the vector, rows are split
+   * across threads in blocks of equal nonzero count.
+   */
+  class CsrMatrix
+  {
+  public:
+    /**
+     * @brief Constructs an empty 0 by 0 matrix
+     */
+    CsrMatrix() = default;
+
+    /**
+     * @brief Constructs a matrix from its compressed arrays
+     *
+     * @param rows Number of rows
+     * @param columns Number of columns
+     * @param rowOffsets Start of each row in @a columnIndices and @a values, followed by the number of nonzeros
+     * @param columnIndices Column of each nonzero, sorted and unique within a row
+     * @param values Value of each nonzero
+     * @throws std::invalid_argument if the arrays do not describe a valid matrix
+     */
+    CsrMatrix(size_t rows, size_t columns, std::vector<size_t> rowOffsets, std::vector<uint32_t> columnIndices,
+              std::vector<real_t> values);
+
+    /**
+     * @brief Constructs a sparse copy of a dense matrix
+     *
+     * @param m Dense matrix
+     * @param tolerance Elements whose magnitude is not above this are left out
+     */
+    template <typename E, size_t M, size_t N, typename D>
+    static CsrMatrix fromDense(const Mat<E, M, N, D> &m, real_t tolerance = 0)
+    {
+      CsrMatrix sparse;
+      sparse.storage_.majorCount = M;
+      sparse.storage_.minorCount = N;
+      sparse.storage_.offsets.reserve(M + 1);
+      for (size_t i = 0; i < M; i++)
+      {
+        for (size_t j = 0; j < N; j++)
+        {
+          real_t value = real_t(m.at(i, j));
+          if (std::fabs(value) > tolerance)
+          {
+            sparse.storage_.indices.push_back(uint32_t(j));
+            sparse.storage_.values.push_back(value);
+          }
+        }
+        sparse.storage_.offsets.push_back(sparse.storage_.values.size());
+      }
+      return sparse;
+    }
+
+    /**
+     * @brief Constructs a dense copy of this matrix
+     *
+     * @tparam MatType Dense matrix type with the same shape as this matrix
+     * @throws std::invalid_argument if the shapes differ
+     */
+    template <typename MatType>
+    MatType toDense() const
+    {
+      if (rows() != MatType::row_count || columns() != MatType::column_count)
+      {
+        throw std::invalid_argument("sparse matrix shape does not match the dense type");
+      }
+      MatType dense{};
+      for (size_t i = 0; i < rows(); i++)
+      {
+        for (size_t k = storage_.offsets[i]; k < storage_.offsets[i + 1]; k++)
+        {
+          dense.at(i, storage_.indices[k]) = storage_.values[k];
+        }
+      }
+      return dense;
+    }
+
+    /**
+     * @return Number of rows
+     */
+    size_t rows() const
+    {
+      return storage_.majorCount;
+    }
+
+    /**
+     * @return Number of columns
+     */
+    size_t columns() const
+    {
+      return storage_.minorCount;
+    }
+
+    /**
+     * @return Number of stored elements
+     */
+    size_t nonZeros() const
+    {
+      return storage_.values.size();
+    }
+
+    /**
+     * @return Start of each row, followed by the number of nonzeros
+     */
+    std::span<const size_t> rowOffsets() const
+    {
+      return storage_.offsets;
+    }
+
+    /**
+     * @return Column of each nonzero
+     */
+    std::span<const uint32_t> columnIndices() const
+    {
+      return storage_.indices;
+    }
+
+    /**
+     * @return Value of each nonzero
+     */
+    std::span<const real_t> values() const
+    {
+      return storage_.values;
+    }
+
+    /**
+     * @return Value of each nonzero, the sparsity pattern cannot be changed through it
+     */
+    std::span<real_t> values()
+    {
+      return storage_.values;
+    }
+
+    /**
+     * @brief Gets an element, in logarithmic time in the length of its row
+     *
+     * @throws std::out_of_range if the position is outside of the matrix
+     */
+    real_t at(size_t row, size_t column) const;
+
+    /**
+     * @brief Computes @a y = A @a x
+     *
+     * @param x Vector with one element per column
+     * @param y Vector with one element per row, overwritten
+     * @throws std::invalid_argument if a vector has the wrong size
+     */
+    void multiply(std::span<const real_t> x, std::span<real_t> y) const;
+
+    /**
+     * @brief Computes @a y = Aᵀ @a x without forming the transpose
+     *
+     * Rows scatter into per-thread partial results which are then summed, converting to
+     * @ref CscMatrix first is faster when the same matrix is used many times.
+     *
+     * @param x Vector with one element per row
+     * @param y Vector with one element per column, overwritten
+     * @throws std::invalid_argument if a vector has the wrong size
+     */
+    void multiplyTransposed(std::span<const real_t> x, std::span<real_t> y) const;
+
+    /**
+     * @return The main diagonal, zero where an element is not stored
+     */
+    std::vector<real_t> diagonal() const;
+
+    /**
+     * @return The transpose of this matrix
+     */
+    CsrMatrix transposed() const;
+
+    /**
+     * @return This matrix in compressed sparse column format
+     */
+    CscMatrix toCsc() const;
+
+  private:
+    friend class CscMatrix;
+    friend class CooBuilder;
+
+    explicit CsrMatrix(detail::CompressedStorage storage) : storage_(std::move(storage))
+    {
+    }
+
+    detail::CompressedStorage storage_{};
+  };
+
+  /**
+   * @brief Sparse matrix in compressed sparse column format
+   *
+   * The transposed multiply reads each column once and gathers from the vector, so it has
+   * the performance of @ref CsrMatrix::multiply.
+   */
+  class CscMatrix
+  {
+  public:
+    /**
+     * @brief Constructs an empty 0 by 0 matrix
+     */
+    CscMatrix() = default;
+
+    /**
+     * @brief Constructs a matrix from its compressed arrays
+     *
+     * @param rows Number of rows
+     * @param columns Number of columns
+     * @param columnOffsets Start of each column in @a rowIndices and @a values, followed by the number of nonzeros
+     * @param rowIndices Row of each nonzero, sorted and unique within a column
+     * @param values Value of each nonzero
+     * @throws std::invalid_argument if the arrays do not describe a valid matrix
+     */
+    CscMatrix(size_t rows, size_t columns, std::vector<size_t> columnOffsets, std::vector<uint32_t> rowIndices,
+              std::vector<real_t> values);
+
+    /**
+     * @brief Constructs a sparse copy of a dense matrix
+     *
+     * @param m Dense matrix
+     * @param tolerance Elements whose magnitude is not above this are left out
+     */
+    template <typename E, size_t M, size_t N, typename D>
+    static CscMatrix fromDense(const Mat<E, M, N, D> &m, real_t tolerance = 0)
+    {
+      return CsrMatrix::fromDense(m, tolerance).toCsc();
+    }
+
+    /**
+     * @brief Constructs a dense copy of this matrix
+     *
+     * @tparam MatType Dense matrix type with the same shape as this matrix
+     * @throws std::invalid_argument if the shapes differ
+     */
+    template <typename MatType>
+    MatType toDense() const
+    {
+      return toCsr().toDense<MatType>();
+    }
+
+    /**
+     * @return Number of rows
+     */
+    size_t rows() const
+    {
+      return storage_.minorCount;
+    }
+
+    /**
+     * @return Number of columns
+     */
+    size_t columns() const
+    {
+      return storage_.majorCount;
+    }
+
+    /**
+     * @return Number of stored elements
+     */
+    size_t nonZeros() const
+    {
+      return storage_.values.size();
+    }
+
+    /**
+     * @return Start of each column, followed by the number of nonzeros
+     */
+    std::span<const size_t> columnOffsets() const
+    {
+      return storage_.offsets;
+    }
+
+    /**
+     * @return Row of each nonzero
+     */
+    std::span<const uint32_t> rowIndices() const
+    {
+      return storage_.indices;
+    }
+
+    /**
+     * @return Value of each nonzero
+     */
+    std::span<const real_t> values() const
+    {
+      return storage_.values;
+    }
+
+    /**
+     * @return Value of each nonzero, the sparsity pattern cannot be changed through it
+     */
+    std::span<real_t> values()
+    {
+      return storage_.values;
+    }
+
+    /**
+     * @brief Gets an element, in logarithmic time in the length of its column
+     *
+     * @throws std::out_of_range if the position is outside of the matrix
+     */
+    real_t at(size_t row, size_t column) const;
+
+    /**
+     * @brief Computes @a y = A @a x, see @ref CsrMatrix::multiplyTransposed for the cost
+     *
+     * @param x Vector with one element per column
+     * @param y Vector with one element per row, overwritten
+     * @throws std::invalid_argument if a vector has the wrong size
+     */
+    void multiply(std::span<const real_t> x, std::span<real_t> y) const;
+
+    /**
+     * @brief Computes @a y = Aᵀ @a x
+     *
+     * @param x Vector with one element per row
+     * @param y Vector with one element per column, overwritten
+     * @throws std::invalid_argument if a vector has the wrong size
+     */
+    void multiplyTransposed(std::span<const real_t> x, std::span<real_t> y) const;
+
+    /**
+     * @return This matrix in compressed sparse row format
+     */
+    CsrMatrix toCsr() const;
+
+  private:
+    friend class CsrMatrix;
+    friend class CooBuilder;
+
+    explicit CscMatrix(detail::CompressedStorage storage) : storage_(std::move(storage))
+    {
+    }
+
+    detail::CompressedStorage storage_{};
+  };
+
+  /**
+   * @brief Collects the nonzeros of a sparse matrix in any order
+   */
+  class CooBuilder
+  {
+  public:
+    /**
+     * @param rows Number of rows of the built matrix
+     * @param columns Number of columns of the built matrix
+     * @throws std::invalid_argument if a dimension does not fit the 32 bit indices
+     */
+    CooBuilder(size_t rows, size_t columns);
+
+    /**
+     * @brief Reserves space for @a count elements
+     */
+    void reserve(size_t count);
+
+    /**
+     * @brief Adds @a value to the element at (@a row, @a column)
+     *
+     * @throws std::out_of_range if the position is outside of the matrix
+     */
+    void add(size_t row, size_t column, real_t value);
+
+    /**
+     * @return Number of elements added, counting duplicates
+     */
+    size_t size() const
+    {
+      return values_.size();
+    }
+
+    /**
+     * @brief Builds the matrix, elements added more than once are summed
+     */
+    CsrMatrix toCsr() const;
+
+    /**
+     * @copydoc toCsr
+     */
+    CscMatrix toCsc() const;
+
+  private:
+    size_t rows_ = 0;
+    size_t columns_ = 0;
+    std::vector<uint32_t> rowIndices_{};
+    std::vector<uint32_t> columnIndices_{};
+    std::vector<real_t> values_{};
+  };
+
+  /**
+   * @brief Outcome of @ref conjugateGradient
+   */
+  struct ConjugateGradientResult
+  {
+    size_t iterations = 0; ///< Number of iterations run
+    real_t residual = 0;   ///< Final residual norm relative to the norm of the right hand side
+    bool converged = false; ///< True if @a residual reached the requested tolerance
+  };
+
+  /**
+   * @brief Solves A @a x = @a b for a symmetric positive definite A with Jacobi preconditioned conjugate gradients
+   *
+   * @param a Symmetric positive definite matrix, only the multiply is used so both triangles must be stored
+   * @param b Right hand side
+   * @param x Initial guess, overwritten with the solution
+   * @param tolerance Stops once |b - A x| <= tolerance |b|
+   * @param maxIterations Largest number of iterations, zero for the number of rows
+   * @throws std::invalid_argument if @a a is not square or a vector has the wrong size
+   */
+  ConjugateGradientResult conjugateGradient(const CsrMatrix &a, std::span<const real_t> b, std::span<real_t> x,
+                                            real_t tolerance = 1e-10, size_t maxIterations = 0);
+}
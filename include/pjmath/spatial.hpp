@@ -0,0 +1,460 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "aligned.hpp"
+#include "definitions.hpp"
+#include "soa.hpp"
+#include "vec3.hpp"
+#include "vector.hpp"
+
+/**
+ * Spatial indices for nearest neighbour and radius queries over point clouds.
+ *
+ * Both indices answer batch queries by sorting the queries along a Morton curve, so
+ * consecutive queries touch the same nodes or cells while they are still in cache, and
+ * spreading the sorted queries across threads. Results are always reported in query order.
+ */
+namespace pjmath
+{
+  /**
+   * @brief A point found by a spatial query
+   */
+  struct Neighbor
+  {
+    uint32_t index;         ///< Index of the point in the indexed cloud, or its grid id
+    real_t distanceSquared; ///< Squared distance from the query point
+  };
+
+  /**
+   * @brief Neighbours found by a batch query, one list per query point
+   */
+  class NeighborLists
+  {
+  public:
+    NeighborLists() = default;
+
+    /**
+     * @param offsets Start of the list of each query in @a neighbors, followed by the total size
+     * @param neighbors Every list, one after the other
+     */
+    NeighborLists(std::vector<size_t> offsets, std::vector<Neighbor> neighbors)
+        : offsets_(std::move(offsets)), neighbors_(std::move(neighbors))
+    {
+    }
+
+    /**
+     * @return Number of query points
+     */
+    size_t size() const
+    {
+      return offsets_.size() - 1;
+    }
+
+    /**
+     * @return Neighbours of query @a i, closest first
+     */
+    std::span<const Neighbor> operator[](size_t i) const
+    {
+      return std::span<const Neighbor>(neighbors_).subspan(offsets_[i], offsets_[i + 1] - offsets_[i]);
+    }
+
+  private:
+    std::vector<size_t> offsets_{0};
+    std::vector<Neighbor> neighbors_{};
+  };
+
+  /**
+   * @brief Static k-d tree over a point cloud
+   *
+   * The tree is implicit: points are permuted so every subtree is a contiguous range whose
+   * middle element is the splitting point, and only the split axis is stored per node. Small
+   * ranges are leaves scanned linearly over structure of arrays coordinates. Large subtrees
+   * build in parallel.
+   */
+  class KdTree
+  {
+  public:
+    /**
+     * @brief Ranges at most this long are leaves
+     */
+    static constexpr size_t leaf_size = 8;
+
+    /**
+     * @brief Constructs an empty tree
+     */
+    KdTree() = default;
+
+    /**
+     * @brief Builds the tree over a point cloud
+     *
+     * @param points Points to index, a @ref Neighbor refers to a point by its index here
+     */
+    explicit KdTree(std::span<const Vec3> points)
+    {
+      build(detail::coordinates(points), points.size());
+    }
+
+    /**
+     * @copydoc KdTree(std::span<const Vec3>)
+     */
+    explicit KdTree(std::span<const Vector3> points)
+    {
+      build(detail::coordinates(points), points.size());
+    }
+
+    /**
+     * @return Number of indexed points
+     */
+    size_t size() const
+    {
+      return indices_.size();
+    }
+
+    /**
+     * @brief Finds the @a k points closest to @a point
+     *
+     * @return Up to @a k neighbours, closest first, ties broken by index
+     */
+    std::vector<Neighbor> nearest(const Vec3 &point, size_t k) const
+    {
+      std::vector<Neighbor> found;
+      appendNearest(point.data(), k, found);
+      return found;
+    }
+
+    /**
+     * @copydoc nearest(const Vec3 &, size_t) const
+     */
+    std::vector<Neighbor> nearest(const Vector3 &point, size_t k) const
+    {
+      std::vector<Neighbor> found;
+      appendNearest(point.data(), k, found);
+      return found;
+    }
+
+    /**
+     * @brief Finds the @a k points closest to each query point
+     */
+    NeighborLists nearest(std::span<const Vec3> points, size_t k) const
+    {
+      return nearest(detail::coordinates(points), points.size(), k);
+    }
+
+    /**
+     * @copydoc nearest(std::span<const Vec3>, size_t) const
+     */
+    NeighborLists nearest(std::span<const Vector3> points, size_t k) const
+    {
+      return nearest(detail::coordinates(points), points.size(), k);
+    }
+
+    /**
+     * @brief Finds every point within @a radius of @a point
+     *
+     * @return The neighbours, closest first, ties broken by index
+     */
+    std::vector<Neighbor> withinRadius(const Vec3 &point, real_t radius) const
+    {
+      std::vector<Neighbor> found;
+      appendWithinRadius(point.data(), radius, found);
+      return found;
+    }
+
+    /**
+     * @copydoc withinRadius(const Vec3 &, real_t) const
+     */
+    std::vector<Neighbor> withinRadius(const Vector3 &point, real_t radius) const
+    {
+      std::vector<Neighbor> found;
+      appendWithinRadius(point.data(), radius, found);
+      return found;
+    }
+
+    /**
+     * @brief Finds every point within @a radius of each query point
+     */
+    NeighborLists withinRadius(std::span<const Vec3> points, real_t radius) const
+    {
+      return withinRadius(detail::coordinates(points), points.size(), radius);
+    }
+
+    /**
+     * @copydoc withinRadius(std::span<const Vec3>, real_t) const
+     */
+    NeighborLists withinRadius(std::span<const Vector3> points, real_t radius) const
+    {
+      return withinRadius(detail::coordinates(points), points.size(), radius);
+    }
+
+  private:
+    void build(const real_t *points, size_t count);
+    void appendNearest(const real_t *point, size_t k, std::vector<Neighbor> &found) const;
+    void appendWithinRadius(const real_t *point, real_t radius, std::vector<Neighbor> &found) const;
+    NeighborLists nearest(const real_t *points, size_t count, size_t k) const;
+    NeighborLists withinRadius(const real_t *points, size_t count, real_t radius) const;
+
+    SoAVec3Array points_{};
+    AlignedVector<uint32_t> indices_{};
+    std::vector<uint8_t> axes_{};
+  };
+
+  /**
+   * @brief Uniform grid of cubic cells over a dynamic point set
+   *
+   * Occupied cells are found through an open addressing hash table, so memory follows the
+   * number of occupied cells rather than the volume covered. A cell is erased as soon as its
+   * last point leaves, so moving points do not leave empty cells behind. Each cell stores
+   * the coordinates of its points inline, so scanning a cell reads one contiguous array.
+   * Points are named by ids which stay valid until the point is removed, and inserting,
+   * moving or removing a point only touches its cells.
+   *
+   * Queries are fastest when the radius, or the distance to the k-th neighbour, is a small
+   * multiple of the cell size. Cell coordinates must lie within ±2^20.
+   */
+  class HashGrid
+  {
+  public:
+    /**
+     * @brief Constructs an empty grid
+     *
+     * @param cellSize Edge length of the cells
+     * @throws std::invalid_argument if @a cellSize is not positive
+     */
+    explicit HashGrid(real_t cellSize);
+
+    /**
+     * @brief Constructs a grid holding a point cloud, the id of each point is its index
+     *
+     * @param cellSize Edge length of the cells
+     * @param points Points to insert
+     */
+    HashGrid(real_t cellSize, std::span<const Vec3> points) : HashGrid(cellSize)
+    {
+      build(detail::coordinates(points), points.size());
+    }
+
+    /**
+     * @copydoc HashGrid(real_t, std::span<const Vec3>)
+     */
+    HashGrid(real_t cellSize, std::span<const Vector3> points) : HashGrid(cellSize)
+    {
+      build(detail::coordinates(points), points.size());
+    }
+
+    /**
+     * @return Number of points in the grid
+     */
+    size_t size() const
+    {
+      return size_;
+    }
+
+    /**
+     * @return Edge length of the cells
+     */
+    real_t cellSize() const
+    {
+      return cellSize_;
+    }
+
+    /**
+     * @return Number of cells holding at least one point
+     */
+    size_t cellCount() const
+    {
+      return cells_.size();
+    }
+
+    /**
+     * @brief Adds a point
+     *
+     * @return The id of the point, ids of removed points are reused
+     * @throws std::out_of_range if the point is outside the grid range
+     */
+    uint32_t insert(const Vec3 &point)
+    {
+      return insert(point.data());
+    }
+
+    /**
+     * @copydoc insert(const Vec3 &)
+     */
+    uint32_t insert(const Vector3 &point)
+    {
+      return insert(point.data());
+    }
+
+    /**
+     * @brief Removes point @a id
+     *
+     * @throws std::out_of_range if no point has this id
+     */
+    void remove(uint32_t id);
+
+    /**
+     * @brief Moves point @a id, only changing cells if it crossed a cell boundary
+     *
+     * @throws std::out_of_range if no point has this id or the new position is outside the grid range
+     */
+    void move(uint32_t id, const Vec3 &point)
+    {
+      move(id, point.data());
+    }
+
+    /**
+     * @copydoc move(uint32_t, const Vec3 &)
+     */
+    void move(uint32_t id, const Vector3 &point)
+    {
+      move(id, point.data());
+    }
+
+    /**
+     * @return True if a point has id @a id
+     */
+    bool contains(uint32_t id) const
+    {
+      return id < alive_.size() && alive_[id];
+    }
+
+    /**
+     * @return Position of point @a id
+     * @throws std::out_of_range if no point has this id
+     */
+    Vec3 position(uint32_t id) const;
+
+    /**
+     * @copydoc KdTree::nearest(const Vec3 &, size_t) const
+     */
+    std::vector<Neighbor> nearest(const Vec3 &point, size_t k) const
+    {
+      std::vector<Neighbor> found;
+      appendNearest(point.data(), k, found);
+      return found;
+    }
+
+    /**
+     * @copydoc KdTree::nearest(const Vec3 &, size_t) const
+     */
+    std::vector<Neighbor> nearest(const Vector3 &point, size_t k) const
+    {
+      std::vector<Neighbor> found;
+      appendNearest(point.data(), k, found);
+      return found;
+    }
+
+    /**
+     * @copydoc KdTree::nearest(std::span<const Vec3>, size_t) const
+     */
+    NeighborLists nearest(std::span<const Vec3> points, size_t k) const
+    {
+      return nearest(detail::coordinates(points), points.size(), k);
+    }
+
+    /**
+     * @copydoc KdTree::nearest(std::span<const Vec3>, size_t) const
+     */
+    NeighborLists nearest(std::span<const Vector3> points, size_t k) const
+    {
+      return nearest(detail::coordinates(points), points.size(), k);
+    }
+
+    /**
+     * @copydoc KdTree::withinRadius(const Vec3 &, real_t) const
+     */
+    std::vector<Neighbor> withinRadius(const Vec3 &point, real_t radius) const
+    {
+      std::vector<Neighbor> found;
+      appendWithinRadius(point.data(), radius, found);
+      return found;
+    }
+
+    /**
+     * @copydoc KdTree::withinRadius(const Vec3 &, real_t) const
+     */
+    std::vector<Neighbor> withinRadius(const Vector3 &point, real_t radius) const
+    {
+      std::vector<Neighbor> found;
+      appendWithinRadius(point.data(), radius, found);
+      return found;
+    }
+
+    /**
+     * @copydoc KdTree::withinRadius(std::span<const Vec3>, real_t) const
+     */
+    NeighborLists withinRadius(std::span<const Vec3> points, real_t radius) const
+    {
+      return withinRadius(detail::coordinates(points), points.size(), radius);
+    }
+
+    /**
+     * @copydoc KdTree::withinRadius(std::span<const Vec3>, real_t) const
+     */
+    NeighborLists withinRadius(std::span<const Vector3> points, real_t radius) const
+    {
+      return withinRadius(detail::coordinates(points), points.size(), radius);
+    }
+
+  private:
+    /**
+     * @brief A point stored inline in its cell
+     */
+    struct Entry
+    {
+      real_t position[3];
+      uint32_t id;
+    };
+
+    /**
+     * @brief Hash table slot mapping a packed cell coordinate to its cell
+     */
+    struct Slot
+    {
+      uint64_t key;
+      uint32_t cell;
+    };
+
+    static constexpr uint64_t empty_key = std::numeric_limits<uint64_t>::max();
+    static constexpr int64_t max_cell = int64_t(1) << 20;
+
+    void build(const real_t *points, size_t count);
+    uint32_t insert(const real_t *point);
+    void move(uint32_t id, const real_t *point);
+    void appendNearest(const real_t *point, size_t k, std::vector<Neighbor> &found) const;
+    void appendWithinRadius(const real_t *point, real_t radius, std::vector<Neighbor> &found) const;
+    NeighborLists nearest(const real_t *points, size_t count, size_t k) const;
+    NeighborLists withinRadius(const real_t *points, size_t count, real_t radius) const;
+
+    void cellOf(const real_t *point, int64_t *cell) const;
+    uint64_t key(const real_t *point) const;
+    size_t findSlot(uint64_t key) const;
+    const std::vector<Entry> *find(uint64_t key) const;
+    std::vector<Entry> &cell(uint64_t key);
+    void eraseCell(size_t slot);
+    void trackBounds(uint64_t key, bool occupied);
+    void rehash(size_t slots);
+    void checkId(uint32_t id) const;
+    void removeEntry(uint64_t key, uint32_t id);
+
+    real_t cellSize_;
+    real_t inverseCellSize_;
+    std::vector<Slot> slots_{};
+    std::vector<std::vector<Entry>> cells_{};
+    std::vector<uint64_t> cellKeys_{};
+    std::array<std::map<int64_t, uint32_t>, 3> occupied_{}; ///< Occupied cells at each coordinate, per axis
+    std::vector<std::array<real_t, 3>> positions_{};
+    std::vector<uint8_t> alive_{};
+    std::vector<uint32_t> freeIds_{};
+    int64_t lower_[3] = {max_cell, max_cell, max_cell};
+    int64_t upper_[3] = {-max_cell, -max_cell, -max_cell};
+    size_t size_ = 0;
+  };
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <span>
+
+#include "definitions.hpp"
+#include "geometry.hpp"
+#include "mat3.hpp"
+#include "soa.hpp"
+#include "vec3.hpp"
+
+namespace pjmath
+{
+  /**
+   * @brief Single pass accumulator of the count, mean, covariance and bounds of a point stream
+   *
+   * Points are folded in with Welford's update, so the covariance does not suffer from the
+   * cancellation of the naive sum of squares. Partial accumulators over disjoint chunks combine
+   * with @ref merge, which is associative, so a stream can be reduced across threads.
+   */
+  class PointStatistics
+  {
+  public:
+    /**
+     * @brief Adds a single point
+     */
+    void add(const Vec3 &point)
+    {
+      count_++;
+      real_t d[3] = {point.x() - mean_.x(), point.y() - mean_.y(), point.z() - mean_.z()};
+      real_t inverse = real_t(1) / real_t(count_);
+      mean_.x() += d[0] * inverse;
+      mean_.y() += d[1] * inverse;
+      mean_.z() += d[2] * inverse;
+      accumulate(d, real_t(count_ - 1) * inverse);
+      bounds_.expand(point);
+    }
+
+    /**
+     * @brief Adds every point of @a points
+     *
+     * Points are taken in cache sized blocks whose mean is computed first and whose centered
+     * moments are then merged in, which is faster than adding points one at a time.
+     */
+    void add(std::span<const Vec3> points);
+
+    /**
+     * @brief Adds every point of @a points, see @ref add(std::span<const Vec3>)
+     */
+    void add(const SoAVec3Array &points);
+
+    /**
+     * @brief Adds the points whose coordinates are held in three columns of equal length
+     *
+     * @throws std::invalid_argument If the columns differ in size
+     */
+    void add(std::span<const real_t> x, std::span<const real_t> y, std::span<const real_t> z);
+
+    /**
+     * @brief Combines the points accumulated by @a other into this accumulator
+     *
+     * Uses Chan's pairwise update, the result matches accumulating both streams in one
+     * accumulator up to rounding.
+     */
+    void merge(const PointStatistics &other);
+
+    /**
+     * @return Number of points added
+     */
+    size_t count() const
+    {
+      return count_;
+    }
+
+    /**
+     * @return Mean of the points, zero if there are none
+     */
+    Vec3 mean() const
+    {
+      return mean_;
+    }
+
+    /**
+     * @brief Computes the population covariance, the co-moment divided by the count
+     *
+     * @return Covariance of the points, zero if there are none
+     */
+    Mat3 covariance() const;
+
+    /**
+     * @brief Computes the sample covariance, the co-moment divided by the count minus one
+     *
+     * @return Unbiased covariance estimate, zero if there are fewer than two points
+     */
+    Mat3 sampleCovariance() const;
+
+    /**
+     * @return Bounding box of the points, @ref Aabb::empty if there are none
+     */
+    Aabb bounds() const
+    {
+      return bounds_;
+    }
+
+  private:
+    /**
+     * @brief Adds the outer product of @a d with itself, scaled by @a weight, to the co-moment
+     */
+    void accumulate(const real_t *d, real_t weight)
+    {
+      comoment_[0] += d[0] * d[0] * weight;
+      comoment_[1] += d[1] * d[1] * weight;
+      comoment_[2] += d[2] * d[2] * weight;
+      comoment_[3] += d[0] * d[1] * weight;
+      comoment_[4] += d[0] * d[2] * weight;
+      comoment_[5] += d[1] * d[2] * weight;
+    }
+
+    Mat3 comoment(real_t scale) const;
+
+    template <typename Point>
+    void addBlocks(size_t count, Point point);
+
+    size_t count_ = 0;
+    Vec3 mean_{};
+    std::array<real_t, 6> comoment_{}; ///< Sums of centered products, xx, yy, zz, xy, xz and yz
+    Aabb bounds_ = Aabb::empty();
+  };
+
+  /**
+   * @brief Computes the statistics of @a points, reducing chunks across threads
+   */
+  PointStatistics pointStatistics(std::span<const Vec3> points);
+
+  /**
+   * @brief Computes the statistics of @a points, reducing chunks across threads
+   */
+  PointStatistics pointStatistics(const SoAVec3Array &points);
+}
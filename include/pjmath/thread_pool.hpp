@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "parallel.hpp"
+
+namespace pjmath
+{
+  /**
+   * @brief Work-stealing thread pool, the default @ref Executor of the library
+   *
+   * A loop is split in halves recursively down to the grain: the thread splitting a range
+   * queues one half on its own deque and carries on with the other, idle workers steal the
+   * oldest, largest, queued halves from the other deques. A thread waiting for a stolen half
+   * runs queued tasks meanwhile, so nested loops share the workers instead of blocking them
+   * and never start more threads than the pool has.
+   *
+   * The thread starting a loop takes part in it, so a pool of n workers runs n + 1 chunks at
+   * once.
+   */
+  class ThreadPool final : public Executor
+  {
+  public:
+    /**
+     * @brief Starts the workers
+     *
+     * @param workers Number of worker threads, the hardware thread count minus one if zero
+     */
+    explicit ThreadPool(size_t workers = 0);
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief Stops and joins the workers, no loop may be running
+     */
+    ~ThreadPool() override;
+
+    void parallelFor(size_t begin, size_t end, size_t grain, RangeFunction body) override;
+
+    /**
+     * @return Number of workers plus one for the calling thread
+     */
+    size_t concurrency() const override;
+
+    /**
+     * @brief Pool sized for the hardware, created on first use and never destroyed
+     */
+    static ThreadPool &global();
+
+  private:
+    struct State;
+
+    std::unique_ptr<State> state_;
+  };
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <span>
+
+#include "definitions.hpp"
+#include "mat3.hpp"
+#include "mat4.hpp"
+#include "vec3.hpp"
+#include "vec4.hpp"
+
+namespace pjmath
+{
+  /**
+   * @brief Translation, rotation and scale of an affine transform, M = T * R * S
+   */
+  struct TRS
+  {
+    Vec3 translation; ///< Last column of the transform
+    Mat3 rotation;    ///< Proper rotation, determinant +1
+    Vec3 scale;       ///< Scale along each axis, only x is negative when the transform mirrors
+  };
+
+  /**
+   * @brief Splits an affine transform into translation, rotation and scale
+   *
+   * The transform must be T * R * S with non-zero scales, shear is not recovered. A
+   * mirroring transform gets a negative x scale so the rotation stays proper.
+   *
+   * @param m Affine transform, the bottom row is ignored
+   * @return The parts of @a m, @ref Mat4::fromTRS rebuilds it
+   */
+  TRS decomposeTRS(const Mat4 &m);
+
+  /**
+   * @brief Unit quaternion (x, y, z, w) of a rotation matrix, with w >= 0
+   *
+   * @param rotation Proper rotation matrix
+   */
+  Vec4 toQuaternion(const Mat3 &rotation);
+
+  /**
+   * @brief Builds T * R * S for every transform of the batch, see @ref Mat4::fromTRS
+   *
+   * @param translations One translation per transform
+   * @param rotations One unit quaternion (x, y, z, w) per transform
+   * @param scales One scale per transform
+   * @param out Receives the transforms
+   */
+  void fromTRS(std::span<const Vec3> translations, std::span<const Vec4> rotations, std::span<const Vec3> scales,
+               std::span<Mat4> out);
+
+  /**
+   * @brief Decomposes every transform of the batch, see @ref decomposeTRS
+   *
+   * @param transforms Affine transforms
+   * @param out Receives one decomposition per transform
+   */
+  void decomposeTRS(std::span<const Mat4> transforms, std::span<TRS> out);
+}
@@ -46,4 +46,8 @@ namespace pjmath
     }
   };
 
+#if !defined(PJMATH_NO_EXTERN_TEMPLATES)
+  // Compiled once into the library, see src/pjmath/mat.cpp
+  extern template class Mat<real_t, 3, 1, Vec3>;
+#endif
 }
@@ -54,4 +54,8 @@ namespace pjmath
     }
   };
 
-}
\ No newline at end of file
+#if !defined(PJMATH_NO_EXTERN_TEMPLATES)
+  // Compiled once into the library, see src/pjmath/mat.cpp
+  extern template class Mat<real_t, 4, 1, Vec4>;
+#endif
+}
@@ -3,11 +3,12 @@
 #include <algorithm>
 #include <array>
 #include <functional>
-#include <numeric>
 #include <type_traits>
 #include <cmath>
 
 #include "definitions.hpp"
+#include "instrument.hpp"
+#include "kernels.hpp"
 
 /**
  * To create a vector of size N, define a subclass
@@ -108,14 +109,38 @@ namespace pjmath
       return VectorType(*reinterpret_cast<const VectorType *>(this)) /= factor;
     }
 
-    ValueType Dot(const VectorBase &other) const
+    VectorType &AddScaled(const VectorBase &other, ValueType scale)
     {
-      return std::inner_product(this->begin(), this->end(), other.begin(), 0.0);
+      kernels::addScaled(this->data(), other.data(), scale, N);
+      return *reinterpret_cast<VectorType *>(this);
+    }
+
+    VectorType &Madd(const VectorBase &a, const VectorBase &b)
+    {
+      kernels::madd(this->data(), a.data(), b.data(), N);
+      return *reinterpret_cast<VectorType *>(this);
+    }
+
+    VectorType &Fma(const VectorBase &factor, const VectorBase &addend)
+    {
+      kernels::fma(this->data(), factor.data(), addend.data(), N);
+      return *reinterpret_cast<VectorType *>(this);
+    }
+
+    VectorType &Lerp(const VectorBase &to, ValueType t)
+    {
+      kernels::lerp(this->data(), this->data(), to.data(), t, N);
+      return *reinterpret_cast<VectorType *>(this);
+    }
+
+    ValueType Dot(const VectorBase &other, Summation mode = Summation::fast) const
+    {
+      return kernels::dot(this->data(), other.data(), N, mode);
     }
 
-    ValueType NormSquared() const
+    ValueType NormSquared(Summation mode = Summation::fast) const
     {
-      return Dot(*reinterpret_cast<const VectorType *>(this));
+      return Dot(*reinterpret_cast<const VectorType *>(this), mode);
     }
 
     ValueType Norm() const { return std::sqrt(NormSquared()); }
@@ -127,6 +152,7 @@ namespace pjmath
 
     VectorType &Normalize()
     {
+      PJMATH_COUNT(vector_normalize);
       ValueType norm = Norm();
       return norm <= 0 ? *reinterpret_cast<VectorType *>(this)
                        : *reinterpret_cast<VectorType *>(this) /= norm;
@@ -1,7 +1,390 @@
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "pjmath/batch.hpp"
+#include "pjmath/bounded_queue.hpp"
+#include "pjmath/mat4.hpp"
+#include "pjmath/parallel.hpp"
+#include "pjmath/vec3.hpp"
+
+using namespace pjmath;
+
+namespace
+{
+  constexpr const char *usage =
+      "usage: pjmath transform [options] <input> <output>\n"
+      "\n"
+      "Transforms the points of <input> by a 4x4 matrix and writes them to <output>, '-' is\n"
+      "standard input or output. Reading, transforming and writing run on separate threads.\n"
+      "\n"
+      "options:\n"
+      "  --matrix m00,m01,...,m33   row-major transform, defaults to the identity\n"
+      "  --input-format csv|raw     csv is one 'x,y,z' line per point, raw is packed\n"
+      "  --output-format csv|raw    little-endian doubles, both default to csv\n"
+      "  --chunk N                  points per pipeline chunk, default 65536\n"
+      "  --queue-depth N            chunks buffered between stages, default 4\n";
+
+  enum class Format
+  {
+    csv,
+    raw,
+  };
+
+  struct Options
+  {
+    Mat4 matrix = Mat4::identity();
+    Format inputFormat = Format::csv;
+    Format outputFormat = Format::csv;
+    size_t chunk = 65536;
+    size_t queueDepth = 4;
+    std::string input{};
+    std::string output{};
+  };
+
+  using Chunk = std::vector<Vec3>;
+
+  // Smallest number of points worth transforming on a separate thread
+  constexpr size_t transform_grain = 8192;
+
+  Format parseFormat(std::string_view text)
+  {
+    if (text == "csv")
+    {
+      return Format::csv;
+    }
+    if (text == "raw")
+    {
+      return Format::raw;
+    }
+    throw std::invalid_argument("unknown format '" + std::string(text) + "'");
+  }
+
+  size_t parseCount(std::string_view text)
+  {
+    size_t value = 0;
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc() || end != text.data() + text.size() || value == 0)
+    {
+      throw std::invalid_argument("expected a positive integer, got '" + std::string(text) + "'");
+    }
+    return value;
+  }
+
+  Mat4 parseMatrix(std::string_view text)
+  {
+    Mat4 matrix;
+    const char *position = text.data();
+    const char *end = text.data() + text.size();
+    for (size_t k = 0; k < 16; k++)
+    {
+      auto [next, error] = std::from_chars(position, end, matrix[k]);
+      if (error != std::errc() || (k < 15 && (next == end || *next != ',')) || (k == 15 && next != end))
+      {
+        throw std::invalid_argument("--matrix needs 16 comma separated numbers");
+      }
+      position = next + 1;
+    }
+    return matrix;
+  }
+
+  Options parseOptions(int argc, char **argv)
+  {
+    if (argc < 2 || std::strcmp(argv[1], "transform") != 0)
+    {
+      throw std::invalid_argument("expected the transform command");
+    }
+    Options options;
+    std::vector<std::string> positional;
+    for (int i = 2; i < argc; i++)
+    {
+      std::string_view argument = argv[i];
+      bool option = argument.size() > 2 && argument.substr(0, 2) == "--";
+      bool known = argument == "--matrix" || argument == "--input-format" || argument == "--output-format" ||
+                   argument == "--chunk" || argument == "--queue-depth";
+      if (option && !known)
+      {
+        throw std::invalid_argument("unknown option " + std::string(argument));
+      }
+      if (option && i + 1 >= argc)
+      {
+        throw std::invalid_argument(std::string(argument) + " needs a value");
+      }
+      if (argument == "--matrix")
+      {
+        options.matrix = parseMatrix(argv[++i]);
+      }
+      else if (argument == "--input-format")
+      {
+        options.inputFormat = parseFormat(argv[++i]);
+      }
+      else if (argument == "--output-format")
+      {
+        options.outputFormat = parseFormat(argv[++i]);
+      }
+      else if (argument == "--chunk")
+      {
+        options.chunk = parseCount(argv[++i]);
+      }
+      else if (argument == "--queue-depth")
+      {
+        options.queueDepth = parseCount(argv[++i]);
+      }
+      else
+      {
+        positional.emplace_back(argument);
+      }
+    }
+    if (positional.size() != 2)
+    {
+      throw std::invalid_argument("expected an input and an output path");
+    }
+    options.input = positional[0];
+    options.output = positional[1];
+    return options;
+  }
+
+  /**
+   * Reads up to @a count points, returns an empty chunk at the end of the input.
+   */
+  class PointReader
+  {
+  public:
+    PointReader(std::istream &in, Format format) : in_(in), format_(format)
+    {
+    }
+
+    Chunk read(size_t count)
+    {
+      Chunk chunk;
+      if (format_ == Format::raw)
+      {
+        chunk.resize(count);
+        in_.read(reinterpret_cast<char *>(chunk.data()), std::streamsize(count * sizeof(Vec3)));
+        size_t bytes = size_t(in_.gcount());
+        if (bytes % sizeof(Vec3) != 0)
+        {
+          throw std::runtime_error("raw input ends in the middle of a point");
+        }
+        chunk.resize(bytes / sizeof(Vec3));
+        return chunk;
+      }
+
+      chunk.reserve(count);
+      while (chunk.size() < count && std::getline(in_, line_))
+      {
+        lineNumber_++;
+        if (line_.empty() || line_ == "\r")
+        {
+          continue;
+        }
+        chunk.push_back(parseLine());
+      }
+      return chunk;
+    }
+
+  private:
+    Vec3 parseLine() const
+    {
+      Vec3 point;
+      const char *position = line_.data();
+      const char *end = line_.data() + line_.size();
+      for (size_t k = 0; k < 3; k++)
+      {
+        while (position != end && (*position == ' ' || *position == '\t'))
+        {
+          position++;
+        }
+        auto [next, error] = std::from_chars(position, end, point[k]);
+        while (next != end && (*next == ' ' || *next == '\t' || *next == '\r'))
+        {
+          next++;
+        }
+        if (error != std::errc() || (k < 2 && (next == end || *next != ',')) || (k == 2 && next != end))
+        {
+          throw std::runtime_error("line " + std::to_string(lineNumber_) + " is not 'x,y,z'");
+        }
+        position = next + 1;
+      }
+      return point;
+    }
+
+    std::istream &in_;
+    Format format_;
+    std::string line_{};
+    size_t lineNumber_ = 0;
+  };
+
+  void writeChunk(std::ostream &out, Format format, const Chunk &chunk)
+  {
+    if (format == Format::raw)
+    {
+      out.write(reinterpret_cast<const char *>(chunk.data()), std::streamsize(chunk.size() * sizeof(Vec3)));
+      return;
+    }
+
+    // Shortest round-trip representation, formatted into one buffer per chunk
+    std::string text;
+    text.reserve(chunk.size() * 48);
+    char number[32];
+    for (const Vec3 &point : chunk)
+    {
+      for (size_t k = 0; k < 3; k++)
+      {
+        auto [end, error] = std::to_chars(number, number + sizeof(number), point[k]);
+        (void)error;
+        text.append(number, end);
+        text.push_back(k < 2 ? ',' : '\n');
+      }
+    }
+    out.write(text.data(), std::streamsize(text.size()));
+  }
+
+  /**
+   * Runs @a stage, closing @a queues if it throws so the other stages stop waiting.
+   */
+  template <typename Stage, typename... Queues>
+  void runStage(std::exception_ptr &failure, Stage &&stage, Queues &...queues)
+  {
+    try
+    {
+      stage();
+    }
+    catch (...)
+    {
+      failure = std::current_exception();
+      (queues.close(), ...);
+    }
+  }
+
+  size_t transform(const Options &options, std::istream &in, std::ostream &out)
+  {
+    BoundedQueue<Chunk> read(options.queueDepth);
+    BoundedQueue<Chunk> transformed(options.queueDepth);
+    std::exception_ptr readFailure;
+    std::exception_ptr transformFailure;
+    std::exception_ptr writeFailure;
+
+    std::thread reader([&] {
+      runStage(readFailure, [&] {
+        PointReader pointReader(in, options.inputFormat);
+        for (Chunk chunk = pointReader.read(options.chunk); !chunk.empty(); chunk = pointReader.read(options.chunk))
+        {
+          if (!read.push(std::move(chunk)))
+          {
+            break;
+          }
+        }
+        read.close();
+      }, read, transformed);
+    });
+
+    std::thread transformer([&] {
+      runStage(transformFailure, [&] {
+        while (std::optional<Chunk> chunk = read.pop())
+        {
+          std::span<Vec3> points(*chunk);
+          parallelFor(0, points.size(), transform_grain, [&](size_t first, size_t last) {
+            std::span<Vec3> part = points.subspan(first, last - first);
+            transformPoints<Vec3>(options.matrix, part, part);
+          });
+          if (!transformed.push(std::move(*chunk)))
+          {
+            break;
+          }
+        }
+        transformed.close();
+      }, read, transformed);
+    });
+
+    size_t count = 0;
+    runStage(writeFailure, [&] {
+      while (std::optional<Chunk> chunk = transformed.pop())
+      {
+        writeChunk(out, options.outputFormat, *chunk);
+        if (!out)
+        {
+          throw std::runtime_error("cannot write the output");
+        }
+        count += chunk->size();
+      }
+      out.flush();
+      if (!out)
+      {
+        throw std::runtime_error("cannot write the output");
+      }
+    }, read, transformed);
+
+    reader.join();
+    transformer.join();
+    for (const std::exception_ptr &failure : {readFailure, transformFailure, writeFailure})
+    {
+      if (failure)
+      {
+        std::rethrow_exception(failure);
+      }
+    }
+    return count;
+  }
+}
 
 int main(int argc, char **argv)
 {
-  (void)argc;
-  (void)argv;
+  Options options;
+  try
+  {
+    options = parseOptions(argc, argv);
+  }
+  catch (const std::exception &error)
+  {
+    std::cerr << "pjmath: " << error.what() << "\n\n" << usage;
+    return 2;
+  }
+
+  try
+  {
+    std::ifstream inFile;
+    std::ofstream outFile;
+    if (options.input != "-")
+    {
+      inFile.open(options.input, std::ios::binary);
+      if (!inFile)
+      {
+        throw std::runtime_error("cannot open " + options.input);
+      }
+    }
+    if (options.output != "-")
+    {
+      outFile.open(options.output, std::ios::binary | std::ios::trunc);
+      if (!outFile)
+      {
+        throw std::runtime_error("cannot create " + options.output);
+      }
+    }
+    std::istream &in = options.input == "-" ? std::cin : inFile;
+    std::ostream &out = options.output == "-" ? std::cout : outFile;
+
+    auto start = std::chrono::steady_clock::now();
+    size_t count = transform(options, in, out);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "%zu points in %.3f s, %.0f points/s\n", count, seconds,
+                 seconds > 0 ? double(count) / seconds : 0.0);
+  }
+  catch (const std::exception &error)
+  {
+    std::cerr << "pjmath: " << error.what() << '\n';
+    return 1;
+  }
   return 0;
-}
\ No newline at end of file
+}
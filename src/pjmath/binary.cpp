@@ -0,0 +1,307 @@
+#include "pjmath/binary.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pjmath
+{
+  namespace
+  {
+    // Arrays are stored in native layout, which is only the file layout on little-endian hosts
+    static_assert(std::endian::native == std::endian::little, "The binary format needs a little-endian host");
+
+    constexpr std::array<char, 8> binary_magic = {'P', 'J', 'M', 'A', 'T', 'H', 'B', '\0'};
+    constexpr size_t binary_header_size = 64;
+    constexpr size_t binary_entry_size = 64;
+    constexpr size_t binary_name_size = binary_max_name + 1;
+
+    using Block = std::array<unsigned char, 64>;
+
+    template <typename T>
+    void store(unsigned char *out, T value)
+    {
+      for (size_t i = 0; i < sizeof(T); i++)
+      {
+        out[i] = static_cast<unsigned char>(uint64_t(value) >> (8 * i));
+      }
+    }
+
+    template <typename T>
+    T load(const unsigned char *in)
+    {
+      uint64_t value = 0;
+      for (size_t i = 0; i < sizeof(T); i++)
+      {
+        value |= uint64_t(in[i]) << (8 * i);
+      }
+      return static_cast<T>(value);
+    }
+
+    Block header(uint64_t tableOffset, uint64_t arrayCount)
+    {
+      Block block{};
+      std::copy(binary_magic.begin(), binary_magic.end(), block.begin());
+      store<uint32_t>(block.data() + 8, binary_format_version);
+      store<uint32_t>(block.data() + 12, sizeof(real_t));
+      store<uint64_t>(block.data() + 16, tableOffset);
+      store<uint64_t>(block.data() + 24, arrayCount);
+      return block;
+    }
+
+    size_t elementSize(BinaryElement kind)
+    {
+      switch (kind)
+      {
+      case BinaryElement::real:
+        return sizeof(real_t);
+      case BinaryElement::vec3:
+        return sizeof(Vec3);
+      case BinaryElement::vector3:
+        return sizeof(Vector3);
+      case BinaryElement::mat4:
+        return sizeof(Mat4);
+      }
+      return 0;
+    }
+
+    [[noreturn]] void invalid(const std::string &path, const char *reason)
+    {
+      throw std::runtime_error("invalid binary container " + path + ": " + reason);
+    }
+  }
+
+  BinaryWriter::BinaryWriter(const std::string &path) : path_(path)
+  {
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_)
+    {
+      throw std::runtime_error("cannot create binary container " + path);
+    }
+    open_ = true;
+    Block block = header(0, 0);
+    file_.write(reinterpret_cast<const char *>(block.data()), std::streamsize(block.size()));
+    position_ = block.size();
+    check();
+  }
+
+  BinaryWriter::~BinaryWriter()
+  {
+    if (open_)
+    {
+      try
+      {
+        close();
+      }
+      catch (const std::exception &)
+      {
+      }
+    }
+  }
+
+  void BinaryWriter::beginArray(std::string_view name, BinaryElement kind, size_t elementSize)
+  {
+    if (!open_)
+    {
+      throw std::logic_error("binary container is closed");
+    }
+    if (name.empty() || name.size() > binary_max_name || name.find('\0') != std::string_view::npos)
+    {
+      throw std::invalid_argument("array names must have 1 to 39 bytes and no NUL");
+    }
+    if (std::any_of(entries_.begin(), entries_.end(), [name](const Entry &entry) { return entry.name == name; }))
+    {
+      throw std::invalid_argument("array name already used");
+    }
+    pad();
+    entries_.push_back(Entry{std::string(name), kind, uint32_t(elementSize), 0, position_});
+  }
+
+  void BinaryWriter::write(BinaryElement kind, const void *data, size_t count)
+  {
+    if (!open_ || entries_.empty() || entries_.back().kind != kind)
+    {
+      throw std::logic_error("no array of this element type is being written");
+    }
+    size_t bytes = count * entries_.back().elementSize;
+    file_.write(static_cast<const char *>(data), std::streamsize(bytes));
+    check();
+    position_ += bytes;
+    entries_.back().count += count;
+  }
+
+  void BinaryWriter::close()
+  {
+    if (!open_)
+    {
+      return;
+    }
+    open_ = false;
+    pad();
+    uint64_t tableOffset = position_;
+    for (const Entry &entry : entries_)
+    {
+      Block block{};
+      std::copy(entry.name.begin(), entry.name.end(), block.begin());
+      store<uint32_t>(block.data() + binary_name_size, uint32_t(entry.kind));
+      store<uint32_t>(block.data() + binary_name_size + 4, entry.elementSize);
+      store<uint64_t>(block.data() + binary_name_size + 8, entry.count);
+      store<uint64_t>(block.data() + binary_name_size + 16, entry.offset);
+      file_.write(reinterpret_cast<const char *>(block.data()), std::streamsize(block.size()));
+    }
+
+    Block block = header(tableOffset, entries_.size());
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char *>(block.data()), std::streamsize(block.size()));
+    file_.close();
+    check();
+  }
+
+  void BinaryWriter::pad()
+  {
+    static const char zeros[binary_alignment] = {};
+    size_t padding = (binary_alignment - position_ % binary_alignment) % binary_alignment;
+    file_.write(zeros, std::streamsize(padding));
+    check();
+    position_ += padding;
+  }
+
+  void BinaryWriter::check()
+  {
+    if (file_.fail())
+    {
+      open_ = false;
+      throw std::runtime_error("cannot write binary container " + path_);
+    }
+  }
+
+  MappedBinaryFile::MappedBinaryFile(const std::string &path)
+  {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      throw std::runtime_error("cannot open binary container " + path);
+    }
+    struct stat info{};
+    if (::fstat(fd, &info) != 0 || info.st_size < off_t(binary_header_size))
+    {
+      ::close(fd);
+      invalid(path, "too small");
+    }
+    size_ = size_t(info.st_size);
+    void *mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+      throw std::runtime_error("cannot map binary container " + path);
+    }
+    data_ = static_cast<const unsigned char *>(mapping);
+
+    try
+    {
+      if (!std::equal(binary_magic.begin(), binary_magic.end(), data_))
+      {
+        invalid(path, "bad magic");
+      }
+      if (load<uint32_t>(data_ + 8) != binary_format_version)
+      {
+        invalid(path, "unsupported version");
+      }
+      if (load<uint32_t>(data_ + 12) != sizeof(real_t))
+      {
+        invalid(path, "written with a different real_t");
+      }
+      uint64_t tableOffset = load<uint64_t>(data_ + 16);
+      uint64_t arrayCount = load<uint64_t>(data_ + 24);
+      if (tableOffset < binary_header_size || tableOffset % binary_alignment != 0 || tableOffset > size_ ||
+          arrayCount > (size_ - tableOffset) / binary_entry_size)
+      {
+        invalid(path, "truncated table");
+      }
+
+      for (uint64_t i = 0; i < arrayCount; i++)
+      {
+        const unsigned char *entry = data_ + tableOffset + i * binary_entry_size;
+        const char *name = reinterpret_cast<const char *>(entry);
+        ArrayInfo array{std::string(name, strnlen(name, binary_name_size)),
+                        static_cast<BinaryElement>(load<uint32_t>(entry + binary_name_size)),
+                        load<uint64_t>(entry + binary_name_size + 8)};
+        uint32_t size = load<uint32_t>(entry + binary_name_size + 4);
+        uint64_t offset = load<uint64_t>(entry + binary_name_size + 16);
+        if (array.name.size() > binary_max_name || size == 0 || size != elementSize(array.kind))
+        {
+          invalid(path, "bad element type");
+        }
+        if (offset % binary_alignment != 0 || offset < binary_header_size || offset > tableOffset ||
+            array.count > (tableOffset - offset) / size)
+        {
+          invalid(path, "array out of bounds");
+        }
+        arrays_.push_back(std::move(array));
+        offsets_.push_back(offset);
+      }
+    }
+    catch (...)
+    {
+      unmap();
+      throw;
+    }
+  }
+
+  MappedBinaryFile::MappedBinaryFile(MappedBinaryFile &&other) noexcept
+      : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)),
+        arrays_(std::move(other.arrays_)), offsets_(std::move(other.offsets_))
+  {
+  }
+
+  MappedBinaryFile &MappedBinaryFile::operator=(MappedBinaryFile &&other) noexcept
+  {
+    if (this != &other)
+    {
+      unmap();
+      data_ = std::exchange(other.data_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+      arrays_ = std::move(other.arrays_);
+      offsets_ = std::move(other.offsets_);
+    }
+    return *this;
+  }
+
+  MappedBinaryFile::~MappedBinaryFile()
+  {
+    unmap();
+  }
+
+  size_t MappedBinaryFile::find(std::string_view name, BinaryElement kind) const
+  {
+    for (size_t i = 0; i < arrays_.size(); i++)
+    {
+      if (arrays_[i].name == name)
+      {
+        if (arrays_[i].kind != kind)
+        {
+          throw std::runtime_error("array " + std::string(name) + " has a different element type");
+        }
+        return i;
+      }
+    }
+    throw std::runtime_error("no array named " + std::string(name));
+  }
+
+  void MappedBinaryFile::unmap()
+  {
+    if (data_ != nullptr)
+    {
+      ::munmap(const_cast<unsigned char *>(data_), size_);
+      data_ = nullptr;
+      size_ = 0;
+    }
+  }
+}
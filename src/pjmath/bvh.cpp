@@ -0,0 +1,615 @@
+#include "pjmath/bvh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+
+#include "pjmath/parallel.hpp"
+
+namespace pjmath
+{
+  namespace
+  {
+    constexpr real_t infinity = std::numeric_limits<real_t>::infinity();
+
+    // Pending nodes never exceed the depth of the tree, which the build bounds by
+    // max_sah_depth SAH levels followed by at most 32 median levels.
+    constexpr size_t stack_size = Bvh::max_sah_depth + 64;
+
+    struct Box
+    {
+      real_t min[3] = {infinity, infinity, infinity};
+      real_t max[3] = {-infinity, -infinity, -infinity};
+
+      void expand(const real_t *point)
+      {
+        for (size_t k = 0; k < 3; k++)
+        {
+          min[k] = std::fmin(min[k], point[k]);
+          max[k] = std::fmax(max[k], point[k]);
+        }
+      }
+
+      void expand(const Box &box)
+      {
+        for (size_t k = 0; k < 3; k++)
+        {
+          min[k] = std::fmin(min[k], box.min[k]);
+          max[k] = std::fmax(max[k], box.max[k]);
+        }
+      }
+
+      real_t halfArea() const
+      {
+        real_t x = max[0] - min[0];
+        real_t y = max[1] - min[1];
+        real_t z = max[2] - min[2];
+        return x < 0 ? 0 : x * y + y * z + z * x;
+      }
+    };
+
+    struct Primitive
+    {
+      Box box{};
+      real_t centroid[3] = {};
+    };
+
+    struct BuildNode
+    {
+      Box box{};
+      uint32_t begin = 0;
+      uint32_t count = 0;
+      uint32_t axis = 0;
+      std::unique_ptr<BuildNode> left{};
+      std::unique_ptr<BuildNode> right{};
+    };
+
+    Box triangleBox(const real_t *vertices, const uint32_t *triangle)
+    {
+      Box box;
+      for (size_t i = 0; i < 3; i++)
+      {
+        box.expand(vertices + 3 * size_t(triangle[i]));
+      }
+      return box;
+    }
+
+    class Builder
+    {
+    public:
+      Builder(const std::vector<Primitive> &primitives, std::vector<uint32_t> &order, const BvhBuildOptions &options)
+          : primitives_(primitives), order_(order), options_(options)
+      {
+      }
+
+      std::unique_ptr<BuildNode> build(uint32_t begin, uint32_t end, size_t depth) const
+      {
+        auto node = std::make_unique<BuildNode>();
+        node->begin = begin;
+        node->count = end - begin;
+
+        Box centroids;
+        for (uint32_t i = begin; i < end; i++)
+        {
+          const Primitive &primitive = primitives_[order_[i]];
+          node->box.expand(primitive.box);
+          centroids.expand(primitive.centroid);
+        }
+        if (node->count <= 1)
+        {
+          return node;
+        }
+
+        uint32_t middle = depth < Bvh::max_sah_depth ? sahSplit(*node, centroids) : begin;
+        if (middle == begin && node->count > options_.maxLeafSize)
+        {
+          middle = medianSplit(*node, centroids);
+        }
+        if (middle == begin)
+        {
+          return node;
+        }
+
+        auto buildLeft = [&]() { node->left = build(begin, middle, depth + 1); };
+        auto buildRight = [&]() { node->right = build(middle, end, depth + 1); };
+        if (node->count >= options_.parallelThreshold)
+        {
+          parallelInvoke(buildLeft, buildRight);
+        }
+        else
+        {
+          buildLeft();
+          buildRight();
+        }
+        node->count = 0;
+        return node;
+      }
+
+    private:
+      /**
+       * Bins the centroids along every axis and partitions at the cheapest bin boundary,
+       * returns the begin of the node if keeping a leaf is cheaper.
+       */
+      uint32_t sahSplit(BuildNode &node, const Box &centroids) const
+      {
+        size_t bins = std::max<size_t>(options_.binCount, 2);
+        std::vector<Box> binBoxes(bins);
+        std::vector<uint32_t> binCounts(bins);
+        std::vector<real_t> rightCosts(bins);
+
+        real_t bestCost = options_.intersectionCost * node.count;
+        size_t bestAxis = 0;
+        size_t bestBin = 0;
+        real_t parentArea = node.box.halfArea();
+        for (size_t axis = 0; axis < 3; axis++)
+        {
+          real_t extent = centroids.max[axis] - centroids.min[axis];
+          if (!(extent > 0))
+          {
+            continue;
+          }
+          std::fill(binBoxes.begin(), binBoxes.end(), Box{});
+          std::fill(binCounts.begin(), binCounts.end(), 0);
+          for (uint32_t i = node.begin; i < node.begin + node.count; i++)
+          {
+            const Primitive &primitive = primitives_[order_[i]];
+            size_t bin = binIndex(primitive.centroid[axis], centroids.min[axis], extent, bins);
+            binBoxes[bin].expand(primitive.box);
+            binCounts[bin]++;
+          }
+
+          Box right;
+          uint32_t rightCount = 0;
+          for (size_t bin = bins - 1; bin > 0; bin--)
+          {
+            right.expand(binBoxes[bin]);
+            rightCount += binCounts[bin];
+            rightCosts[bin] = right.halfArea() * rightCount;
+          }
+          Box left;
+          uint32_t leftCount = 0;
+          for (size_t bin = 1; bin < bins; bin++)
+          {
+            left.expand(binBoxes[bin - 1]);
+            leftCount += binCounts[bin - 1];
+            if (leftCount == 0 || leftCount == node.count)
+            {
+              continue;
+            }
+            real_t cost = options_.traversalCost +
+                          options_.intersectionCost * (left.halfArea() * leftCount + rightCosts[bin]) / parentArea;
+            if (cost < bestCost)
+            {
+              bestCost = cost;
+              bestAxis = axis;
+              bestBin = bin;
+            }
+          }
+        }
+        if (bestBin == 0)
+        {
+          return node.begin;
+        }
+
+        real_t extent = centroids.max[bestAxis] - centroids.min[bestAxis];
+        auto first = order_.begin() + node.begin;
+        auto middle = std::partition(first, first + node.count, [&](uint32_t i) {
+          return binIndex(primitives_[i].centroid[bestAxis], centroids.min[bestAxis], extent, bins) < bestBin;
+        });
+        node.axis = uint32_t(bestAxis);
+        return uint32_t(middle - order_.begin());
+      }
+
+      /**
+       * Splits at the median centroid along the widest axis, or in index order if every
+       * centroid coincides.
+       */
+      uint32_t medianSplit(BuildNode &node, const Box &centroids) const
+      {
+        size_t axis = 0;
+        for (size_t k = 1; k < 3; k++)
+        {
+          if (centroids.max[k] - centroids.min[k] > centroids.max[axis] - centroids.min[axis])
+          {
+            axis = k;
+          }
+        }
+        auto first = order_.begin() + node.begin;
+        auto middle = first + node.count / 2;
+        std::nth_element(first, middle, first + node.count, [&](uint32_t a, uint32_t b) {
+          return primitives_[a].centroid[axis] < primitives_[b].centroid[axis];
+        });
+        node.axis = uint32_t(axis);
+        return uint32_t(middle - order_.begin());
+      }
+
+      static size_t binIndex(real_t centroid, real_t min, real_t extent, size_t bins)
+      {
+        size_t bin = size_t((centroid - min) / extent * real_t(bins));
+        return bin < bins ? bin : bins - 1;
+      }
+
+      const std::vector<Primitive> &primitives_;
+      std::vector<uint32_t> &order_;
+      const BvhBuildOptions &options_;
+    };
+
+    void copyBox(const Box &box, Bvh::Node &node)
+    {
+      for (size_t k = 0; k < 3; k++)
+      {
+        node.min[k] = box.min[k];
+        node.max[k] = box.max[k];
+      }
+    }
+
+    void flatten(const BuildNode &build, std::vector<Bvh::Node> &nodes)
+    {
+      size_t index = nodes.size();
+      nodes.emplace_back();
+      copyBox(build.box, nodes[index]);
+      nodes[index].axis = build.axis;
+      nodes[index].count = build.count;
+      if (build.left)
+      {
+        flatten(*build.left, nodes);
+        nodes[index].offset = uint32_t(nodes.size());
+        flatten(*build.right, nodes);
+      }
+      else
+      {
+        nodes[index].offset = build.begin;
+      }
+    }
+
+    size_t countNodes(const BuildNode &build)
+    {
+      return build.left ? 1 + countNodes(*build.left) + countNodes(*build.right) : 1;
+    }
+
+    /**
+     * Slab test against the node bounds, true if the ray enters them within [tMin, tMax].
+     */
+    bool overlaps(const Bvh::Node &node, const real_t *origin, const real_t *inverse, real_t tMin, real_t tMax)
+    {
+      for (size_t k = 0; k < 3; k++)
+      {
+        real_t t0 = (node.min[k] - origin[k]) * inverse[k];
+        real_t t1 = (node.max[k] - origin[k]) * inverse[k];
+        tMin = std::fmax(tMin, std::fmin(t0, t1));
+        tMax = std::fmin(tMax, std::fmax(t0, t1));
+      }
+      return tMin <= tMax;
+    }
+
+    /**
+     * Rays of one packet as structure of arrays, lanes past the last ray never hit anything.
+     */
+    struct Packet
+    {
+      real_t origin[3][Bvh::packet_size];
+      real_t direction[3][Bvh::packet_size];
+      real_t inverse[3][Bvh::packet_size];
+      real_t tMin[Bvh::packet_size];
+      real_t tMax[Bvh::packet_size];
+      uint32_t triangle[Bvh::packet_size];
+      real_t u[Bvh::packet_size];
+      real_t v[Bvh::packet_size];
+    };
+
+    /**
+     * Triangle columns of a hierarchy and the Möller–Trumbore test against them.
+     */
+    struct TriangleColumns
+    {
+      const real_t *v0[3];
+      const real_t *e1[3];
+      const real_t *e2[3];
+
+      TriangleColumns(const SoAVec3Array &v0Array, const SoAVec3Array &e1Array, const SoAVec3Array &e2Array)
+          : v0{v0Array.x().data(), v0Array.y().data(), v0Array.z().data()},
+            e1{e1Array.x().data(), e1Array.y().data(), e1Array.z().data()},
+            e2{e2Array.x().data(), e2Array.y().data(), e2Array.z().data()}
+      {
+      }
+
+      /**
+       * Intersects one ray with triangle @a j, true if it hits with a ray parameter in [tMin, tMax).
+       */
+      bool test(size_t j, const real_t *origin, const real_t *direction, real_t tMin, real_t tMax,
+                real_t &t, real_t &u, real_t &v) const
+      {
+        real_t px = direction[1] * e2[2][j] - direction[2] * e2[1][j];
+        real_t py = direction[2] * e2[0][j] - direction[0] * e2[2][j];
+        real_t pz = direction[0] * e2[1][j] - direction[1] * e2[0][j];
+        real_t det = e1[0][j] * px + e1[1][j] * py + e1[2][j] * pz;
+        real_t inverse = 1 / det;
+
+        real_t tx = origin[0] - v0[0][j];
+        real_t ty = origin[1] - v0[1][j];
+        real_t tz = origin[2] - v0[2][j];
+        u = (tx * px + ty * py + tz * pz) * inverse;
+
+        real_t qx = ty * e1[2][j] - tz * e1[1][j];
+        real_t qy = tz * e1[0][j] - tx * e1[2][j];
+        real_t qz = tx * e1[1][j] - ty * e1[0][j];
+        v = (direction[0] * qx + direction[1] * qy + direction[2] * qz) * inverse;
+        t = (e2[0][j] * qx + e2[1][j] * qy + e2[2][j] * qz) * inverse;
+
+        return det != 0 && u >= 0 && v >= 0 && u + v <= 1 && t >= tMin && t < tMax;
+      }
+    };
+  }
+
+  void Bvh::build(const real_t *vertices, size_t vertexCount, std::span<const uint32_t> indices,
+                  const BvhBuildOptions &options)
+  {
+    if (indices.size() % 3 != 0)
+    {
+      throw std::invalid_argument("triangle indices are not a multiple of three");
+    }
+    for (uint32_t index : indices)
+    {
+      if (index >= vertexCount)
+      {
+        throw std::out_of_range("triangle index does not name a vertex");
+      }
+    }
+    vertexCount_ = vertexCount;
+    indices_.assign(indices.begin(), indices.end());
+
+    size_t count = indices.size() / 3;
+    if (count == 0)
+    {
+      return;
+    }
+    if (count > std::numeric_limits<uint32_t>::max())
+    {
+      throw std::invalid_argument("too many triangles");
+    }
+
+    std::vector<Primitive> primitives(count);
+    parallelFor(0, count, 4096, [&](size_t first, size_t last) {
+      for (size_t i = first; i < last; i++)
+      {
+        primitives[i].box = triangleBox(vertices, &indices_[3 * i]);
+        for (size_t k = 0; k < 3; k++)
+        {
+          primitives[i].centroid[k] = (primitives[i].box.min[k] + primitives[i].box.max[k]) * real_t(0.5);
+        }
+      }
+    });
+
+    std::vector<uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::unique_ptr<BuildNode> root = Builder(primitives, order, options).build(0, uint32_t(count), 0);
+
+    nodes_.clear();
+    nodes_.reserve(countNodes(*root));
+    flatten(*root, nodes_);
+
+    triangles_.assign(order.begin(), order.end());
+    v0_.resize(count);
+    e1_.resize(count);
+    e2_.resize(count);
+    storeTriangles(vertices);
+  }
+
+  void Bvh::storeTriangles(const real_t *vertices)
+  {
+    parallelFor(0, triangles_.size(), 4096, [&](size_t first, size_t last) {
+      for (size_t j = first; j < last; j++)
+      {
+        const uint32_t *triangle = &indices_[3 * size_t(triangles_[j])];
+        const real_t *a = vertices + 3 * size_t(triangle[0]);
+        const real_t *b = vertices + 3 * size_t(triangle[1]);
+        const real_t *c = vertices + 3 * size_t(triangle[2]);
+        for (size_t k = 0; k < 3; k++)
+        {
+          v0_.column(k)[j] = a[k];
+          e1_.column(k)[j] = b[k] - a[k];
+          e2_.column(k)[j] = c[k] - a[k];
+        }
+      }
+    });
+  }
+
+  void Bvh::refit(const real_t *vertices, size_t vertexCount)
+  {
+    if (vertexCount != vertexCount_)
+    {
+      throw std::invalid_argument("refit vertex count differs from the built mesh");
+    }
+    storeTriangles(vertices);
+
+    // Children always follow their parent, so a reverse sweep sees both before the parent
+    for (size_t i = nodes_.size(); i-- > 0;)
+    {
+      Node &node = nodes_[i];
+      Box box;
+      if (node.isLeaf())
+      {
+        for (size_t j = node.offset; j < node.offset + node.count; j++)
+        {
+          box.expand(triangleBox(vertices, &indices_[3 * size_t(triangles_[j])]));
+        }
+      }
+      else
+      {
+        const Node &left = nodes_[i + 1];
+        const Node &right = nodes_[node.offset];
+        for (size_t k = 0; k < 3; k++)
+        {
+          box.min[k] = std::fmin(left.min[k], right.min[k]);
+          box.max[k] = std::fmax(left.max[k], right.max[k]);
+        }
+      }
+      copyBox(box, node);
+    }
+  }
+
+  RayHit Bvh::intersect(const Ray &ray) const
+  {
+    RayHit hit;
+    if (nodes_.empty())
+    {
+      return hit;
+    }
+
+    real_t origin[3] = {ray.origin.x(), ray.origin.y(), ray.origin.z()};
+    real_t direction[3] = {ray.direction.x(), ray.direction.y(), ray.direction.z()};
+    real_t inverse[3] = {1 / direction[0], 1 / direction[1], 1 / direction[2]};
+    real_t tMax = ray.tMax;
+    TriangleColumns columns(v0_, e1_, e2_);
+
+    uint32_t stack[stack_size];
+    size_t top = 0;
+    uint32_t current = 0;
+    while (true)
+    {
+      const Node &node = nodes_[current];
+      if (overlaps(node, origin, inverse, ray.tMin, tMax))
+      {
+        if (!node.isLeaf())
+        {
+          uint32_t near = current + 1;
+          uint32_t far = node.offset;
+          if (direction[node.axis] < 0)
+          {
+            std::swap(near, far);
+          }
+          stack[top++] = far;
+          current = near;
+          continue;
+        }
+        for (size_t j = node.offset; j < node.offset + node.count; j++)
+        {
+          real_t t, u, v;
+          if (columns.test(j, origin, direction, ray.tMin, tMax, t, u, v))
+          {
+            tMax = t;
+            hit = RayHit{triangles_[j], t, u, v};
+          }
+        }
+      }
+      if (top == 0)
+      {
+        return hit;
+      }
+      current = stack[--top];
+    }
+  }
+
+  void Bvh::intersect(std::span<const Ray> rays, std::span<RayHit> hits) const
+  {
+    if (rays.size() != hits.size())
+    {
+      throw std::invalid_argument("batch sizes do not match");
+    }
+    if (nodes_.empty())
+    {
+      std::fill(hits.begin(), hits.end(), RayHit{});
+      return;
+    }
+
+    size_t packets = (rays.size() + packet_size - 1) / packet_size;
+    parallelFor(0, packets, 64, [&](size_t firstPacket, size_t lastPacket) {
+      TriangleColumns columns(v0_, e1_, e2_);
+      Packet packet;
+      for (size_t p = firstPacket; p < lastPacket; p++)
+      {
+        size_t first = p * packet_size;
+        size_t count = std::min(packet_size, rays.size() - first);
+        for (size_t lane = 0; lane < packet_size; lane++)
+        {
+          const Ray *ray = lane < count ? &rays[first + lane] : nullptr;
+          for (size_t k = 0; k < 3; k++)
+          {
+            packet.origin[k][lane] = ray ? ray->origin.at(k) : 0;
+            packet.direction[k][lane] = ray ? ray->direction.at(k) : 1;
+            packet.inverse[k][lane] = 1 / packet.direction[k][lane];
+          }
+          packet.tMin[lane] = ray ? ray->tMin : 0;
+          packet.tMax[lane] = ray ? ray->tMax : -infinity;
+          packet.triangle[lane] = RayHit::none;
+          packet.u[lane] = 0;
+          packet.v[lane] = 0;
+        }
+
+        uint32_t stack[stack_size];
+        size_t top = 0;
+        uint32_t current = 0;
+        while (true)
+        {
+          const Node &node = nodes_[current];
+          bool active = false;
+          for (size_t lane = 0; lane < packet_size; lane++)
+          {
+            real_t origin[3] = {packet.origin[0][lane], packet.origin[1][lane], packet.origin[2][lane]};
+            real_t inverse[3] = {packet.inverse[0][lane], packet.inverse[1][lane], packet.inverse[2][lane]};
+            active |= overlaps(node, origin, inverse, packet.tMin[lane], packet.tMax[lane]);
+          }
+          if (active)
+          {
+            if (!node.isLeaf())
+            {
+              uint32_t near = current + 1;
+              uint32_t far = node.offset;
+              if (packet.direction[node.axis][0] < 0)
+              {
+                std::swap(near, far);
+              }
+              stack[top++] = far;
+              current = near;
+              continue;
+            }
+            for (size_t j = node.offset; j < node.offset + node.count; j++)
+            {
+              for (size_t lane = 0; lane < packet_size; lane++)
+              {
+                real_t origin[3] = {packet.origin[0][lane], packet.origin[1][lane], packet.origin[2][lane]};
+                real_t direction[3] = {packet.direction[0][lane], packet.direction[1][lane],
+                                       packet.direction[2][lane]};
+                real_t t, u, v;
+                if (columns.test(j, origin, direction, packet.tMin[lane], packet.tMax[lane], t, u, v))
+                {
+                  packet.tMax[lane] = t;
+                  packet.triangle[lane] = triangles_[j];
+                  packet.u[lane] = u;
+                  packet.v[lane] = v;
+                }
+              }
+            }
+          }
+          if (top == 0)
+          {
+            break;
+          }
+          current = stack[--top];
+        }
+
+        for (size_t lane = 0; lane < count; lane++)
+        {
+          RayHit &hit = hits[first + lane];
+          hit = RayHit{};
+          if (packet.triangle[lane] != RayHit::none)
+          {
+            hit = RayHit{packet.triangle[lane], packet.tMax[lane], packet.u[lane], packet.v[lane]};
+          }
+        }
+      }
+    });
+  }
+
+  Aabb Bvh::bounds() const
+  {
+    if (nodes_.empty())
+    {
+      return Aabb::empty();
+    }
+    const Node &root = nodes_[0];
+    return Aabb{Vec3{root.min[0], root.min[1], root.min[2]}, Vec3{root.max[0], root.max[1], root.max[2]}};
+  }
+}
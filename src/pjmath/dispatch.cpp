@@ -0,0 +1,222 @@
+#include "pjmath/dispatch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "isa/kernel_table.hpp"
+#include "pjmath/kernels.hpp"
+#include "pjmath/packed.hpp"
+#include "pjmath/parallel.hpp"
+
+namespace pjmath
+{
+  namespace
+  {
+    constexpr Isa all_isas[] = {Isa::baseline, Isa::sse42, Isa::avx2, Isa::avx512};
+
+    const isa::KernelTable &tableOf(Isa level)
+    {
+      switch (level)
+      {
+#if defined(PJMATH_MULTI_ISA)
+      case Isa::sse42:
+        return isa::sse42_kernels;
+      case Isa::avx2:
+        return isa::avx2_kernels;
+      case Isa::avx512:
+        return isa::avx512_kernels;
+#endif
+      default:
+        return isa::baseline_kernels;
+      }
+    }
+
+    Isa bestIsa()
+    {
+      Isa best = Isa::baseline;
+      for (Isa level : all_isas)
+      {
+        if (isaSupported(level))
+        {
+          best = level;
+        }
+      }
+
+      const char *requested = std::getenv("PJMATH_ISA");
+      if (requested == nullptr)
+      {
+        return best;
+      }
+      for (Isa level : all_isas)
+      {
+        if (std::strcmp(requested, isaName(level)) == 0)
+        {
+          return level < best ? level : best;
+        }
+      }
+      return best;
+    }
+
+    // Smallest number of reproducible summation blocks worth giving to a thread
+    constexpr size_t reproducible_grain = 16;
+
+    /**
+     * Computes every block of kernels::reproducibleReduce with @a leaf in parallel, then
+     * combines them with the same tree.
+     */
+    template <typename Leaf>
+    real_t reproducibleReduce(size_t n, Leaf leaf)
+    {
+      if (n == 0)
+      {
+        return 0;
+      }
+      constexpr size_t block = kernels::reproducible_block;
+      size_t blocks = (n + block - 1) / block;
+      std::vector<real_t> partials(blocks);
+      parallelFor(0, blocks, reproducible_grain, [&](size_t first, size_t last) {
+        for (size_t b = first; b < last; b++)
+        {
+          size_t begin = b * block;
+          partials[b] = leaf(begin, std::min(n, begin + block) - begin);
+        }
+      });
+      return kernels::blockTreeReduce<real_t>(0, blocks, [&partials](size_t b) { return partials[b]; });
+    }
+
+    std::atomic<const isa::KernelTable *> active_table{nullptr};
+    std::atomic<Isa> active_level{Isa::baseline};
+
+    const isa::KernelTable &activeKernels()
+    {
+      const isa::KernelTable *table = active_table.load(std::memory_order_acquire);
+      if (table == nullptr)
+      {
+        // Racing first calls all pick the same level
+        Isa level = bestIsa();
+        active_level.store(level, std::memory_order_relaxed);
+        table = &tableOf(level);
+        active_table.store(table, std::memory_order_release);
+      }
+      return *table;
+    }
+  }
+
+  const char *isaName(Isa isa)
+  {
+    switch (isa)
+    {
+    case Isa::sse42:
+      return "sse4.2";
+    case Isa::avx2:
+      return "avx2";
+    case Isa::avx512:
+      return "avx512";
+    default:
+      return "baseline";
+    }
+  }
+
+  bool isaSupported(Isa isa)
+  {
+#if defined(PJMATH_MULTI_ISA)
+    __builtin_cpu_init();
+    switch (isa)
+    {
+    case Isa::sse42:
+      return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+    case Isa::avx2:
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c");
+    case Isa::avx512:
+      return isaSupported(Isa::avx2) && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") &&
+             __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512bw");
+    default:
+      return true;
+    }
+#else
+    return isa == Isa::baseline;
+#endif
+  }
+
+  Isa activeIsa()
+  {
+    activeKernels();
+    return active_level.load(std::memory_order_relaxed);
+  }
+
+  void setIsa(Isa isa)
+  {
+    if (!isaSupported(isa))
+    {
+      throw std::invalid_argument("instruction set is not supported");
+    }
+    active_level.store(isa, std::memory_order_relaxed);
+    active_table.store(&tableOf(isa), std::memory_order_release);
+  }
+
+  namespace dispatch
+  {
+    void transformPoints(const real_t *m, const real_t *points, real_t *out, size_t count)
+    {
+      activeKernels().transformPoints(m, points, out, count);
+    }
+
+    void multiply4x4(const real_t *a, const real_t *b, real_t *out, size_t count)
+    {
+      activeKernels().multiply4x4(a, b, out, count);
+    }
+
+    void sinCos(const real_t *x, real_t *sines, real_t *cosines, size_t n)
+    {
+      activeKernels().sinCos(x, sines, cosines, n);
+    }
+
+    real_t sum(const real_t *x, size_t n)
+    {
+      return activeKernels().sum(x, n);
+    }
+
+    real_t dot(const real_t *a, const real_t *b, size_t n)
+    {
+      return activeKernels().dot(a, b, n);
+    }
+
+    real_t reproducibleSum(const real_t *x, size_t n)
+    {
+      const isa::KernelTable &table = activeKernels();
+      return reproducibleReduce(n, [&table, x](size_t begin, size_t length) { return table.sum(x + begin, length); });
+    }
+
+    real_t reproducibleDot(const real_t *a, const real_t *b, size_t n)
+    {
+      const isa::KernelTable &table = activeKernels();
+      return reproducibleReduce(
+          n, [&table, a, b](size_t begin, size_t length) { return table.dot(a + begin, b + begin, length); });
+    }
+
+    void normalize3(real_t *xyz, size_t count)
+    {
+      activeKernels().normalize3(xyz, count);
+    }
+
+    void encodeHalf(const real_t *values, uint16_t *bits, size_t n)
+    {
+      for (size_t i = activeKernels().encodeHalf(values, bits, n); i < n; i++)
+      {
+        bits[i] = detail::floatToHalf(float(values[i]));
+      }
+    }
+
+    void decodeHalf(const uint16_t *bits, real_t *values, size_t n)
+    {
+      for (size_t i = activeKernels().decodeHalf(bits, values, n); i < n; i++)
+      {
+        values[i] = real_t(detail::halfToFloat(bits[i]));
+      }
+    }
+  }
+}
@@ -0,0 +1,392 @@
+#include "pjmath/eigen.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "pjmath/dispatch.hpp"
+#include "pjmath/parallel.hpp"
+
+namespace pjmath
+{
+  namespace
+  {
+    constexpr real_t sqrt3_halves = real_t(0.86602540378443864676);
+
+    // Squared length below which a cross product of two rows is no eigenvector
+    constexpr real_t degenerate_length =
+        eigen_degenerate_gap * eigen_degenerate_gap * eigen_degenerate_gap * eigen_degenerate_gap;
+
+    // Matrices per block of the batch decomposition
+    constexpr size_t eigen_block = 64;
+
+    struct Symmetric
+    {
+      real_t xx, yy, zz, xy, xz, yz;
+    };
+
+    Symmetric upperTriangle(const Mat3 &a)
+    {
+      return Symmetric{a[0], a[4], a[8], a[1], a[2], a[5]};
+    }
+
+    /**
+     * Divides the matrix by its largest element so the cubic neither overflows nor
+     * underflows, returns the divisor.
+     */
+    real_t normalizeScale(Symmetric &m)
+    {
+      real_t scale = std::fmax(std::fmax(std::fmax(std::fabs(m.xx), std::fabs(m.yy)), std::fabs(m.zz)),
+                               std::fmax(std::fmax(std::fabs(m.xy), std::fabs(m.xz)), std::fabs(m.yz)));
+      if (scale > 0)
+      {
+        real_t inverse = 1 / scale;
+        m = Symmetric{m.xx * inverse, m.yy * inverse, m.zz * inverse,
+                      m.xy * inverse, m.xz * inverse, m.yz * inverse};
+      }
+      return scale;
+    }
+
+    void jacobi(const Symmetric &m, size_t maxSweeps, real_t *values, real_t *vectors)
+    {
+      real_t a[3][3] = {{m.xx, m.xy, m.xz}, {m.xy, m.yy, m.yz}, {m.xz, m.yz, m.zz}};
+      real_t v[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+      constexpr size_t pairs[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+
+      for (size_t sweep = 0; sweep < maxSweeps; sweep++)
+      {
+        real_t off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+        real_t diagonal = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+        if (off <= std::numeric_limits<real_t>::min() ||
+            off <= std::numeric_limits<real_t>::epsilon() * std::numeric_limits<real_t>::epsilon() * diagonal)
+        {
+          break;
+        }
+        for (const auto &pair : pairs)
+        {
+          size_t p = pair[0];
+          size_t q = pair[1];
+          if (a[p][q] == 0)
+          {
+            continue;
+          }
+          real_t theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+          real_t t = std::copysign(real_t(1), theta) / (std::fabs(theta) + std::sqrt(theta * theta + 1));
+          real_t c = 1 / std::sqrt(t * t + 1);
+          real_t s = t * c;
+
+          a[p][p] -= t * a[p][q];
+          a[q][q] += t * a[p][q];
+          a[p][q] = a[q][p] = 0;
+          size_t r = 3 - p - q;
+          real_t arp = a[r][p];
+          real_t arq = a[r][q];
+          a[r][p] = a[p][r] = c * arp - s * arq;
+          a[r][q] = a[q][r] = s * arp + c * arq;
+          for (size_t k = 0; k < 3; k++)
+          {
+            real_t vkp = v[k][p];
+            real_t vkq = v[k][q];
+            v[k][p] = c * vkp - s * vkq;
+            v[k][q] = s * vkp + c * vkq;
+          }
+        }
+      }
+
+      size_t order[3] = {0, 1, 2};
+      std::sort(order, order + 3, [&a](size_t i, size_t j) { return a[i][i] < a[j][j]; });
+      for (size_t column = 0; column < 3; column++)
+      {
+        values[column] = a[order[column]][order[column]];
+        for (size_t row = 0; row < 3; row++)
+        {
+          vectors[row * 3 + column] = v[row][order[column]];
+        }
+      }
+
+      real_t det = vectors[0] * (vectors[4] * vectors[8] - vectors[5] * vectors[7]) -
+                   vectors[1] * (vectors[3] * vectors[8] - vectors[5] * vectors[6]) +
+                   vectors[2] * (vectors[3] * vectors[7] - vectors[4] * vectors[6]);
+      if (det < 0)
+      {
+        for (size_t row = 0; row < 3; row++)
+        {
+          vectors[row * 3 + 2] = -vectors[row * 3 + 2];
+        }
+      }
+    }
+
+    /**
+     * Matrices decomposed together, one column per element so every stage is a loop over
+     * the lanes with selects instead of branches.
+     */
+    template <size_t Lanes>
+    struct Block
+    {
+      real_t m[6][Lanes];       // xx, yy, zz, xy, xz and yz, divided by scale
+      real_t scale[Lanes];      // Largest element of each matrix
+      real_t values[3][Lanes];  // Ascending eigenvalues of the scaled matrices
+      real_t vectors[9][Lanes]; // Row-major eigenvector matrices
+      real_t gap[Lanes];        // Smallest difference of two eigenvalues
+      real_t length[Lanes];     // Squared length of the shorter unnormalized eigenvector
+    };
+
+    template <size_t Lanes>
+    Symmetric lane(const Block<Lanes> &block, size_t i)
+    {
+      return Symmetric{block.m[0][i], block.m[1][i], block.m[2][i], block.m[3][i], block.m[4][i], block.m[5][i]};
+    }
+
+    real_t minOf(real_t a, real_t b)
+    {
+      return a < b ? a : b;
+    }
+
+    real_t maxOf(real_t a, real_t b)
+    {
+      return a > b ? a : b;
+    }
+
+    /**
+     * Three components kept in scalars, so selects between them stay branch free.
+     */
+    struct Triple
+    {
+      real_t x, y, z;
+    };
+
+    Triple cross(const Triple &a, const Triple &b)
+    {
+      return Triple{a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+    }
+
+    real_t dot(const Triple &a, const Triple &b)
+    {
+      return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    Triple scaled(const Triple &a, real_t s)
+    {
+      return Triple{a.x * s, a.y * s, a.z * s};
+    }
+
+    Triple select(bool condition, const Triple &a, const Triple &b)
+    {
+      return Triple{condition ? a.x : b.x, condition ? a.y : b.y, condition ? a.z : b.z};
+    }
+
+    /**
+     * Unnormalized eigenvector of @a value as the longest cross product of two rows of
+     * A - value I, whose squared length is stored in @a length. Always inlined so the loops
+     * calling it vectorize.
+     */
+    [[gnu::always_inline]] inline Triple eigenvector(const Symmetric &m, real_t value, real_t &length)
+    {
+      Triple r0{m.xx - value, m.xy, m.xz};
+      Triple r1{m.xy, m.yy - value, m.yz};
+      Triple r2{m.xz, m.yz, m.zz - value};
+      Triple c01 = cross(r0, r1);
+      Triple c02 = cross(r0, r2);
+      Triple c12 = cross(r1, r2);
+      real_t length01 = dot(c01, c01);
+      real_t length02 = dot(c02, c02);
+      real_t length12 = dot(c12, c12);
+      bool take02 = length02 > length01;
+      bool take12 = length12 > maxOf(length01, length02);
+      length = take12 ? length12 : maxOf(length01, length02);
+      return select(take12, c12, select(take02, c02, c01));
+    }
+
+    /**
+     * Decomposes the first @a count matrices of @a block, whose elements are loaded in m.
+     *
+     * Eigenvalues come from the trigonometric solution of the characteristic cubic, with
+     * both cosines taken from one dispatched sine and cosine of the angle. Eigenvectors are
+     * built for every lane, then replaced by Jacobi rotations in the lanes whose eigenvalues
+     * are too close for them.
+     */
+    template <size_t Lanes>
+    void decompose(Block<Lanes> &block, size_t count)
+    {
+      real_t angles[Lanes];
+      real_t q[Lanes];
+      real_t p[Lanes];
+
+      for (size_t i = 0; i < Lanes; i++)
+      {
+        // Adding the smallest normal number keeps zero matrices from dividing by zero without
+        // a select, which the compiler would turn back into a conditional division
+        real_t scale = maxOf(maxOf(maxOf(std::fabs(block.m[0][i]), std::fabs(block.m[1][i])), std::fabs(block.m[2][i])),
+                             maxOf(maxOf(std::fabs(block.m[3][i]), std::fabs(block.m[4][i])), std::fabs(block.m[5][i])));
+        scale += std::numeric_limits<real_t>::min();
+        real_t inverse = 1 / scale;
+        for (size_t k = 0; k < 6; k++)
+        {
+          block.m[k][i] *= inverse;
+        }
+        block.scale[i] = scale;
+
+        Symmetric m = lane(block, i);
+        q[i] = (m.xx + m.yy + m.zz) / 3;
+        real_t bxx = m.xx - q[i];
+        real_t byy = m.yy - q[i];
+        real_t bzz = m.zz - q[i];
+        real_t p2 = bxx * bxx + byy * byy + bzz * bzz + 2 * (m.xy * m.xy + m.xz * m.xz + m.yz * m.yz);
+        p[i] = std::sqrt(p2 / 6);
+        real_t det = bxx * (byy * bzz - m.yz * m.yz) - m.xy * (m.xy * bzz - m.yz * m.xz) +
+                     m.xz * (m.xy * m.yz - byy * m.xz);
+        real_t r = det / (2 * p[i] * p[i] * p[i] + std::numeric_limits<real_t>::min());
+        angles[i] = r < -1 ? -1 : (r > 1 ? 1 : r);
+      }
+
+      // The only per lane library call left, kept out of the vectorized loops
+      for (size_t i = 0; i < Lanes; i++)
+      {
+        angles[i] = std::acos(angles[i]) / 3;
+      }
+      real_t sines[Lanes];
+      real_t cosines[Lanes];
+      dispatch::sinCos(angles, sines, cosines, Lanes);
+
+      for (size_t i = 0; i < Lanes; i++)
+      {
+        // cos(phi + 2pi/3) = -cos(phi) / 2 - sin(phi) sqrt(3) / 2
+        real_t shifted = -real_t(0.5) * cosines[i] - sqrt3_halves * sines[i];
+        real_t v2 = q[i] + 2 * p[i] * cosines[i];
+        real_t v0 = q[i] + 2 * p[i] * shifted;
+        real_t v1 = 3 * q[i] - v0 - v2;
+        block.values[0][i] = v0;
+        block.values[1][i] = v1;
+        block.values[2][i] = v2;
+
+        // Start from the eigenvalue furthest from the middle one, its vector is best conditioned
+        Symmetric m = lane(block, i);
+        bool first = v1 - v0 > v2 - v1;
+        real_t lengthD;
+        real_t lengthM;
+        Triple vd = eigenvector(m, first ? v0 : v2, lengthD);
+        Triple vm = eigenvector(m, v1, lengthM);
+        block.gap[i] = minOf(v1 - v0, v2 - v1);
+        block.length[i] = minOf(lengthD, lengthM);
+
+        vd = scaled(vd, 1 / std::sqrt(lengthD));
+        vm = scaled(vm, 1 / std::sqrt(lengthM));
+        Triple projection = scaled(vd, dot(vm, vd));
+        vm = Triple{vm.x - projection.x, vm.y - projection.y, vm.z - projection.z};
+        vm = scaled(vm, 1 / std::sqrt(dot(vm, vm)));
+
+        // The remaining vector completes a right handed basis, v2 = v0 x v1 and v0 = v1 x v2
+        Triple vo = scaled(cross(vd, vm), first ? 1 : -1);
+        Triple c0 = select(first, vd, vo);
+        Triple c2 = select(first, vo, vd);
+        Triple rows[3] = {{c0.x, vm.x, c2.x}, {c0.y, vm.y, c2.y}, {c0.z, vm.z, c2.z}};
+        for (size_t row = 0; row < 3; row++)
+        {
+          block.vectors[row * 3][i] = rows[row].x;
+          block.vectors[row * 3 + 1][i] = rows[row].y;
+          block.vectors[row * 3 + 2][i] = rows[row].z;
+        }
+      }
+
+      for (size_t i = 0; i < count; i++)
+      {
+        if (!(block.gap[i] >= eigen_degenerate_gap) || !(block.length[i] > degenerate_length))
+        {
+          real_t values[3];
+          real_t vectors[9];
+          jacobi(lane(block, i), 16, values, vectors);
+          for (size_t k = 0; k < 3; k++)
+          {
+            block.values[k][i] = values[k];
+          }
+          for (size_t k = 0; k < 9; k++)
+          {
+            block.vectors[k][i] = vectors[k];
+          }
+        }
+      }
+    }
+
+    SymmetricEigen toEigen(const real_t *values, const real_t *vectors)
+    {
+      SymmetricEigen eigen{Vec3{values[0], values[1], values[2]}, Mat3{}};
+      std::copy(vectors, vectors + 9, eigen.vectors.begin());
+      return eigen;
+    }
+  }
+
+  SymmetricEigen symmetricEigen(const Mat3 &a)
+  {
+    Block<1> block;
+    Symmetric m = upperTriangle(a);
+    real_t elements[6] = {m.xx, m.yy, m.zz, m.xy, m.xz, m.yz};
+    for (size_t k = 0; k < 6; k++)
+    {
+      block.m[k][0] = elements[k];
+    }
+    decompose(block, 1);
+
+    SymmetricEigen eigen{Vec3{}, Mat3{}};
+    for (size_t k = 0; k < 3; k++)
+    {
+      eigen.values[k] = block.values[k][0] * block.scale[0];
+    }
+    for (size_t k = 0; k < 9; k++)
+    {
+      eigen.vectors[k] = block.vectors[k][0];
+    }
+    return eigen;
+  }
+
+  SymmetricEigen symmetricEigenJacobi(const Mat3 &a, size_t maxSweeps)
+  {
+    Symmetric m = upperTriangle(a);
+    real_t scale = normalizeScale(m);
+    real_t values[3];
+    real_t vectors[9];
+    jacobi(m, maxSweeps, values, vectors);
+    for (real_t &value : values)
+    {
+      value *= scale;
+    }
+    return toEigen(values, vectors);
+  }
+
+  void symmetricEigen(const SymmetricMat3Array &matrices, SoAVec3Array &values, SoAVecArray<9> &vectors)
+  {
+    size_t count = matrices.size();
+    values.resize(count);
+    vectors.resize(count);
+
+    size_t blocks = (count + eigen_block - 1) / eigen_block;
+    parallelFor(0, blocks, 16, [&](size_t firstBlock, size_t lastBlock) {
+      Block<eigen_block> block;
+      for (size_t b = firstBlock; b < lastBlock; b++)
+      {
+        size_t first = b * eigen_block;
+        size_t n = std::min(eigen_block, count - first);
+        // The last block is padded with zero matrices
+        for (size_t k = 0; k < 6; k++)
+        {
+          const real_t *column = matrices.column(k).data() + first;
+          std::copy(column, column + n, block.m[k]);
+          std::fill(block.m[k] + n, block.m[k] + eigen_block, real_t(0));
+        }
+        decompose(block, n);
+
+        for (size_t k = 0; k < 3; k++)
+        {
+          real_t *column = values.column(k).data() + first;
+          for (size_t i = 0; i < n; i++)
+          {
+            column[i] = block.values[k][i] * block.scale[i];
+          }
+        }
+        for (size_t k = 0; k < 9; k++)
+        {
+          std::copy(block.vectors[k], block.vectors[k] + n, vectors.column(k).data() + first);
+        }
+      }
+    });
+  }
+}
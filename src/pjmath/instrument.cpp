@@ -0,0 +1,151 @@
+#include "pjmath/instrument.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace pjmath::instrument
+{
+  namespace detail
+  {
+    constinit thread_local ThreadCounters thread_counters{};
+  }
+
+  namespace
+  {
+    /**
+     * Per-thread state reachable from other threads, the timers are guarded by the mutex.
+     */
+    struct ThreadRecord
+    {
+      detail::ThreadCounters *counters = nullptr;
+      std::mutex mutex{};
+      std::map<std::string, TimerTotal> timers{};
+    };
+
+    struct Registry
+    {
+      std::mutex mutex{};
+      std::vector<ThreadRecord *> threads{};
+      Snapshot retired{}; ///< Totals of the threads which have exited
+    };
+
+    // Never destroyed, threads may still exit after static destruction has started
+    Registry &registry()
+    {
+      static Registry *registry = new Registry();
+      return *registry;
+    }
+
+    void accumulate(Snapshot &total, ThreadRecord &record)
+    {
+      for (size_t k = 0; k < counter_count; k++)
+      {
+        total.counters[k] += record.counters->counts[k].load(std::memory_order_relaxed);
+      }
+      std::lock_guard<std::mutex> lock(record.mutex);
+      for (const auto &[name, timer] : record.timers)
+      {
+        TimerTotal &sum = total.timers[name];
+        sum.calls += timer.calls;
+        sum.nanoseconds += timer.nanoseconds;
+      }
+    }
+
+    void clear(ThreadRecord &record)
+    {
+      for (std::atomic<uint64_t> &count : record.counters->counts)
+      {
+        count.store(0, std::memory_order_relaxed);
+      }
+      std::lock_guard<std::mutex> lock(record.mutex);
+      record.timers.clear();
+    }
+
+    /**
+     * Adds the thread to the registry when created and folds its totals into the retired
+     * ones when the thread exits.
+     */
+    struct Registration
+    {
+      Registration()
+      {
+        record.counters = &detail::thread_counters;
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        registry().threads.push_back(&record);
+      }
+
+      Registration(const Registration &) = delete;
+      Registration &operator=(const Registration &) = delete;
+
+      ~Registration()
+      {
+        Registry &global = registry();
+        std::lock_guard<std::mutex> lock(global.mutex);
+        accumulate(global.retired, record);
+        global.threads.erase(std::find(global.threads.begin(), global.threads.end(), &record));
+      }
+
+      ThreadRecord record{};
+    };
+
+    ThreadRecord &threadRecord()
+    {
+      static thread_local Registration registration;
+      detail::thread_counters.registered = true;
+      return registration.record;
+    }
+  }
+
+  namespace detail
+  {
+    void registerThread()
+    {
+      threadRecord();
+    }
+
+    void addTime(const char *name, uint64_t nanoseconds)
+    {
+      ThreadRecord &record = threadRecord();
+      std::lock_guard<std::mutex> lock(record.mutex);
+      TimerTotal &timer = record.timers[name];
+      timer.calls++;
+      timer.nanoseconds += nanoseconds;
+    }
+  }
+
+  Snapshot snapshot()
+  {
+    Snapshot total;
+    accumulate(total, threadRecord());
+    return total;
+  }
+
+  Snapshot totalSnapshot()
+  {
+    Registry &global = registry();
+    std::lock_guard<std::mutex> lock(global.mutex);
+    Snapshot total = global.retired;
+    for (ThreadRecord *record : global.threads)
+    {
+      accumulate(total, *record);
+    }
+    return total;
+  }
+
+  void reset()
+  {
+    clear(threadRecord());
+  }
+
+  void resetAll()
+  {
+    Registry &global = registry();
+    std::lock_guard<std::mutex> lock(global.mutex);
+    global.retired = Snapshot{};
+    for (ThreadRecord *record : global.threads)
+    {
+      clear(*record);
+    }
+  }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pjmath/definitions.hpp"
+
+/**
+ * Kernels compiled once per instruction set level, see kernels_impl.inc.
+ *
+ * Each level lives in its own translation unit built with the matching -m flags and
+ * exports nothing but its table, so no code compiled for a newer processor can be picked
+ * by the linker for a shared inline function.
+ */
+namespace pjmath::isa
+{
+  struct KernelTable
+  {
+    void (*transformPoints)(const real_t *m, const real_t *points, real_t *out, size_t count);
+    void (*multiply4x4)(const real_t *a, const real_t *b, real_t *out, size_t count);
+    void (*sinCos)(const real_t *x, real_t *sines, real_t *cosines, size_t n);
+    real_t (*sum)(const real_t *x, size_t n);
+    real_t (*dot)(const real_t *a, const real_t *b, size_t n);
+    void (*normalize3)(real_t *xyz, size_t count);
+
+    // Convert a leading part of the values and return its length, the caller converts the rest
+    size_t (*encodeHalf)(const real_t *values, uint16_t *bits, size_t n);
+    size_t (*decodeHalf)(const uint16_t *bits, real_t *values, size_t n);
+  };
+
+  extern const KernelTable baseline_kernels;
+#if defined(PJMATH_MULTI_ISA)
+  extern const KernelTable sse42_kernels;
+  extern const KernelTable avx2_kernels;
+  extern const KernelTable avx512_kernels;
+#endif
+}
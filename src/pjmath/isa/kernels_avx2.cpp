@@ -0,0 +1,2 @@
+#define PJMATH_ISA_KERNELS avx2_kernels
+#include "kernels_impl.inc"
@@ -0,0 +1,2 @@
+#define PJMATH_ISA_KERNELS avx512_kernels
+#include "kernels_impl.inc"
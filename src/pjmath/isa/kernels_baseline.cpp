@@ -0,0 +1,2 @@
+#define PJMATH_ISA_KERNELS baseline_kernels
+#include "kernels_impl.inc"
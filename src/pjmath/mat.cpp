@@ -0,0 +1,28 @@
+/**
+ * Explicit instantiations of the common matrix and vector types, declared extern at the end
+ * of their headers so including translation units do not compile their members again.
+ * Defining PJMATH_NO_EXTERN_TEMPLATES before including the headers opts out.
+ */
+
+#include "pjmath/mat3.hpp"
+#include "pjmath/mat4.hpp"
+#include "pjmath/vec3.hpp"
+#include "pjmath/vec4.hpp"
+
+namespace pjmath
+{
+  template class Mat<real_t, 3, 1, Vec3>;
+  template class Mat<real_t, 4, 1, Vec4>;
+
+  template class Mat<real_t, 3, 3, Mat3>;
+  template Mat3 Mat<real_t, 3, 3, Mat3>::operator*(const Mat3 &) const;
+  template Vec3 Mat<real_t, 3, 3, Mat3>::operator*(const Vec3 &) const;
+  template Mat3 &Mat<real_t, 3, 3, Mat3>::operator*=(const Mat &);
+  template Mat3 Mat<real_t, 3, 3, Mat3>::pow(uint64_t) const;
+
+  template class Mat<real_t, 4, 4, Mat4>;
+  template Mat4 Mat<real_t, 4, 4, Mat4>::operator*(const Mat4 &) const;
+  template Vec4 Mat<real_t, 4, 4, Mat4>::operator*(const Vec4 &) const;
+  template Mat4 &Mat<real_t, 4, 4, Mat4>::operator*=(const Mat &);
+  template Mat4 Mat<real_t, 4, 4, Mat4>::pow(uint64_t) const;
+}
@@ -0,0 +1,74 @@
+#include "pjmath/packed.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pjmath::detail
+{
+  namespace
+  {
+    constexpr real_t snorm16_scale = 32767;
+
+    // Rounds half away from zero with a truncating conversion, which vectorizes unlike lround
+    int16_t toSnorm16(real_t value)
+    {
+      real_t scaled = std::clamp(value, real_t(-1), real_t(1)) * snorm16_scale;
+      return int16_t(scaled + std::copysign(real_t(0.5), scaled));
+    }
+  }
+
+  void encodeBFloat16(const real_t *values, BFloat16 *out, size_t n)
+  {
+    for (size_t i = 0; i < n; i++)
+    {
+      out[i] = BFloat16(float(values[i]));
+    }
+  }
+
+  void decodeBFloat16(const BFloat16 *values, real_t *out, size_t n)
+  {
+    for (size_t i = 0; i < n; i++)
+    {
+      out[i] = real_t(float(values[i]));
+    }
+  }
+
+  void encodeOctahedral(const real_t *xyz, Octahedral *out, size_t count)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      real_t x = xyz[3 * i];
+      real_t y = xyz[3 * i + 1];
+      real_t z = xyz[3 * i + 2];
+      real_t l1 = std::fabs(x) + std::fabs(y) + std::fabs(z);
+      real_t inverse = l1 > 0 ? 1 / l1 : 0;
+      real_t u = x * inverse;
+      real_t v = y * inverse;
+      // Fold the lower half of the octahedron over the corners of the square, selected
+      // rather than branched on so the loop vectorizes
+      real_t foldedU = (1 - std::fabs(v)) * std::copysign(real_t(1), u);
+      real_t foldedV = (1 - std::fabs(u)) * std::copysign(real_t(1), v);
+      bool lower = z < 0;
+      u = lower ? foldedU : u;
+      v = lower ? foldedV : v;
+      out[i] = Octahedral{toSnorm16(u), toSnorm16(v)};
+    }
+  }
+
+  void decodeOctahedral(const Octahedral *values, real_t *xyz, size_t count)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      real_t u = std::max(real_t(values[i].u) / snorm16_scale, real_t(-1));
+      real_t v = std::max(real_t(values[i].v) / snorm16_scale, real_t(-1));
+      real_t z = 1 - std::fabs(u) - std::fabs(v);
+      real_t fold = std::max(-z, real_t(0));
+      real_t x = u - std::copysign(fold, u);
+      real_t y = v - std::copysign(fold, v);
+      real_t inverse = 1 / std::sqrt(x * x + y * y + z * z);
+      xyz[3 * i] = x * inverse;
+      xyz[3 * i + 1] = y * inverse;
+      xyz[3 * i + 2] = z * inverse;
+    }
+  }
+}
@@ -0,0 +1,476 @@
+#include "pjmath/sparse.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <utility>
+
+#include "pjmath/kernels.hpp"
+#include "pjmath/parallel.hpp"
+
+namespace pjmath
+{
+  namespace
+  {
+    // Smallest number of nonzeros worth multiplying on a separate thread
+    constexpr size_t sparse_grain = 1 << 15;
+
+    // Lines per cache line of the output, thread blocks start on multiples of this so no two
+    // threads write the same cache line
+    constexpr size_t sparse_line_alignment = 64 / sizeof(real_t);
+
+    void checkDimension(size_t count)
+    {
+      if (count > size_t(std::numeric_limits<uint32_t>::max()) + 1)
+      {
+        throw std::invalid_argument("sparse matrix dimension does not fit 32 bit indices");
+      }
+    }
+
+    void checkSize(size_t actual, size_t expected)
+    {
+      if (actual != expected)
+      {
+        throw std::invalid_argument("vector size does not match the matrix");
+      }
+    }
+
+    /**
+     * First line starting at or after the nonzero @a nonzero, rounded down to the alignment.
+     */
+    size_t lineBoundary(const detail::CompressedStorage &storage, size_t nonzero)
+    {
+      if (nonzero >= storage.values.size())
+      {
+        return storage.majorCount;
+      }
+      auto first = storage.offsets.begin();
+      size_t line = size_t(std::lower_bound(first, first + storage.majorCount, nonzero) - first);
+      return line - line % sparse_line_alignment;
+    }
+
+    /**
+     * Calls @a body(firstLine, lastLine) over blocks of lines holding similar numbers of
+     * nonzeros, at least @a grain of them, across threads when there are enough of them.
+     */
+    template <typename Body>
+    void forLineBlocks(const detail::CompressedStorage &storage, size_t grain, Body &&body)
+    {
+      size_t count = storage.values.size();
+      if (count < 2 * grain)
+      {
+        body(size_t(0), storage.majorCount);
+        return;
+      }
+      parallelFor(0, count, grain, [&storage, &body](size_t first, size_t last) {
+        size_t firstLine = first == 0 ? 0 : lineBoundary(storage, first);
+        size_t lastLine = lineBoundary(storage, last);
+        if (firstLine < lastLine)
+        {
+          body(firstLine, lastLine);
+        }
+      });
+    }
+
+    void gatherLines(const detail::CompressedStorage &storage, const real_t *x, real_t *y, size_t firstLine,
+                     size_t lastLine)
+    {
+      const size_t *offsets = storage.offsets.data();
+      const uint32_t *indices = storage.indices.data();
+      const real_t *values = storage.values.data();
+      for (size_t i = firstLine; i < lastLine; i++)
+      {
+        // Two accumulators hide the latency of the dependent additions on long lines
+        real_t even = 0;
+        real_t odd = 0;
+        size_t k = offsets[i];
+        size_t end = offsets[i + 1];
+        for (; k + 1 < end; k += 2)
+        {
+          even += values[k] * x[indices[k]];
+          odd += values[k + 1] * x[indices[k + 1]];
+        }
+        if (k < end)
+        {
+          even += values[k] * x[indices[k]];
+        }
+        y[i] = even + odd;
+      }
+    }
+
+    void scatterLines(const detail::CompressedStorage &storage, const real_t *x, real_t *y, size_t firstLine,
+                      size_t lastLine)
+    {
+      const size_t *offsets = storage.offsets.data();
+      const uint32_t *indices = storage.indices.data();
+      const real_t *values = storage.values.data();
+      for (size_t i = firstLine; i < lastLine; i++)
+      {
+        real_t xi = x[i];
+        if (xi == 0)
+        {
+          continue;
+        }
+        for (size_t k = offsets[i]; k < offsets[i + 1]; k++)
+        {
+          y[indices[k]] += values[k] * xi;
+        }
+      }
+    }
+  }
+
+  namespace detail
+  {
+    void CompressedStorage::validate() const
+    {
+      checkDimension(minorCount);
+      if (offsets.size() != majorCount + 1 || offsets.front() != 0 || offsets.back() != indices.size() ||
+          indices.size() != values.size())
+      {
+        throw std::invalid_argument("sparse matrix offsets do not match its nonzeros");
+      }
+      for (size_t i = 0; i < majorCount; i++)
+      {
+        if (offsets[i] > offsets[i + 1])
+        {
+          throw std::invalid_argument("sparse matrix offsets must not decrease");
+        }
+        for (size_t k = offsets[i]; k < offsets[i + 1]; k++)
+        {
+          if (indices[k] >= minorCount || (k > offsets[i] && indices[k] <= indices[k - 1]))
+          {
+            throw std::invalid_argument("sparse matrix indices must be in range, sorted and unique");
+          }
+        }
+      }
+    }
+
+    real_t CompressedStorage::at(size_t major, size_t minor) const
+    {
+      auto first = indices.begin() + std::ptrdiff_t(offsets[major]);
+      auto last = indices.begin() + std::ptrdiff_t(offsets[major + 1]);
+      auto found = std::lower_bound(first, last, uint32_t(minor));
+      return found != last && *found == minor ? values[size_t(found - indices.begin())] : 0;
+    }
+
+    CompressedStorage CompressedStorage::transposed() const
+    {
+      CompressedStorage transpose;
+      transpose.majorCount = minorCount;
+      transpose.minorCount = majorCount;
+      transpose.offsets.assign(minorCount + 1, 0);
+      for (uint32_t index : indices)
+      {
+        transpose.offsets[index + 1]++;
+      }
+      for (size_t i = 0; i < minorCount; i++)
+      {
+        transpose.offsets[i + 1] += transpose.offsets[i];
+      }
+
+      // Lines are visited in order, so every transposed line comes out sorted
+      transpose.indices.resize(indices.size());
+      transpose.values.resize(values.size());
+      std::vector<size_t> next(transpose.offsets.begin(), transpose.offsets.end() - 1);
+      for (size_t i = 0; i < majorCount; i++)
+      {
+        for (size_t k = offsets[i]; k < offsets[i + 1]; k++)
+        {
+          size_t position = next[indices[k]]++;
+          transpose.indices[position] = uint32_t(i);
+          transpose.values[position] = values[k];
+        }
+      }
+      return transpose;
+    }
+
+    void CompressedStorage::gather(std::span<const real_t> x, std::span<real_t> y) const
+    {
+      forLineBlocks(*this, sparse_grain, [this, &x, &y](size_t firstLine, size_t lastLine) {
+        gatherLines(*this, x.data(), y.data(), firstLine, lastLine);
+      });
+    }
+
+    void CompressedStorage::scatter(std::span<const real_t> x, std::span<real_t> y) const
+    {
+      std::fill(y.begin(), y.end(), real_t(0));
+      if (values.size() < 2 * sparse_grain)
+      {
+        scatterLines(*this, x.data(), y.data(), 0, majorCount);
+        return;
+      }
+
+      // Each block scatters into its own copy of the output, the copies are summed in line
+      // order afterwards so the result does not depend on thread scheduling. Blocks are sized
+      // so there is about one per thread, which bounds the memory of the copies.
+      std::mutex mutex;
+      std::vector<std::pair<size_t, std::vector<real_t>>> partials;
+      size_t grain = std::max(sparse_grain, values.size() / currentExecutor().concurrency() + 1);
+      forLineBlocks(*this, grain, [&](size_t firstLine, size_t lastLine) {
+        std::vector<real_t> partial(minorCount, real_t(0));
+        scatterLines(*this, x.data(), partial.data(), firstLine, lastLine);
+        std::lock_guard<std::mutex> lock(mutex);
+        partials.emplace_back(firstLine, std::move(partial));
+      });
+      std::sort(partials.begin(), partials.end(),
+                [](const auto &a, const auto &b) { return a.first < b.first; });
+      parallelFor(0, minorCount, sparse_grain, [&partials, &y](size_t first, size_t last) {
+        for (const auto &partial : partials)
+        {
+          kernels::addScaled(y.data() + first, partial.second.data() + first, real_t(1), last - first);
+        }
+      });
+    }
+
+    CompressedStorage CompressedStorage::compress(size_t majorCount, size_t minorCount, std::span<const uint32_t> major,
+                                                  std::span<const uint32_t> minor, std::span<const real_t> values)
+    {
+      // Counting sort by line keeps the insertion order within each line
+      std::vector<size_t> starts(majorCount + 1, 0);
+      for (uint32_t line : major)
+      {
+        starts[line + 1]++;
+      }
+      for (size_t i = 0; i < majorCount; i++)
+      {
+        starts[i + 1] += starts[i];
+      }
+      std::vector<std::pair<uint32_t, real_t>> entries(values.size());
+      std::vector<size_t> next(starts.begin(), starts.end() - 1);
+      for (size_t k = 0; k < values.size(); k++)
+      {
+        entries[next[major[k]]++] = {minor[k], values[k]};
+      }
+
+      CompressedStorage storage;
+      storage.majorCount = majorCount;
+      storage.minorCount = minorCount;
+      storage.offsets.reserve(majorCount + 1);
+      storage.indices.reserve(values.size());
+      storage.values.reserve(values.size());
+      for (size_t i = 0; i < majorCount; i++)
+      {
+        auto first = entries.begin() + std::ptrdiff_t(starts[i]);
+        auto last = entries.begin() + std::ptrdiff_t(starts[i + 1]);
+        std::stable_sort(first, last, [](const auto &a, const auto &b) { return a.first < b.first; });
+        for (auto entry = first; entry != last; ++entry)
+        {
+          if (storage.indices.size() > storage.offsets.back() && storage.indices.back() == entry->first)
+          {
+            storage.values.back() += entry->second;
+          }
+          else
+          {
+            storage.indices.push_back(entry->first);
+            storage.values.push_back(entry->second);
+          }
+        }
+        storage.offsets.push_back(storage.values.size());
+      }
+      return storage;
+    }
+  }
+
+  CsrMatrix::CsrMatrix(size_t rows, size_t columns, std::vector<size_t> rowOffsets,
+                       std::vector<uint32_t> columnIndices, std::vector<real_t> values)
+      : storage_{rows, columns, std::move(rowOffsets), std::move(columnIndices), std::move(values)}
+  {
+    storage_.validate();
+  }
+
+  real_t CsrMatrix::at(size_t row, size_t column) const
+  {
+    if (row >= rows() || column >= columns())
+    {
+      throw std::out_of_range("sparse matrix index out of range");
+    }
+    return storage_.at(row, column);
+  }
+
+  void CsrMatrix::multiply(std::span<const real_t> x, std::span<real_t> y) const
+  {
+    checkSize(x.size(), columns());
+    checkSize(y.size(), rows());
+    storage_.gather(x, y);
+  }
+
+  void CsrMatrix::multiplyTransposed(std::span<const real_t> x, std::span<real_t> y) const
+  {
+    checkSize(x.size(), rows());
+    checkSize(y.size(), columns());
+    storage_.scatter(x, y);
+  }
+
+  std::vector<real_t> CsrMatrix::diagonal() const
+  {
+    std::vector<real_t> diagonal(std::min(rows(), columns()));
+    for (size_t i = 0; i < diagonal.size(); i++)
+    {
+      diagonal[i] = storage_.at(i, i);
+    }
+    return diagonal;
+  }
+
+  CsrMatrix CsrMatrix::transposed() const
+  {
+    return CsrMatrix(storage_.transposed());
+  }
+
+  CscMatrix CsrMatrix::toCsc() const
+  {
+    return CscMatrix(storage_.transposed());
+  }
+
+  CscMatrix::CscMatrix(size_t rows, size_t columns, std::vector<size_t> columnOffsets,
+                       std::vector<uint32_t> rowIndices, std::vector<real_t> values)
+      : storage_{columns, rows, std::move(columnOffsets), std::move(rowIndices), std::move(values)}
+  {
+    storage_.validate();
+  }
+
+  real_t CscMatrix::at(size_t row, size_t column) const
+  {
+    if (row >= rows() || column >= columns())
+    {
+      throw std::out_of_range("sparse matrix index out of range");
+    }
+    return storage_.at(column, row);
+  }
+
+  void CscMatrix::multiply(std::span<const real_t> x, std::span<real_t> y) const
+  {
+    checkSize(x.size(), columns());
+    checkSize(y.size(), rows());
+    storage_.scatter(x, y);
+  }
+
+  void CscMatrix::multiplyTransposed(std::span<const real_t> x, std::span<real_t> y) const
+  {
+    checkSize(x.size(), rows());
+    checkSize(y.size(), columns());
+    storage_.gather(x, y);
+  }
+
+  CsrMatrix CscMatrix::toCsr() const
+  {
+    return CsrMatrix(storage_.transposed());
+  }
+
+  CooBuilder::CooBuilder(size_t rows, size_t columns) : rows_(rows), columns_(columns)
+  {
+    checkDimension(rows);
+    checkDimension(columns);
+  }
+
+  void CooBuilder::reserve(size_t count)
+  {
+    rowIndices_.reserve(count);
+    columnIndices_.reserve(count);
+    values_.reserve(count);
+  }
+
+  void CooBuilder::add(size_t row, size_t column, real_t value)
+  {
+    if (row >= rows_ || column >= columns_)
+    {
+      throw std::out_of_range("sparse matrix index out of range");
+    }
+    rowIndices_.push_back(uint32_t(row));
+    columnIndices_.push_back(uint32_t(column));
+    values_.push_back(value);
+  }
+
+  CsrMatrix CooBuilder::toCsr() const
+  {
+    return CsrMatrix(detail::CompressedStorage::compress(rows_, columns_, rowIndices_, columnIndices_, values_));
+  }
+
+  CscMatrix CooBuilder::toCsc() const
+  {
+    return CscMatrix(detail::CompressedStorage::compress(columns_, rows_, columnIndices_, rowIndices_, values_));
+  }
+
+  ConjugateGradientResult conjugateGradient(const CsrMatrix &a, std::span<const real_t> b, std::span<real_t> x,
+                                            real_t tolerance, size_t maxIterations)
+  {
+    size_t n = a.rows();
+    if (a.columns() != n)
+    {
+      throw std::invalid_argument("conjugate gradient needs a square matrix");
+    }
+    checkSize(b.size(), n);
+    checkSize(x.size(), n);
+    if (maxIterations == 0)
+    {
+      maxIterations = n;
+    }
+
+    ConjugateGradientResult result;
+    real_t bNorm = std::sqrt(kernels::dot(b.data(), b.data(), n));
+    if (bNorm == 0)
+    {
+      std::fill(x.begin(), x.end(), real_t(0));
+      result.converged = true;
+      return result;
+    }
+
+    std::vector<real_t> inverseDiagonal = a.diagonal();
+    for (real_t &d : inverseDiagonal)
+    {
+      d = d > 0 ? 1 / d : 1;
+    }
+
+    std::vector<real_t> r(n);
+    a.multiply(x, r);
+    for (size_t i = 0; i < n; i++)
+    {
+      r[i] = b[i] - r[i];
+    }
+    std::vector<real_t> z(n);
+    for (size_t i = 0; i < n; i++)
+    {
+      z[i] = inverseDiagonal[i] * r[i];
+    }
+    std::vector<real_t> p = z;
+    std::vector<real_t> ap(n);
+    real_t rz = kernels::dot(r.data(), z.data(), n);
+
+    for (;;)
+    {
+      result.residual = std::sqrt(kernels::dot(r.data(), r.data(), n)) / bNorm;
+      if (result.residual <= tolerance)
+      {
+        result.converged = true;
+        break;
+      }
+      if (result.iterations == maxIterations)
+      {
+        break;
+      }
+      result.iterations++;
+
+      a.multiply(p, ap);
+      real_t curvature = kernels::dot(p.data(), ap.data(), n);
+      if (!(curvature > 0))
+      {
+        // The matrix is not positive definite along p
+        break;
+      }
+      real_t alpha = rz / curvature;
+      kernels::addScaled(x.data(), p.data(), alpha, n);
+      kernels::addScaled(r.data(), ap.data(), -alpha, n);
+      for (size_t i = 0; i < n; i++)
+      {
+        z[i] = inverseDiagonal[i] * r[i];
+      }
+      real_t rzNext = kernels::dot(r.data(), z.data(), n);
+      real_t beta = rzNext / rz;
+      rz = rzNext;
+      for (size_t i = 0; i < n; i++)
+      {
+        p[i] = z[i] + beta * p[i];
+      }
+    }
+    return result;
+  }
+}
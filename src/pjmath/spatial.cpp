@@ -0,0 +1,766 @@
+#include "pjmath/spatial.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <list>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+
+#include "pjmath/parallel.hpp"
+
+namespace pjmath
+{
+  namespace
+  {
+    constexpr real_t infinity = std::numeric_limits<real_t>::infinity();
+
+    // Subtrees with at least this many points build on two threads
+    constexpr size_t parallel_build_size = 1 << 16;
+
+    // Queries per thread in batch queries
+    constexpr size_t batch_grain = 256;
+
+    bool closer(const Neighbor &a, const Neighbor &b)
+    {
+      return a.distanceSquared < b.distanceSquared ||
+             (a.distanceSquared == b.distanceSquared && a.index < b.index);
+    }
+
+    /**
+     * Keeps the k closest neighbours offered so far as a max heap at the end of @a found.
+     */
+    class NearestHeap
+    {
+    public:
+      NearestHeap(std::vector<Neighbor> &found, size_t k) : found_(found), start_(found.size()), k_(k)
+      {
+      }
+
+      real_t limit() const
+      {
+        return found_.size() - start_ < k_ ? infinity : found_[start_].distanceSquared;
+      }
+
+      void offer(const Neighbor &neighbor)
+      {
+        auto begin = found_.begin() + std::ptrdiff_t(start_);
+        if (found_.size() - start_ < k_)
+        {
+          found_.push_back(neighbor);
+          std::push_heap(found_.begin() + std::ptrdiff_t(start_), found_.end(), closer);
+        }
+        else if (closer(neighbor, *begin))
+        {
+          std::pop_heap(begin, found_.end(), closer);
+          found_.back() = neighbor;
+          std::push_heap(found_.begin() + std::ptrdiff_t(start_), found_.end(), closer);
+        }
+      }
+
+      void finish()
+      {
+        std::sort_heap(found_.begin() + std::ptrdiff_t(start_), found_.end(), closer);
+      }
+
+    private:
+      std::vector<Neighbor> &found_;
+      size_t start_;
+      size_t k_;
+    };
+
+    uint32_t spreadBits(uint32_t v)
+    {
+      v &= 0x3ff;
+      v = (v | (v << 16)) & 0x30000ff;
+      v = (v | (v << 8)) & 0x300f00f;
+      v = (v | (v << 4)) & 0x30c30c3;
+      v = (v | (v << 2)) & 0x9249249;
+      return v;
+    }
+
+    /**
+     * Orders points along a 30 bit Morton curve over their bounding box.
+     */
+    std::vector<uint32_t> mortonOrder(const real_t *points, size_t count)
+    {
+      real_t lower[3] = {infinity, infinity, infinity};
+      real_t upper[3] = {-infinity, -infinity, -infinity};
+      for (size_t i = 0; i < count; i++)
+      {
+        for (size_t k = 0; k < 3; k++)
+        {
+          lower[k] = std::fmin(lower[k], points[3 * i + k]);
+          upper[k] = std::fmax(upper[k], points[3 * i + k]);
+        }
+      }
+      real_t scale[3];
+      for (size_t k = 0; k < 3; k++)
+      {
+        scale[k] = upper[k] > lower[k] ? real_t(1023) / (upper[k] - lower[k]) : 0;
+      }
+
+      std::vector<std::pair<uint32_t, uint32_t>> codes(count);
+      for (size_t i = 0; i < count; i++)
+      {
+        uint32_t code = 0;
+        for (size_t k = 0; k < 3; k++)
+        {
+          real_t cell = (points[3 * i + k] - lower[k]) * scale[k];
+          code |= spreadBits(cell >= 0 ? uint32_t(cell) : 0) << k;
+        }
+        codes[i] = {code, uint32_t(i)};
+      }
+      std::sort(codes.begin(), codes.end());
+
+      std::vector<uint32_t> order(count);
+      for (size_t i = 0; i < count; i++)
+      {
+        order[i] = codes[i].second;
+      }
+      return order;
+    }
+
+    /**
+     * Runs @a query, which appends the neighbours of one point to a vector, for every point
+     * in Morton order across threads and gathers the results in query order.
+     */
+    template <typename Query>
+    NeighborLists queryBatch(const real_t *points, size_t count, Query query)
+    {
+      std::vector<uint32_t> order = mortonOrder(points, count);
+      std::vector<size_t> starts(count);
+      std::vector<size_t> counts(count);
+      std::vector<const Neighbor *> sources(count);
+      std::list<std::vector<Neighbor>> buffers;
+      std::mutex mutex;
+
+      parallelFor(0, count, batch_grain, [&](size_t first, size_t last) {
+        std::vector<Neighbor> found;
+        for (size_t p = first; p < last; p++)
+        {
+          size_t q = order[p];
+          starts[q] = found.size();
+          query(points + 3 * q, found);
+          counts[q] = found.size() - starts[q];
+        }
+        for (size_t p = first; p < last; p++)
+        {
+          sources[order[p]] = found.data() + starts[order[p]];
+        }
+        // Moving the vector keeps its storage, so the source pointers stay valid
+        std::lock_guard<std::mutex> lock(mutex);
+        buffers.push_back(std::move(found));
+      });
+
+      std::vector<size_t> offsets(count + 1, 0);
+      std::partial_sum(counts.begin(), counts.end(), offsets.begin() + 1);
+      std::vector<Neighbor> neighbors(offsets.back());
+      parallelFor(0, count, batch_grain, [&](size_t first, size_t last) {
+        for (size_t q = first; q < last; q++)
+        {
+          std::copy(sources[q], sources[q] + counts[q], neighbors.begin() + std::ptrdiff_t(offsets[q]));
+        }
+      });
+      return NeighborLists(std::move(offsets), std::move(neighbors));
+    }
+
+    void buildRange(const real_t *points, uint32_t *order, uint8_t *axes, size_t begin, size_t end)
+    {
+      if (end - begin <= KdTree::leaf_size)
+      {
+        return;
+      }
+
+      real_t lower[3] = {infinity, infinity, infinity};
+      real_t upper[3] = {-infinity, -infinity, -infinity};
+      for (size_t i = begin; i < end; i++)
+      {
+        for (size_t k = 0; k < 3; k++)
+        {
+          lower[k] = std::fmin(lower[k], points[3 * size_t(order[i]) + k]);
+          upper[k] = std::fmax(upper[k], points[3 * size_t(order[i]) + k]);
+        }
+      }
+      uint8_t axis = 0;
+      for (uint8_t k = 1; k < 3; k++)
+      {
+        if (upper[k] - lower[k] > upper[axis] - lower[axis])
+        {
+          axis = k;
+        }
+      }
+
+      size_t middle = begin + (end - begin) / 2;
+      std::nth_element(order + begin, order + middle, order + end, [points, axis](uint32_t a, uint32_t b) {
+        return points[3 * size_t(a) + axis] < points[3 * size_t(b) + axis];
+      });
+      axes[middle] = axis;
+
+      auto left = [=]() { buildRange(points, order, axes, begin, middle); };
+      auto right = [=]() { buildRange(points, order, axes, middle + 1, end); };
+      if (end - begin >= parallel_build_size)
+      {
+        parallelInvoke(left, right);
+      }
+      else
+      {
+        left();
+        right();
+      }
+    }
+
+    /**
+     * Walks the implicit tree around a query point, @a visit receives every candidate range
+     * and @a limit returns the squared distance beyond which points are no longer wanted.
+     */
+    struct KdSearch
+    {
+      const real_t *columns[3];
+      const uint32_t *indices;
+      const uint8_t *axes;
+      const real_t *point;
+
+      template <typename Offer, typename Limit>
+      void visit(size_t begin, size_t end, Offer &offer, Limit &limit) const
+      {
+        if (end - begin <= KdTree::leaf_size)
+        {
+          scan(begin, end, offer);
+          return;
+        }
+
+        size_t middle = begin + (end - begin) / 2;
+        uint8_t axis = axes[middle];
+        real_t delta = point[axis] - columns[axis][middle];
+        scan(middle, middle + 1, offer);
+        if (delta < 0)
+        {
+          visit(begin, middle, offer, limit);
+          if (delta * delta <= limit())
+          {
+            visit(middle + 1, end, offer, limit);
+          }
+        }
+        else
+        {
+          visit(middle + 1, end, offer, limit);
+          if (delta * delta <= limit())
+          {
+            visit(begin, middle, offer, limit);
+          }
+        }
+      }
+
+      template <typename Offer>
+      void scan(size_t begin, size_t end, Offer &offer) const
+      {
+        real_t distances[KdTree::leaf_size];
+        for (size_t i = begin; i < end; i++)
+        {
+          real_t dx = columns[0][i] - point[0];
+          real_t dy = columns[1][i] - point[1];
+          real_t dz = columns[2][i] - point[2];
+          distances[i - begin] = dx * dx + dy * dy + dz * dz;
+        }
+        for (size_t i = begin; i < end; i++)
+        {
+          offer(Neighbor{indices[i], distances[i - begin]});
+        }
+      }
+    };
+  }
+
+  void KdTree::build(const real_t *points, size_t count)
+  {
+    if (count > std::numeric_limits<uint32_t>::max())
+    {
+      throw std::invalid_argument("too many points");
+    }
+
+    std::vector<uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    axes_.assign(count, 0);
+    buildRange(points, order.data(), axes_.data(), 0, count);
+
+    indices_.assign(order.begin(), order.end());
+    points_.resize(count);
+    parallelFor(0, count, 4096, [&](size_t first, size_t last) {
+      for (size_t i = first; i < last; i++)
+      {
+        for (size_t k = 0; k < 3; k++)
+        {
+          points_.column(k)[i] = points[3 * size_t(order[i]) + k];
+        }
+      }
+    });
+  }
+
+  void KdTree::appendNearest(const real_t *point, size_t k, std::vector<Neighbor> &found) const
+  {
+    if (k == 0 || size() == 0)
+    {
+      return;
+    }
+    KdSearch search{{points_.x().data(), points_.y().data(), points_.z().data()}, indices_.data(), axes_.data(), point};
+    NearestHeap heap(found, k);
+    auto offer = [&heap](const Neighbor &neighbor) { heap.offer(neighbor); };
+    auto limit = [&heap]() { return heap.limit(); };
+    search.visit(0, size(), offer, limit);
+    heap.finish();
+  }
+
+  void KdTree::appendWithinRadius(const real_t *point, real_t radius, std::vector<Neighbor> &found) const
+  {
+    if (size() == 0 || radius < 0)
+    {
+      return;
+    }
+    KdSearch search{{points_.x().data(), points_.y().data(), points_.z().data()}, indices_.data(), axes_.data(), point};
+    size_t start = found.size();
+    real_t radiusSquared = radius * radius;
+    auto offer = [&](const Neighbor &neighbor) {
+      if (neighbor.distanceSquared <= radiusSquared)
+      {
+        found.push_back(neighbor);
+      }
+    };
+    auto limit = [radiusSquared]() { return radiusSquared; };
+    search.visit(0, size(), offer, limit);
+    std::sort(found.begin() + std::ptrdiff_t(start), found.end(), closer);
+  }
+
+  NeighborLists KdTree::nearest(const real_t *points, size_t count, size_t k) const
+  {
+    return queryBatch(points, count, [this, k](const real_t *point, std::vector<Neighbor> &found) {
+      appendNearest(point, k, found);
+    });
+  }
+
+  NeighborLists KdTree::withinRadius(const real_t *points, size_t count, real_t radius) const
+  {
+    return queryBatch(points, count, [this, radius](const real_t *point, std::vector<Neighbor> &found) {
+      appendWithinRadius(point, radius, found);
+    });
+  }
+
+  HashGrid::HashGrid(real_t cellSize) : cellSize_(cellSize), inverseCellSize_(1 / cellSize)
+  {
+    if (!(cellSize > 0))
+    {
+      throw std::invalid_argument("grid cell size must be positive");
+    }
+    rehash(16);
+  }
+
+  void HashGrid::cellOf(const real_t *point, int64_t *cell) const
+  {
+    for (size_t k = 0; k < 3; k++)
+    {
+      real_t coordinate = std::floor(point[k] * inverseCellSize_);
+      if (!(coordinate >= real_t(-max_cell) && coordinate < real_t(max_cell)))
+      {
+        throw std::out_of_range("point is outside the grid range");
+      }
+      cell[k] = int64_t(coordinate);
+    }
+  }
+
+  namespace
+  {
+    uint64_t packCell(int64_t x, int64_t y, int64_t z, int64_t bias)
+    {
+      return (uint64_t(x + bias) << 42) | (uint64_t(y + bias) << 21) | uint64_t(z + bias);
+    }
+
+    size_t slotOf(uint64_t key, size_t slots)
+    {
+      key *= 0x9e3779b97f4a7c15ull;
+      return size_t(key ^ (key >> 32)) & (slots - 1);
+    }
+  }
+
+  uint64_t HashGrid::key(const real_t *point) const
+  {
+    int64_t cell[3];
+    cellOf(point, cell);
+    return packCell(cell[0], cell[1], cell[2], max_cell);
+  }
+
+  size_t HashGrid::findSlot(uint64_t key) const
+  {
+    for (size_t slot = slotOf(key, slots_.size());; slot = (slot + 1) & (slots_.size() - 1))
+    {
+      if (slots_[slot].key == key || slots_[slot].key == empty_key)
+      {
+        return slot;
+      }
+    }
+  }
+
+  const std::vector<HashGrid::Entry> *HashGrid::find(uint64_t key) const
+  {
+    const Slot &slot = slots_[findSlot(key)];
+    return slot.key == key ? &cells_[slot.cell] : nullptr;
+  }
+
+  std::vector<HashGrid::Entry> &HashGrid::cell(uint64_t key)
+  {
+    size_t slot = findSlot(key);
+    if (slots_[slot].key == key)
+    {
+      return cells_[slots_[slot].cell];
+    }
+
+    // Keep the table at most half full so probe sequences stay short
+    if (2 * (cells_.size() + 1) > slots_.size())
+    {
+      rehash(2 * slots_.size());
+      return cell(key);
+    }
+    slots_[slot] = Slot{key, uint32_t(cells_.size())};
+    cells_.emplace_back();
+    cellKeys_.push_back(key);
+    trackBounds(key, true);
+    return cells_.back();
+  }
+
+  void HashGrid::eraseCell(size_t slot)
+  {
+    uint64_t key = slots_[slot].key;
+    uint32_t index = slots_[slot].cell;
+
+    // The last cell takes the place of the erased one so cells stay contiguous
+    uint32_t last = uint32_t(cells_.size() - 1);
+    if (index != last)
+    {
+      cells_[index] = std::move(cells_[last]);
+      cellKeys_[index] = cellKeys_[last];
+      slots_[findSlot(cellKeys_[index])].cell = index;
+    }
+    cells_.pop_back();
+    cellKeys_.pop_back();
+
+    // Backward shift deletion: later slots of the probe run move into the hole unless that
+    // would put them before their home slot, so no tombstones are needed
+    size_t mask = slots_.size() - 1;
+    size_t hole = slot;
+    for (size_t next = (hole + 1) & mask; slots_[next].key != empty_key; next = (next + 1) & mask)
+    {
+      size_t home = slotOf(slots_[next].key, slots_.size());
+      if (((next - home) & mask) >= ((next - hole) & mask))
+      {
+        slots_[hole] = slots_[next];
+        hole = next;
+      }
+    }
+    slots_[hole] = Slot{empty_key, 0};
+    trackBounds(key, false);
+  }
+
+  void HashGrid::trackBounds(uint64_t key, bool occupied)
+  {
+    int64_t bias = max_cell;
+    int64_t coordinates[3] = {int64_t(key >> 42) - bias, int64_t((key >> 21) & 0x1fffff) - bias,
+                              int64_t(key & 0x1fffff) - bias};
+    for (size_t k = 0; k < 3; k++)
+    {
+      std::map<int64_t, uint32_t> &counts = occupied_[k];
+      if (occupied)
+      {
+        counts[coordinates[k]]++;
+      }
+      else if (--counts[coordinates[k]] == 0)
+      {
+        counts.erase(coordinates[k]);
+      }
+      lower_[k] = counts.empty() ? max_cell : counts.begin()->first;
+      upper_[k] = counts.empty() ? -max_cell : counts.rbegin()->first;
+    }
+  }
+
+  void HashGrid::rehash(size_t slots)
+  {
+    std::vector<Slot> old(slots, Slot{empty_key, 0});
+    std::swap(old, slots_);
+    for (const Slot &entry : old)
+    {
+      if (entry.key != empty_key)
+      {
+        size_t slot = slotOf(entry.key, slots_.size());
+        while (slots_[slot].key != empty_key)
+        {
+          slot = (slot + 1) & (slots_.size() - 1);
+        }
+        slots_[slot] = entry;
+      }
+    }
+  }
+
+  void HashGrid::checkId(uint32_t id) const
+  {
+    if (!contains(id))
+    {
+      throw std::out_of_range("no point has this id");
+    }
+  }
+
+  void HashGrid::build(const real_t *points, size_t count)
+  {
+    if (count > std::numeric_limits<uint32_t>::max())
+    {
+      throw std::invalid_argument("too many points");
+    }
+
+    std::vector<std::pair<uint64_t, uint32_t>> keys(count);
+    parallelFor(0, count, 4096, [&](size_t first, size_t last) {
+      for (size_t i = first; i < last; i++)
+      {
+        uint64_t key = empty_key;
+        try
+        {
+          key = this->key(points + 3 * i);
+        }
+        catch (const std::out_of_range &)
+        {
+        }
+        keys[i] = {key, uint32_t(i)};
+      }
+    });
+    for (const auto &entry : keys)
+    {
+      if (entry.first == empty_key)
+      {
+        throw std::out_of_range("point is outside the grid range");
+      }
+    }
+    std::sort(keys.begin(), keys.end());
+
+    positions_.resize(count);
+    alive_.assign(count, 1);
+    for (size_t first = 0; first < count;)
+    {
+      size_t last = first;
+      while (last < count && keys[last].first == keys[first].first)
+      {
+        last++;
+      }
+      std::vector<Entry> &entries = cell(keys[first].first);
+      entries.reserve(last - first);
+      for (size_t i = first; i < last; i++)
+      {
+        uint32_t id = keys[i].second;
+        const real_t *point = points + 3 * size_t(id);
+        positions_[id] = {point[0], point[1], point[2]};
+        entries.push_back(Entry{{point[0], point[1], point[2]}, id});
+      }
+      first = last;
+    }
+    size_ = count;
+  }
+
+  uint32_t HashGrid::insert(const real_t *point)
+  {
+    std::vector<Entry> &entries = cell(key(point));
+    uint32_t id;
+    if (freeIds_.empty())
+    {
+      id = uint32_t(positions_.size());
+      positions_.emplace_back();
+      alive_.push_back(0);
+    }
+    else
+    {
+      id = freeIds_.back();
+      freeIds_.pop_back();
+    }
+    positions_[id] = {point[0], point[1], point[2]};
+    alive_[id] = 1;
+    entries.push_back(Entry{{point[0], point[1], point[2]}, id});
+    size_++;
+    return id;
+  }
+
+  void HashGrid::removeEntry(uint64_t key, uint32_t id)
+  {
+    size_t slot = findSlot(key);
+    std::vector<Entry> &entries = cells_[slots_[slot].cell];
+    auto entry = std::find_if(entries.begin(), entries.end(), [id](const Entry &e) { return e.id == id; });
+    *entry = entries.back();
+    entries.pop_back();
+    if (entries.empty())
+    {
+      eraseCell(slot);
+    }
+  }
+
+  void HashGrid::remove(uint32_t id)
+  {
+    checkId(id);
+    removeEntry(key(positions_[id].data()), id);
+    alive_[id] = 0;
+    freeIds_.push_back(id);
+    size_--;
+  }
+
+  void HashGrid::move(uint32_t id, const real_t *point)
+  {
+    checkId(id);
+    uint64_t to = key(point);
+    uint64_t from = key(positions_[id].data());
+    positions_[id] = {point[0], point[1], point[2]};
+    if (to == from)
+    {
+      for (Entry &entry : cells_[slots_[findSlot(from)].cell])
+      {
+        if (entry.id == id)
+        {
+          entry = Entry{{point[0], point[1], point[2]}, id};
+        }
+      }
+      return;
+    }
+    removeEntry(from, id);
+    cell(to).push_back(Entry{{point[0], point[1], point[2]}, id});
+  }
+
+  Vec3 HashGrid::position(uint32_t id) const
+  {
+    checkId(id);
+    return Vec3{positions_[id][0], positions_[id][1], positions_[id][2]};
+  }
+
+  void HashGrid::appendNearest(const real_t *point, size_t k, std::vector<Neighbor> &found) const
+  {
+    if (k == 0 || size_ == 0)
+    {
+      return;
+    }
+
+    int64_t center[3];
+    int64_t rings = 0;
+    for (size_t a = 0; a < 3; a++)
+    {
+      real_t coordinate = std::floor(point[a] * inverseCellSize_);
+      center[a] = int64_t(std::clamp(coordinate, real_t(lower_[a]), real_t(upper_[a])));
+      rings = std::max({rings, center[a] - lower_[a], upper_[a] - center[a]});
+    }
+
+    NearestHeap heap(found, k);
+    auto scan = [&](int64_t x, int64_t y, int64_t z) {
+      const std::vector<Entry> *entries = find(packCell(x, y, z, max_cell));
+      if (!entries)
+      {
+        return;
+      }
+      for (const Entry &entry : *entries)
+      {
+        real_t dx = entry.position[0] - point[0];
+        real_t dy = entry.position[1] - point[1];
+        real_t dz = entry.position[2] - point[2];
+        heap.offer(Neighbor{entry.id, dx * dx + dy * dy + dz * dz});
+      }
+    };
+
+    // Visits the shells of cells at growing Chebyshev distance from the query cell until
+    // no unvisited cell can hold a point closer than the k-th neighbour found so far
+    for (int64_t ring = 0; ring <= rings; ring++)
+    {
+      for (int64_t x = std::max(center[0] - ring, lower_[0]); x <= std::min(center[0] + ring, upper_[0]); x++)
+      {
+        for (int64_t y = std::max(center[1] - ring, lower_[1]); y <= std::min(center[1] + ring, upper_[1]); y++)
+        {
+          if (std::abs(x - center[0]) == ring || std::abs(y - center[1]) == ring)
+          {
+            for (int64_t z = std::max(center[2] - ring, lower_[2]); z <= std::min(center[2] + ring, upper_[2]); z++)
+            {
+              scan(x, y, z);
+            }
+            continue;
+          }
+          for (int64_t z : {center[2] - ring, center[2] + ring})
+          {
+            if (z >= lower_[2] && z <= upper_[2])
+            {
+              scan(x, y, z);
+            }
+          }
+        }
+      }
+
+      real_t reach = infinity;
+      for (size_t a = 0; a < 3; a++)
+      {
+        reach = std::fmin(reach, point[a] - real_t(center[a] - ring) * cellSize_);
+        reach = std::fmin(reach, real_t(center[a] + ring + 1) * cellSize_ - point[a]);
+      }
+      if (reach > 0 && heap.limit() < reach * reach)
+      {
+        break;
+      }
+    }
+    heap.finish();
+  }
+
+  void HashGrid::appendWithinRadius(const real_t *point, real_t radius, std::vector<Neighbor> &found) const
+  {
+    if (size_ == 0 || radius < 0)
+    {
+      return;
+    }
+
+    int64_t lower[3];
+    int64_t upper[3];
+    for (size_t a = 0; a < 3; a++)
+    {
+      real_t from = std::floor((point[a] - radius) * inverseCellSize_);
+      real_t to = std::floor((point[a] + radius) * inverseCellSize_);
+      lower[a] = int64_t(std::fmax(from, real_t(lower_[a])));
+      upper[a] = int64_t(std::fmin(to, real_t(upper_[a])));
+    }
+
+    size_t start = found.size();
+    real_t radiusSquared = radius * radius;
+    for (int64_t x = lower[0]; x <= upper[0]; x++)
+    {
+      for (int64_t y = lower[1]; y <= upper[1]; y++)
+      {
+        for (int64_t z = lower[2]; z <= upper[2]; z++)
+        {
+          const std::vector<Entry> *entries = find(packCell(x, y, z, max_cell));
+          if (!entries)
+          {
+            continue;
+          }
+          for (const Entry &entry : *entries)
+          {
+            real_t dx = entry.position[0] - point[0];
+            real_t dy = entry.position[1] - point[1];
+            real_t dz = entry.position[2] - point[2];
+            real_t distanceSquared = dx * dx + dy * dy + dz * dz;
+            if (distanceSquared <= radiusSquared)
+            {
+              found.push_back(Neighbor{entry.id, distanceSquared});
+            }
+          }
+        }
+      }
+    }
+    std::sort(found.begin() + std::ptrdiff_t(start), found.end(), closer);
+  }
+
+  NeighborLists HashGrid::nearest(const real_t *points, size_t count, size_t k) const
+  {
+    return queryBatch(points, count, [this, k](const real_t *point, std::vector<Neighbor> &found) {
+      appendNearest(point, k, found);
+    });
+  }
+
+  NeighborLists HashGrid::withinRadius(const real_t *points, size_t count, real_t radius) const
+  {
+    return queryBatch(points, count, [this, radius](const real_t *point, std::vector<Neighbor> &found) {
+      appendWithinRadius(point, radius, found);
+    });
+  }
+}
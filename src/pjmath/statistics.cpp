@@ -0,0 +1,160 @@
+#include "pjmath/statistics.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "pjmath/parallel.hpp"
+
+namespace pjmath
+{
+  namespace
+  {
+    // Points per block of the blocked update, small enough for the block to stay in L1
+    constexpr size_t statistics_block = 256;
+
+    // Smallest number of points worth reducing on a separate thread
+    constexpr size_t statistics_grain = 1 << 14;
+
+    template <typename Chunk>
+    PointStatistics parallelStatistics(size_t count, const Chunk &chunkStatistics)
+    {
+      std::mutex mutex;
+      std::vector<std::pair<size_t, PointStatistics>> partials;
+      parallelFor(0, count, statistics_grain, [&](size_t first, size_t last) {
+        PointStatistics partial = chunkStatistics(first, last);
+        std::lock_guard<std::mutex> lock(mutex);
+        partials.emplace_back(first, partial);
+      });
+
+      // Merge in stream order so the rounding does not depend on thread scheduling
+      std::sort(partials.begin(), partials.end(),
+                [](const auto &a, const auto &b) { return a.first < b.first; });
+      PointStatistics statistics;
+      for (const auto &partial : partials)
+      {
+        statistics.merge(partial.second);
+      }
+      return statistics;
+    }
+  }
+
+  template <typename Point>
+  void PointStatistics::addBlocks(size_t count, Point point)
+  {
+    for (size_t first = 0; first < count; first += statistics_block)
+    {
+      size_t n = std::min(statistics_block, count - first);
+      PointStatistics block;
+      real_t sum[3] = {0, 0, 0};
+      for (size_t i = first; i < first + n; i++)
+      {
+        Vec3 p = point(i);
+        sum[0] += p.x();
+        sum[1] += p.y();
+        sum[2] += p.z();
+        block.bounds_.expand(p);
+      }
+      real_t inverse = real_t(1) / real_t(n);
+      block.count_ = n;
+      block.mean_ = Vec3{sum[0] * inverse, sum[1] * inverse, sum[2] * inverse};
+      for (size_t i = first; i < first + n; i++)
+      {
+        Vec3 p = point(i);
+        real_t d[3] = {p.x() - block.mean_.x(), p.y() - block.mean_.y(), p.z() - block.mean_.z()};
+        block.accumulate(d, 1);
+      }
+      merge(block);
+    }
+  }
+
+  void PointStatistics::add(std::span<const Vec3> points)
+  {
+    addBlocks(points.size(), [points](size_t i) { return points[i]; });
+  }
+
+  void PointStatistics::add(const SoAVec3Array &points)
+  {
+    add(points.x(), points.y(), points.z());
+  }
+
+  void PointStatistics::add(std::span<const real_t> x, std::span<const real_t> y, std::span<const real_t> z)
+  {
+    if (y.size() != x.size() || z.size() != x.size())
+    {
+      throw std::invalid_argument("coordinate columns must have the same size");
+    }
+    addBlocks(x.size(), [x, y, z](size_t i) { return Vec3{x[i], y[i], z[i]}; });
+  }
+
+  void PointStatistics::merge(const PointStatistics &other)
+  {
+    if (other.count_ == 0)
+    {
+      return;
+    }
+    if (count_ == 0)
+    {
+      *this = other;
+      return;
+    }
+
+    size_t count = count_ + other.count_;
+    real_t d[3] = {other.mean_.x() - mean_.x(), other.mean_.y() - mean_.y(), other.mean_.z() - mean_.z()};
+    real_t fraction = real_t(other.count_) / real_t(count);
+    mean_.x() += d[0] * fraction;
+    mean_.y() += d[1] * fraction;
+    mean_.z() += d[2] * fraction;
+    for (size_t k = 0; k < comoment_.size(); k++)
+    {
+      comoment_[k] += other.comoment_[k];
+    }
+    accumulate(d, real_t(count_) * fraction);
+    count_ = count;
+    bounds_.expand(other.bounds_);
+  }
+
+  Mat3 PointStatistics::comoment(real_t scale) const
+  {
+    real_t xx = comoment_[0] * scale;
+    real_t yy = comoment_[1] * scale;
+    real_t zz = comoment_[2] * scale;
+    real_t xy = comoment_[3] * scale;
+    real_t xz = comoment_[4] * scale;
+    real_t yz = comoment_[5] * scale;
+    return Mat3{xx, xy, xz, xy, yy, yz, xz, yz, zz};
+  }
+
+  Mat3 PointStatistics::covariance() const
+  {
+    return count_ > 0 ? comoment(real_t(1) / real_t(count_)) : Mat3{};
+  }
+
+  Mat3 PointStatistics::sampleCovariance() const
+  {
+    return count_ > 1 ? comoment(real_t(1) / real_t(count_ - 1)) : Mat3{};
+  }
+
+  PointStatistics pointStatistics(std::span<const Vec3> points)
+  {
+    return parallelStatistics(points.size(), [points](size_t first, size_t last) {
+      PointStatistics statistics;
+      statistics.add(points.subspan(first, last - first));
+      return statistics;
+    });
+  }
+
+  PointStatistics pointStatistics(const SoAVec3Array &points)
+  {
+    std::span<const real_t> x = points.x();
+    std::span<const real_t> y = points.y();
+    std::span<const real_t> z = points.z();
+    return parallelStatistics(points.size(), [x, y, z](size_t first, size_t last) {
+      PointStatistics statistics;
+      statistics.add(x.subspan(first, last - first), y.subspan(first, last - first), z.subspan(first, last - first));
+      return statistics;
+    });
+  }
+}
@@ -0,0 +1,346 @@
+#include "pjmath/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pjmath
+{
+  namespace
+  {
+    // Failed searches for work before a worker goes to sleep
+    constexpr size_t idle_spins = 64;
+
+    /**
+     * Shared by every task of one loop.
+     */
+    struct Loop
+    {
+      Loop(RangeFunction loopBody, size_t loopGrain) : body(loopBody), grain(loopGrain)
+      {
+      }
+
+      RangeFunction body;
+      size_t grain;
+      std::atomic<bool> failed{false};
+      std::mutex mutex{};
+      std::exception_ptr error{};
+    };
+
+    /**
+     * A range of a loop queued for another thread to pick up. Tasks live on the stack of the
+     * thread which queued them, which waits for them before returning.
+     */
+    struct Task
+    {
+      Loop *loop = nullptr;
+      size_t first = 0;
+      size_t last = 0;
+      std::atomic<bool> done{false};
+    };
+
+    /**
+     * Task deque, the owner pushes and pops at the back and thieves take from the front.
+     */
+    struct Deque
+    {
+      std::mutex mutex{};
+      std::deque<Task *> tasks{};
+
+      void push(Task *task)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(task);
+      }
+
+      Task *popBack()
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.empty())
+        {
+          return nullptr;
+        }
+        Task *task = tasks.back();
+        tasks.pop_back();
+        return task;
+      }
+
+      Task *steal()
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.empty())
+        {
+          return nullptr;
+        }
+        Task *task = tasks.front();
+        tasks.pop_front();
+        return task;
+      }
+
+      /**
+       * Removes @a task if no thief took it yet, it is almost always at the back.
+       */
+      bool remove(Task *task)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = tasks.rbegin(); it != tasks.rend(); ++it)
+        {
+          if (*it == task)
+          {
+            tasks.erase(std::next(it).base());
+            return true;
+          }
+        }
+        return false;
+      }
+    };
+  }
+
+  struct ThreadPool::State
+  {
+    std::vector<Deque> deques;
+    Deque injected{}; ///< Tasks queued by threads which are not workers of this pool
+    std::vector<std::thread> threads{};
+    std::atomic<bool> stopping{false};
+    std::atomic<uint32_t> epoch{0};
+    std::atomic<size_t> sleeping{0};
+
+    explicit State(size_t workers) : deques(workers)
+    {
+    }
+
+    void run(size_t worker);
+    void runRange(Loop &loop, size_t first, size_t last, Deque &own);
+    void execute(Task &task, Deque &own);
+    void waitFor(Task &task, Deque &own);
+    Task *findWork(Deque &own, uint32_t &seed);
+    void push(Deque &own, Task *task);
+  };
+
+  namespace
+  {
+    /**
+     * Pool and deque of the calling thread if it is a worker.
+     */
+    thread_local const void *current_pool = nullptr;
+    thread_local Deque *current_deque = nullptr;
+
+    std::atomic<Executor *> installed_executor{nullptr};
+
+    uint32_t nextRandom(uint32_t &seed)
+    {
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+      return seed;
+    }
+  }
+
+  void ThreadPool::State::push(Deque &own, Task *task)
+  {
+    own.push(task);
+    // Pairs with the increment of sleeping in run, so a worker about to sleep either sees the
+    // task or is woken
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed) > 0)
+    {
+      epoch.fetch_add(1, std::memory_order_release);
+      epoch.notify_one();
+    }
+  }
+
+  Task *ThreadPool::State::findWork(Deque &own, uint32_t &seed)
+  {
+    if (Task *task = own.popBack())
+    {
+      return task;
+    }
+    size_t count = deques.size();
+    size_t start = count > 0 ? nextRandom(seed) % count : 0;
+    for (size_t i = 0; i < count; i++)
+    {
+      Deque &victim = deques[(start + i) % count];
+      if (&victim != &own)
+      {
+        if (Task *task = victim.steal())
+        {
+          return task;
+        }
+      }
+    }
+    return &own != &injected ? injected.steal() : nullptr;
+  }
+
+  void ThreadPool::State::runRange(Loop &loop, size_t first, size_t last, Deque &own)
+  {
+    if (last - first >= 2 * loop.grain)
+    {
+      size_t middle = first + (last - first) / 2;
+      Task right;
+      right.loop = &loop;
+      right.first = middle;
+      right.last = last;
+      push(own, &right);
+      runRange(loop, first, middle, own);
+      if (own.remove(&right))
+      {
+        runRange(loop, middle, last, own);
+      }
+      else
+      {
+        waitFor(right, own);
+      }
+      return;
+    }
+
+    if (loop.failed.load(std::memory_order_relaxed))
+    {
+      return;
+    }
+    try
+    {
+      loop.body(first, last);
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> lock(loop.mutex);
+      if (!loop.error)
+      {
+        loop.error = std::current_exception();
+      }
+      loop.failed.store(true, std::memory_order_relaxed);
+    }
+  }
+
+  void ThreadPool::State::execute(Task &task, Deque &own)
+  {
+    runRange(*task.loop, task.first, task.last, own);
+    task.done.store(true, std::memory_order_release);
+  }
+
+  void ThreadPool::State::waitFor(Task &task, Deque &own)
+  {
+    // Run other tasks while the thief works on this one, they are usually parts of the same loop
+    uint32_t seed = uint32_t(reinterpret_cast<uintptr_t>(&task) >> 4) | 1;
+    while (!task.done.load(std::memory_order_acquire))
+    {
+      if (Task *other = findWork(own, seed))
+      {
+        execute(*other, own);
+      }
+      else
+      {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  void ThreadPool::State::run(size_t worker)
+  {
+    Deque &own = deques[worker];
+    current_pool = this;
+    current_deque = &own;
+    uint32_t seed = uint32_t(worker) * 2654435761u + 1;
+    size_t spins = 0;
+
+    while (!stopping.load(std::memory_order_acquire))
+    {
+      if (Task *task = findWork(own, seed))
+      {
+        execute(*task, own);
+        spins = 0;
+        continue;
+      }
+      if (++spins < idle_spins)
+      {
+        std::this_thread::yield();
+        continue;
+      }
+
+      uint32_t observed = epoch.load(std::memory_order_acquire);
+      sleeping.fetch_add(1, std::memory_order_seq_cst);
+      if (Task *task = findWork(own, seed))
+      {
+        sleeping.fetch_sub(1, std::memory_order_relaxed);
+        execute(*task, own);
+        spins = 0;
+        continue;
+      }
+      if (!stopping.load(std::memory_order_acquire))
+      {
+        epoch.wait(observed, std::memory_order_acquire);
+      }
+      sleeping.fetch_sub(1, std::memory_order_relaxed);
+      spins = 0;
+    }
+  }
+
+  ThreadPool::ThreadPool(size_t workers)
+      : state_(std::make_unique<State>(workers > 0 ? workers
+                                                   : std::max<size_t>(std::thread::hardware_concurrency(), 1) - 1))
+  {
+    state_->threads.reserve(state_->deques.size());
+    for (size_t i = 0; i < state_->deques.size(); i++)
+    {
+      state_->threads.emplace_back([state = state_.get(), i]() { state->run(i); });
+    }
+  }
+
+  ThreadPool::~ThreadPool()
+  {
+    state_->stopping.store(true, std::memory_order_release);
+    state_->epoch.fetch_add(1, std::memory_order_release);
+    state_->epoch.notify_all();
+    for (std::thread &thread : state_->threads)
+    {
+      thread.join();
+    }
+  }
+
+  void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain, RangeFunction body)
+  {
+    Loop loop(body, std::max<size_t>(grain, 1));
+    if (state_->deques.empty())
+    {
+      body(begin, end);
+      return;
+    }
+
+    // Workers of this pool split onto their own deque, other threads onto the shared one
+    Deque &own = current_pool == state_.get() ? *current_deque : state_->injected;
+    state_->runRange(loop, begin, end, own);
+    if (loop.error)
+    {
+      std::rethrow_exception(loop.error);
+    }
+  }
+
+  size_t ThreadPool::concurrency() const
+  {
+    return state_->deques.size() + 1;
+  }
+
+  ThreadPool &ThreadPool::global()
+  {
+    // Leaked so loops started during static destruction still have workers
+    static ThreadPool *pool = new ThreadPool();
+    return *pool;
+  }
+
+  void setExecutor(Executor *executor)
+  {
+    installed_executor.store(executor, std::memory_order_release);
+  }
+
+  Executor &currentExecutor()
+  {
+    Executor *executor = installed_executor.load(std::memory_order_acquire);
+    return executor != nullptr ? *executor : ThreadPool::global();
+  }
+}
@@ -0,0 +1,107 @@
+#include "pjmath/transform.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+#include "pjmath/parallel.hpp"
+
+namespace pjmath
+{
+  namespace
+  {
+    // Smallest number of transforms worth building on a separate thread
+    constexpr size_t transform_grain = 4096;
+
+    void checkSize(size_t expected, size_t actual)
+    {
+      if (expected != actual)
+      {
+        throw std::invalid_argument("batch sizes do not match");
+      }
+    }
+  }
+
+  TRS decomposeTRS(const Mat4 &m)
+  {
+    TRS parts{Vec3{m[3], m[7], m[11]}, Mat3{}, Vec3{}};
+    for (size_t column = 0; column < 3; column++)
+    {
+      real_t x = m[column], y = m[4 + column], z = m[8 + column];
+      parts.scale[column] = std::sqrt(x * x + y * y + z * z);
+    }
+
+    real_t det = m[0] * (m[5] * m[10] - m[6] * m[9]) - m[1] * (m[4] * m[10] - m[6] * m[8]) +
+                 m[2] * (m[4] * m[9] - m[5] * m[8]);
+    if (det < 0)
+    {
+      parts.scale[0] = -parts.scale[0];
+    }
+
+    for (size_t column = 0; column < 3; column++)
+    {
+      real_t inverse = 1 / parts.scale[column];
+      for (size_t row = 0; row < 3; row++)
+      {
+        parts.rotation.at(row, column) = m.at(row, column) * inverse;
+      }
+    }
+    return parts;
+  }
+
+  Vec4 toQuaternion(const Mat3 &r)
+  {
+    // Shepperd's method, divide by the largest of the four candidates for accuracy
+    real_t trace = r[0] + r[4] + r[8];
+    Vec4 q;
+    if (trace > 0)
+    {
+      real_t s = 2 * std::sqrt(1 + trace);
+      q = Vec4{(r[7] - r[5]) / s, (r[2] - r[6]) / s, (r[3] - r[1]) / s, s / 4};
+    }
+    else if (r[0] > r[4] && r[0] > r[8])
+    {
+      real_t s = 2 * std::sqrt(1 + r[0] - r[4] - r[8]);
+      q = Vec4{s / 4, (r[1] + r[3]) / s, (r[2] + r[6]) / s, (r[7] - r[5]) / s};
+    }
+    else if (r[4] > r[8])
+    {
+      real_t s = 2 * std::sqrt(1 + r[4] - r[0] - r[8]);
+      q = Vec4{(r[1] + r[3]) / s, s / 4, (r[5] + r[7]) / s, (r[2] - r[6]) / s};
+    }
+    else
+    {
+      real_t s = 2 * std::sqrt(1 + r[8] - r[0] - r[4]);
+      q = Vec4{(r[2] + r[6]) / s, (r[5] + r[7]) / s, s / 4, (r[3] - r[1]) / s};
+    }
+    if (q.w() < 0)
+    {
+      q *= -1;
+    }
+    return q;
+  }
+
+  void fromTRS(std::span<const Vec3> translations, std::span<const Vec4> rotations, std::span<const Vec3> scales,
+               std::span<Mat4> out)
+  {
+    checkSize(out.size(), translations.size());
+    checkSize(out.size(), rotations.size());
+    checkSize(out.size(), scales.size());
+    parallelFor(0, out.size(), transform_grain, [&](size_t first, size_t last) {
+      for (size_t i = first; i < last; i++)
+      {
+        out[i] = Mat4::fromTRS(translations[i], rotations[i], scales[i]);
+      }
+    });
+  }
+
+  void decomposeTRS(std::span<const Mat4> transforms, std::span<TRS> out)
+  {
+    checkSize(out.size(), transforms.size());
+    parallelFor(0, out.size(), transform_grain, [&](size_t first, size_t last) {
+      for (size_t i = first; i < last; i++)
+      {
+        out[i] = decomposeTRS(transforms[i]);
+      }
+    });
+  }
+}
@@ -0,0 +1,138 @@
+#include <pjmath/binary.hpp>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+using namespace pjmath;
+
+namespace
+{
+  std::string temporaryPath(const char *name)
+  {
+    return testing::TempDir() + name;
+  }
+
+  void corrupt(const std::string &path, size_t offset, unsigned char value)
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(std::streamoff(offset));
+    file.put(char(value));
+  }
+}
+
+TEST(PJ_BINARY_TEST, round_trip)
+{
+  std::string path = temporaryPath("pjmath_round_trip.bin");
+  std::vector<Mat4> transforms;
+  std::vector<Vec3> points;
+  std::vector<Vector3> normals;
+  for (size_t i = 0; i < 1000; i++)
+  {
+    Mat4 m = Mat4::identity();
+    m[3] = real_t(i);
+    transforms.push_back(m);
+    points.push_back(Vec3{real_t(i), -real_t(i), 0.5});
+    normals.push_back(Vector3{0, 1, real_t(i)});
+  }
+
+  {
+    BinaryWriter writer(path);
+    writer.beginArray<Vec3>("points");
+    // Streamed in uneven chunks
+    writer.write(std::span<const Vec3>(points).subspan(0, 7));
+    writer.write(std::span<const Vec3>(points).subspan(7));
+    writer.beginArray<Mat4>("transforms");
+    writer.write(std::span<const Mat4>(transforms));
+    writer.beginArray<Vector3>("normals");
+    writer.write(std::span<const Vector3>(normals));
+    writer.beginArray<real_t>("empty");
+    writer.close();
+  }
+
+  MappedBinaryFile file(path);
+  ASSERT_EQ(file.arrays().size(), 4u);
+  EXPECT_EQ(file.arrays()[0].name, "points");
+  EXPECT_EQ(file.arrays()[1].kind, BinaryElement::mat4);
+  EXPECT_EQ(file.arrays()[2].count, 1000u);
+
+  std::span<const Vec3> readPoints = file.array<Vec3>("points");
+  std::span<const Mat4> readTransforms = file.array<Mat4>("transforms");
+  std::span<const Vector3> readNormals = file.array<Vector3>("normals");
+  EXPECT_TRUE(file.array<real_t>("empty").empty());
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(readPoints.data()) % binary_alignment, 0u);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(readTransforms.data()) % binary_alignment, 0u);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(readNormals.data()) % binary_alignment, 0u);
+  ASSERT_EQ(readPoints.size(), points.size());
+  ASSERT_EQ(readTransforms.size(), transforms.size());
+  ASSERT_EQ(readNormals.size(), normals.size());
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    EXPECT_EQ(readPoints[i], points[i]);
+    EXPECT_EQ(readTransforms[i], transforms[i]);
+    EXPECT_EQ(readNormals[i], normals[i]);
+  }
+
+  EXPECT_THROW(file.array<Vector3>("points"), std::runtime_error);
+  EXPECT_THROW(file.array<Vec3>("missing"), std::runtime_error);
+
+  MappedBinaryFile moved = std::move(file);
+  EXPECT_EQ(moved.array<Vec3>("points").data(), readPoints.data());
+}
+
+TEST(PJ_BINARY_TEST, writer_errors)
+{
+  BinaryWriter writer(temporaryPath("pjmath_writer_errors.bin"));
+  std::vector<Vec3> points(3);
+  EXPECT_THROW(writer.write(std::span<const Vec3>(points)), std::logic_error);
+  writer.beginArray<Vec3>("points");
+  EXPECT_THROW(writer.beginArray<Vec3>("points"), std::invalid_argument);
+  EXPECT_THROW(writer.beginArray<Vec3>(""), std::invalid_argument);
+  EXPECT_THROW(writer.beginArray<Vec3>(std::string(binary_max_name + 1, 'a')), std::invalid_argument);
+  EXPECT_THROW(writer.write(std::span<const Vector3>()), std::logic_error);
+  writer.close();
+  EXPECT_THROW(writer.beginArray<Vec3>("more"), std::logic_error);
+
+  EXPECT_THROW(BinaryWriter("/nonexistent/directory/file.bin"), std::runtime_error);
+}
+
+TEST(PJ_BINARY_TEST, invalid_files)
+{
+  EXPECT_THROW(MappedBinaryFile(temporaryPath("pjmath_missing.bin")), std::runtime_error);
+
+  std::string path = temporaryPath("pjmath_invalid.bin");
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << "short";
+  }
+  EXPECT_THROW(MappedBinaryFile{path}, std::runtime_error);
+
+  std::vector<Vec3> points(10);
+  auto write = [&]() {
+    BinaryWriter writer(path);
+    writer.beginArray<Vec3>("points");
+    writer.write(std::span<const Vec3>(points));
+    writer.close();
+  };
+
+  write();
+  EXPECT_NO_THROW(MappedBinaryFile{path});
+  corrupt(path, 0, 'X');
+  EXPECT_THROW(MappedBinaryFile{path}, std::runtime_error);
+
+  write();
+  corrupt(path, 8, 99);
+  EXPECT_THROW(MappedBinaryFile{path}, std::runtime_error);
+
+  // Element count past the end of the data, the table follows the 240 bytes of points padded to 256
+  write();
+  corrupt(path, 64 + 256 + 40 + 8 + 1, 1);
+  EXPECT_THROW(MappedBinaryFile{path}, std::runtime_error);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
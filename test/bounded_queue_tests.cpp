@@ -0,0 +1,78 @@
+#include <pjmath/bounded_queue.hpp>
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using namespace pjmath;
+
+TEST(PJ_BOUNDED_QUEUE_TEST, order_and_close)
+{
+  BoundedQueue<int> queue(2);
+  EXPECT_TRUE(queue.push(1));
+  EXPECT_TRUE(queue.push(2));
+  EXPECT_EQ(queue.pop(), 1);
+  queue.close();
+  EXPECT_FALSE(queue.push(3));
+  EXPECT_EQ(queue.pop(), 2);
+  EXPECT_EQ(queue.pop(), std::nullopt);
+}
+
+TEST(PJ_BOUNDED_QUEUE_TEST, pipeline)
+{
+  BoundedQueue<std::vector<int>> first(1);
+  BoundedQueue<int> second(3);
+  constexpr int count = 10000;
+
+  std::thread producer([&first] {
+    for (int i = 0; i < count; i += 10)
+    {
+      std::vector<int> chunk;
+      for (int j = i; j < i + 10; j++)
+      {
+        chunk.push_back(j);
+      }
+      first.push(std::move(chunk));
+    }
+    first.close();
+  });
+  std::thread stage([&first, &second] {
+    while (std::optional<std::vector<int>> chunk = first.pop())
+    {
+      int sum = 0;
+      for (int value : *chunk)
+      {
+        sum += value;
+      }
+      second.push(sum);
+    }
+    second.close();
+  });
+
+  long long total = 0;
+  size_t chunks = 0;
+  while (std::optional<int> sum = second.pop())
+  {
+    total += *sum;
+    chunks++;
+  }
+  producer.join();
+  stage.join();
+  EXPECT_EQ(chunks, size_t(count / 10));
+  EXPECT_EQ(total, (long long)count * (count - 1) / 2);
+}
+
+TEST(PJ_BOUNDED_QUEUE_TEST, close_wakes_blocked_producer)
+{
+  BoundedQueue<int> queue(1);
+  queue.push(0);
+  std::thread producer([&queue] { EXPECT_FALSE(queue.push(1)); });
+  queue.close();
+  producer.join();
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,271 @@
+#include <gtest/gtest.h>
+#include <pjmath/batch.hpp>
+#include <pjmath/dispatch.hpp>
+#include <pjmath/kernels.hpp>
+#include <pjmath/mat4.hpp>
+#include <pjmath/vec3.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace pjmath;
+
+namespace
+{
+  constexpr Isa all_isas[] = {Isa::baseline, Isa::sse42, Isa::avx2, Isa::avx512};
+
+  struct Results
+  {
+    std::vector<real_t> points;
+    std::vector<real_t> projected;
+    std::vector<real_t> products;
+    std::vector<real_t> sines;
+    std::vector<real_t> cosines;
+    std::vector<real_t> normalized;
+    std::vector<real_t> sums;
+    std::vector<uint16_t> halves;
+    std::vector<real_t> expanded;
+  };
+
+  std::vector<real_t> randomValues(size_t n, real_t range, unsigned seed)
+  {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<real_t> uniform(-range, range);
+    std::vector<real_t> values(n);
+    for (real_t &value : values)
+    {
+      value = uniform(random);
+    }
+    return values;
+  }
+
+  Results runAll()
+  {
+    // Odd sizes so every kernel also runs its remainder loop
+    std::vector<real_t> points = randomValues(3 * 1001, 10, 1);
+    std::vector<real_t> angles = randomValues(1003, 50, 2);
+    std::vector<real_t> matrices = randomValues(16 * 37, 2, 3);
+    std::vector<real_t> affine = randomValues(16, 2, 4);
+    affine[12] = affine[13] = affine[14] = 0;
+    affine[15] = 1;
+
+    Results results;
+    results.points.resize(points.size());
+    results.projected.resize(points.size());
+    dispatch::transformPoints(affine.data(), points.data(), results.points.data(), 1001);
+    dispatch::transformPoints(matrices.data(), points.data(), results.projected.data(), 1001);
+
+    results.products.resize(16 * 36);
+    dispatch::multiply4x4(matrices.data(), matrices.data() + 16, results.products.data(), 36);
+
+    results.sines.resize(angles.size());
+    results.cosines.resize(angles.size());
+    dispatch::sinCos(angles.data(), results.sines.data(), results.cosines.data(), angles.size());
+
+    results.normalized = points;
+    dispatch::normalize3(results.normalized.data(), 1001);
+
+    for (size_t n : {0, 5, 8, 1003})
+    {
+      results.sums.push_back(dispatch::sum(angles.data(), n));
+      results.sums.push_back(dispatch::dot(angles.data(), points.data(), n));
+    }
+
+    // Overflow, ties and subnormals of half precision as well
+    std::vector<real_t> values = angles;
+    values.insert(values.end(), {65504, 65520, -1e6, 1 + 0x1p-11, 1 + 0x1p-10 + 0x1p-11, 0x1p-24, 0x1p-25, -1e-6});
+    results.halves.resize(values.size());
+    results.expanded.resize(values.size());
+    dispatch::encodeHalf(values.data(), results.halves.data(), values.size());
+    dispatch::decodeHalf(results.halves.data(), results.expanded.data(), values.size());
+    return results;
+  }
+
+  void expectSameBits(const std::vector<real_t> &actual, const std::vector<real_t> &expected)
+  {
+    ASSERT_EQ(actual.size(), expected.size());
+    EXPECT_EQ(std::memcmp(actual.data(), expected.data(), actual.size() * sizeof(real_t)), 0);
+  }
+
+  // Distance to the expected value in units of its last place
+  real_t ulps(real_t actual, real_t expected)
+  {
+    real_t ulp = std::nextafter(std::fabs(expected), std::numeric_limits<real_t>::infinity()) - std::fabs(expected);
+    return std::fabs(actual - expected) / ulp;
+  }
+}
+
+TEST(dispatch, names)
+{
+  EXPECT_STREQ(isaName(Isa::baseline), "baseline");
+  EXPECT_STREQ(isaName(Isa::sse42), "sse4.2");
+  EXPECT_STREQ(isaName(Isa::avx2), "avx2");
+  EXPECT_STREQ(isaName(Isa::avx512), "avx512");
+  EXPECT_TRUE(isaSupported(Isa::baseline));
+  EXPECT_TRUE(isaSupported(activeIsa()));
+}
+
+TEST(dispatch, set_isa)
+{
+  Isa initial = activeIsa();
+  for (Isa isa : all_isas)
+  {
+    if (isaSupported(isa))
+    {
+      setIsa(isa);
+      EXPECT_EQ(activeIsa(), isa);
+    }
+    else
+    {
+      EXPECT_THROW(setIsa(isa), std::invalid_argument);
+    }
+  }
+  setIsa(initial);
+}
+
+TEST(dispatch, levels_agree)
+{
+  Isa initial = activeIsa();
+  setIsa(Isa::baseline);
+  Results expected = runAll();
+  for (Isa isa : all_isas)
+  {
+    if (!isaSupported(isa))
+    {
+      continue;
+    }
+    SCOPED_TRACE(isaName(isa));
+    setIsa(isa);
+    Results actual = runAll();
+    expectSameBits(actual.points, expected.points);
+    expectSameBits(actual.projected, expected.projected);
+    expectSameBits(actual.products, expected.products);
+    expectSameBits(actual.sines, expected.sines);
+    expectSameBits(actual.cosines, expected.cosines);
+    expectSameBits(actual.normalized, expected.normalized);
+    expectSameBits(actual.sums, expected.sums);
+    EXPECT_EQ(actual.halves, expected.halves);
+    expectSameBits(actual.expanded, expected.expanded);
+  }
+  setIsa(initial);
+}
+
+TEST(dispatch, matches_header_kernels)
+{
+  std::vector<real_t> values = randomValues(1003, 10, 5);
+  EXPECT_EQ(dispatch::sum(values.data(), values.size()), kernels::sum(values.data(), values.size()));
+#if !defined(FP_FAST_FMA)
+  EXPECT_EQ(dispatch::dot(values.data(), values.data() + 1, 1000), kernels::dot(values.data(), values.data() + 1, 1000));
+#endif
+
+  std::vector<real_t> vectors = randomValues(3 * 100, 10, 6);
+  vectors[3] = vectors[4] = vectors[5] = 0;
+  std::vector<real_t> expected = vectors;
+  kernels::normalize<3>(expected.data(), 100, NormalizeMode::exact);
+  dispatch::normalize3(vectors.data(), 100);
+#if !defined(FP_FAST_FMA)
+  expectSameBits(vectors, expected);
+#endif
+  EXPECT_EQ(vectors[3], 0);
+
+  std::vector<Mat4> a(5), b(5), products(5);
+  std::vector<real_t> elements = randomValues(16 * 10, 3, 7);
+  for (size_t i = 0; i < 16 * 5; i++)
+  {
+    a[i / 16][i % 16] = elements[i];
+    b[i / 16][i % 16] = elements[16 * 5 + i];
+  }
+  multiply(a, b, products);
+  for (size_t i = 0; i < a.size(); i++)
+  {
+    EXPECT_EQ(products[i], a[i] * b[i]);
+  }
+  multiply(a, b, a);
+  EXPECT_EQ(a, products);
+
+  std::vector<Vec3> points{{1, 2, 3}, {-4, 0.5, 2}};
+  Mat4 translation = Mat4::identity();
+  translation.at(0, 3) = 10;
+  transformPoints<Vec3>(translation, points, points);
+  EXPECT_EQ(points[0], (Vec3{11, 2, 3}));
+  EXPECT_EQ(points[1], (Vec3{6, 0.5, 2}));
+
+  std::vector<real_t> small{1, 2};
+  EXPECT_THROW(dot(small, values), std::invalid_argument);
+}
+
+TEST(dispatch, sin_cos_accuracy)
+{
+  std::vector<real_t> angles = randomValues(20000, 10, 8);
+  std::vector<real_t> wide = randomValues(2000, 1e5, 9);
+  angles.insert(angles.end(), wide.begin(), wide.end());
+  const real_t half_pi = std::acos(real_t(-1)) / 2;
+  for (int k = -64; k <= 64; k++)
+  {
+    angles.push_back(k * half_pi);
+    angles.push_back(std::nextafter(k * half_pi, real_t(0)));
+  }
+  for (real_t x : {0.0, -0.0, 1e-310, -1e-20, 2e5, -3e9, 1e300})
+  {
+    angles.push_back(x);
+  }
+
+  std::vector<real_t> sines(angles.size()), cosines(angles.size());
+  sinCos(angles, sines, cosines);
+  for (size_t i = 0; i < angles.size(); i++)
+  {
+    real_t x = angles[i];
+    // Near the zeros the absolute error of the reduction is what matters
+    if (std::fabs(std::sin(x)) > 1e-3)
+    {
+      EXPECT_LE(ulps(sines[i], std::sin(x)), 2) << x;
+    }
+    if (std::fabs(std::cos(x)) > 1e-3)
+    {
+      EXPECT_LE(ulps(cosines[i], std::cos(x)), 2) << x;
+    }
+    EXPECT_NEAR(sines[i], std::sin(x), 1e-15) << x;
+    EXPECT_NEAR(cosines[i], std::cos(x), 1e-15) << x;
+  }
+  EXPECT_TRUE(std::signbit(sines[angles.size() - 6]));
+
+  real_t special[] = {std::numeric_limits<real_t>::infinity(), std::numeric_limits<real_t>::quiet_NaN()};
+  real_t s[2], c[2];
+  dispatch::sinCos(special, s, c, 2);
+  EXPECT_TRUE(std::isnan(s[0]) && std::isnan(c[0]) && std::isnan(s[1]) && std::isnan(c[1]));
+}
+
+// Also run with PJMATH_ISA=baseline, see test/CMakeLists.txt
+TEST(dispatch, environment_override)
+{
+  Isa best = Isa::baseline;
+  for (Isa isa : all_isas)
+  {
+    if (isaSupported(isa))
+    {
+      best = isa;
+    }
+  }
+
+  const char *requested = std::getenv("PJMATH_ISA");
+  Isa expected = best;
+  for (Isa isa : all_isas)
+  {
+    if (requested != nullptr && std::strcmp(requested, isaName(isa)) == 0 && isa < best)
+    {
+      expected = isa;
+    }
+  }
+  EXPECT_EQ(activeIsa(), expected);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
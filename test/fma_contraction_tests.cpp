@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <pjmath/batch.hpp>
+#include <pjmath/dispatch.hpp>
+#include <pjmath/kernels.hpp>
+#include <pjmath/vector.hpp>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace pjmath;
+
+// This file is compiled with -mfma, which lets the compiler fuse any product into the
+// addition that follows it
+#if !defined(FP_FAST_FMA)
+#error "fma_contraction_tests must be compiled with fused multiply-adds available"
+#endif
+
+namespace
+{
+  bool fmaSupported()
+  {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("fma");
+  }
+}
+
+TEST(fma_contraction, rounded_products)
+{
+  if (!fmaSupported())
+  {
+    GTEST_SKIP() << "no fma instruction";
+  }
+
+  // The second product is 1 - 2^-60, which rounds to 1 before it cancels the first one
+  std::vector<double> a{1, 1 + 0x1p-30}, b{-1, 1 - 0x1p-30};
+  EXPECT_EQ(kernels::dot(a.data(), b.data(), 2, Summation::reproducible), 0);
+  EXPECT_EQ(dispatch::reproducibleDot(a.data(), b.data(), 2), 0);
+  EXPECT_EQ(dot(std::span<const double>(a), std::span<const double>(b), Summation::reproducible), 0);
+  Vector3 u{1, 1 + 0x1p-30, 0}, v{-1, 1 - 0x1p-30, 0};
+  EXPECT_EQ(u.Dot(v, Summation::reproducible), 0);
+
+  std::vector<float> af{1, 1 + 0x1p-13f}, bf{-1, 1 - 0x1p-13f};
+  EXPECT_EQ(kernels::dot(af.data(), bf.data(), 2, Summation::reproducible), 0);
+
+  // Fast mode is allowed to fuse and keeps the exact result
+  EXPECT_EQ(kernels::dot(a.data(), b.data(), 2), -0x1p-60);
+}
+
+TEST(fma_contraction, same_bits_as_dispatched)
+{
+  if (!fmaSupported())
+  {
+    GTEST_SKIP() << "no fma instruction";
+  }
+
+  std::mt19937 random(5);
+  std::uniform_real_distribution<double> uniform(-1, 1);
+  std::vector<double> a(10007), b(a.size());
+  for (size_t i = 0; i < a.size(); i++)
+  {
+    a[i] = uniform(random);
+    b[i] = uniform(random);
+  }
+
+  Isa initial = activeIsa();
+  for (Isa isa : {Isa::baseline, Isa::sse42, Isa::avx2, Isa::avx512})
+  {
+    if (!isaSupported(isa))
+    {
+      continue;
+    }
+    setIsa(isa);
+    for (size_t n : {7, 1000, 1024, 10007})
+    {
+      double header = kernels::dot(a.data(), b.data(), n, Summation::reproducible);
+      double dispatched = dispatch::reproducibleDot(a.data(), b.data(), n);
+      EXPECT_EQ(std::memcmp(&header, &dispatched, sizeof(header)), 0) << isaName(isa) << " " << n;
+    }
+  }
+  setIsa(initial);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
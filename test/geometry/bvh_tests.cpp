@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+#include <pjmath/bvh.hpp>
+
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace pjmath;
+
+namespace
+{
+  struct Mesh
+  {
+    std::vector<Vector3> vertices;
+    std::vector<uint32_t> indices;
+  };
+
+  // Small random triangles scattered through a cube, the worst case for coherence
+  Mesh randomMesh(size_t triangles, std::mt19937 &rng)
+  {
+    std::uniform_real_distribution<real_t> position(-10, 10);
+    std::uniform_real_distribution<real_t> offset(-1, 1);
+    Mesh mesh;
+    for (size_t i = 0; i < triangles; i++)
+    {
+      Vector3 center{position(rng), position(rng), position(rng)};
+      for (size_t v = 0; v < 3; v++)
+      {
+        mesh.indices.push_back(uint32_t(mesh.vertices.size()));
+        mesh.vertices.push_back(center + Vector3{offset(rng), offset(rng), offset(rng)});
+      }
+    }
+    return mesh;
+  }
+
+  std::vector<Ray> randomRays(size_t count, std::mt19937 &rng)
+  {
+    std::uniform_real_distribution<real_t> position(-12, 12);
+    std::vector<Ray> rays;
+    for (size_t i = 0; i < count; i++)
+    {
+      Vec3 from{position(rng), position(rng), position(rng)};
+      Vec3 to{position(rng), position(rng), position(rng)};
+      rays.push_back(Ray{from, to - from});
+    }
+    return rays;
+  }
+
+  RayHit bruteForce(const Mesh &mesh, const Ray &ray)
+  {
+    Vector3 origin{ray.origin.x(), ray.origin.y(), ray.origin.z()};
+    Vector3 direction{ray.direction.x(), ray.direction.y(), ray.direction.z()};
+    RayHit hit;
+    hit.t = ray.tMax;
+    for (size_t i = 0; i < mesh.indices.size() / 3; i++)
+    {
+      const Vector3 &a = mesh.vertices[mesh.indices[3 * i]];
+      Vector3 e1 = mesh.vertices[mesh.indices[3 * i + 1]] - a;
+      Vector3 e2 = mesh.vertices[mesh.indices[3 * i + 2]] - a;
+      Vector3 p = direction.Cross(e2);
+      real_t det = e1.Dot(p);
+      Vector3 s = origin - a;
+      real_t u = s.Dot(p) / det;
+      Vector3 q = s.Cross(e1);
+      real_t v = direction.Dot(q) / det;
+      real_t t = e2.Dot(q) / det;
+      if (det != 0 && u >= 0 && v >= 0 && u + v <= 1 && t >= ray.tMin && t < hit.t)
+      {
+        hit = RayHit{uint32_t(i), t, u, v};
+      }
+    }
+    if (!hit.hit())
+    {
+      hit.t = RayHit{}.t;
+    }
+    return hit;
+  }
+
+  void expectSameHit(const RayHit &expected, const RayHit &actual)
+  {
+    ASSERT_EQ(expected.hit(), actual.hit());
+    if (expected.hit())
+    {
+      EXPECT_NEAR(expected.t, actual.t, 1e-9);
+      EXPECT_NEAR(expected.u, actual.u, 1e-9);
+      EXPECT_NEAR(expected.v, actual.v, 1e-9);
+    }
+  }
+}
+
+TEST(bvh, single_ray)
+{
+  Mesh mesh{{Vector3{0, 0, 0}, Vector3{1, 0, 0}, Vector3{0, 1, 0}}, {0, 1, 2}};
+  Bvh bvh(std::span<const Vector3>(mesh.vertices), mesh.indices);
+
+  RayHit hit = bvh.intersect(Ray{Vec3{0.25, 0.25, 1}, Vec3{0, 0, -1}});
+  ASSERT_TRUE(hit.hit());
+  EXPECT_EQ(hit.triangle, 0u);
+  EXPECT_DOUBLE_EQ(hit.t, 1);
+  EXPECT_DOUBLE_EQ(hit.u, 0.25);
+  EXPECT_DOUBLE_EQ(hit.v, 0.25);
+
+  EXPECT_FALSE(bvh.intersect(Ray{Vec3{0.75, 0.75, 1}, Vec3{0, 0, -1}}).hit());
+  EXPECT_FALSE(bvh.intersect(Ray{Vec3{0.25, 0.25, 1}, Vec3{0, 0, 1}}).hit());
+  EXPECT_FALSE(bvh.intersect(Ray{Vec3{0.25, 0.25, 1}, Vec3{0, 0, -1}, 0, 0.5}).hit());
+}
+
+TEST(bvh, matches_brute_force)
+{
+  std::mt19937 rng(7);
+  Mesh mesh = randomMesh(3000, rng);
+  Bvh bvh(std::span<const Vector3>(mesh.vertices), mesh.indices);
+  EXPECT_EQ(bvh.triangleCount(), 3000u);
+
+  std::vector<Ray> rays = randomRays(500, rng);
+  std::vector<RayHit> hits(rays.size());
+  bvh.intersect(rays, hits);
+
+  size_t hitCount = 0;
+  for (size_t i = 0; i < rays.size(); i++)
+  {
+    RayHit expected = bruteForce(mesh, rays[i]);
+    hitCount += expected.hit();
+    expectSameHit(expected, bvh.intersect(rays[i]));
+    expectSameHit(expected, hits[i]);
+  }
+  EXPECT_GT(hitCount, 100u);
+}
+
+TEST(bvh, node_layout)
+{
+  std::mt19937 rng(11);
+  Mesh mesh = randomMesh(1000, rng);
+  BvhBuildOptions options;
+  options.maxLeafSize = 4;
+  Bvh bvh(std::span<const Vector3>(mesh.vertices), mesh.indices, options);
+
+  std::span<const Bvh::Node> nodes = bvh.nodes();
+  size_t covered = 0;
+  for (size_t i = 0; i < nodes.size(); i++)
+  {
+    if (nodes[i].isLeaf())
+    {
+      EXPECT_LE(nodes[i].count, 4u);
+      EXPECT_EQ(nodes[i].offset, covered);
+      covered += nodes[i].count;
+      continue;
+    }
+    ASSERT_GT(nodes[i].offset, i + 1);
+    for (size_t child : {i + 1, size_t(nodes[i].offset)})
+    {
+      for (size_t k = 0; k < 3; k++)
+      {
+        EXPECT_LE(nodes[i].min[k], nodes[child].min[k]);
+        EXPECT_GE(nodes[i].max[k], nodes[child].max[k]);
+      }
+    }
+  }
+  EXPECT_EQ(covered, 1000u);
+
+  Aabb bounds = bvh.bounds();
+  for (const Vector3 &vertex : mesh.vertices)
+  {
+    EXPECT_TRUE(bounds.contains(Vec3{vertex.x(), vertex.y(), vertex.z()}));
+  }
+}
+
+TEST(bvh, parallel_build)
+{
+  std::mt19937 rng(3);
+  Mesh mesh = randomMesh(5000, rng);
+  BvhBuildOptions options;
+  options.parallelThreshold = 256;
+  Bvh parallel(std::span<const Vector3>(mesh.vertices), mesh.indices, options);
+  Bvh serial(std::span<const Vector3>(mesh.vertices), mesh.indices);
+
+  ASSERT_EQ(parallel.nodes().size(), serial.nodes().size());
+  for (const Ray &ray : randomRays(200, rng))
+  {
+    expectSameHit(serial.intersect(ray), parallel.intersect(ray));
+  }
+}
+
+TEST(bvh, refit)
+{
+  std::mt19937 rng(5);
+  Mesh mesh = randomMesh(2000, rng);
+  Bvh bvh(std::span<const Vector3>(mesh.vertices), mesh.indices);
+
+  for (Vector3 &vertex : mesh.vertices)
+  {
+    vertex = Vector3{vertex.x() * 1.5 + 2, vertex.z(), -vertex.y()};
+  }
+  bvh.refit(std::span<const Vector3>(mesh.vertices));
+
+  std::vector<Ray> rays = randomRays(300, rng);
+  std::vector<RayHit> hits(rays.size());
+  bvh.intersect(rays, hits);
+  for (size_t i = 0; i < rays.size(); i++)
+  {
+    expectSameHit(bruteForce(mesh, rays[i]), hits[i]);
+  }
+
+  mesh.vertices.pop_back();
+  EXPECT_THROW(bvh.refit(std::span<const Vector3>(mesh.vertices)), std::invalid_argument);
+}
+
+TEST(bvh, invalid_mesh)
+{
+  std::vector<Vec3> vertices{Vec3{0, 0, 0}, Vec3{1, 0, 0}, Vec3{0, 1, 0}};
+  std::vector<uint32_t> indices{0, 1};
+  EXPECT_THROW(Bvh(std::span<const Vec3>(vertices), indices), std::invalid_argument);
+  indices = {0, 1, 3};
+  EXPECT_THROW(Bvh(std::span<const Vec3>(vertices), indices), std::out_of_range);
+
+  Bvh empty;
+  EXPECT_FALSE(empty.intersect(Ray{Vec3{0, 0, 1}, Vec3{0, 0, -1}}).hit());
+  EXPECT_TRUE(empty.bounds().isEmpty());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
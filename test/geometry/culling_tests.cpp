@@ -0,0 +1,153 @@
+
+#include <gtest/gtest.h>
+#include <pjmath/geometry.hpp>
+#include <pjmath/math_funcs.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace pjmath;
+
+namespace
+{
+  // Right handed OpenGL style perspective projection looking down -z
+  Mat4 perspective(real_t fovY, real_t aspect, real_t near, real_t far)
+  {
+    real_t f = 1 / Tan(fovY / 2);
+    return Mat4{f / aspect, 0, 0, 0,
+                0, f, 0, 0,
+                0, 0, (far + near) / (near - far), 2 * far * near / (near - far),
+                0, 0, -1, 0};
+  }
+
+  Mat4 translation(real_t x, real_t y, real_t z)
+  {
+    Mat4 mat = Mat4::identity();
+    mat.block<0, 3, 3, 1>() = Vec3{x, y, z};
+    return mat;
+  }
+}
+
+TEST(culling, plane_extraction)
+{
+  Frustum frustum = Frustum::fromMatrix(perspective(ToRads(90), 1, 1, 100));
+
+  EXPECT_NEAR(frustum.planes[Frustum::near].signedDistance(Vec3{0, 0, -1}), 0, 1e-12);
+  EXPECT_NEAR(frustum.planes[Frustum::far].signedDistance(Vec3{0, 0, -100}), 0, 1e-9);
+  EXPECT_NEAR(frustum.planes[Frustum::left].signedDistance(Vec3{-10, 0, -10}), 0, 1e-6);
+  EXPECT_NEAR(frustum.planes[Frustum::top].signedDistance(Vec3{0, 10, -10}), 0, 1e-6);
+
+  EXPECT_TRUE(frustum.intersects(Sphere{Vec3{0, 0, -50}, 1}));
+  EXPECT_FALSE(frustum.intersects(Sphere{Vec3{0, 0, 5}, 1}));
+  EXPECT_TRUE(frustum.intersects(Sphere{Vec3{0, 0, 1.5}, 3}));
+  EXPECT_FALSE(frustum.intersects(Sphere{Vec3{0, 0, -150}, 10}));
+  EXPECT_FALSE(frustum.intersects(Sphere{Vec3{-30, 0, -20}, 1}));
+
+  EXPECT_TRUE(frustum.intersects(Aabb{Vec3{-1, -1, -11}, Vec3{1, 1, -9}}));
+  EXPECT_FALSE(frustum.intersects(Aabb{Vec3{-1, -1, 1}, Vec3{1, 1, 3}}));
+  EXPECT_TRUE(frustum.intersects(Aabb{Vec3{-100, -100, -50}, Vec3{100, 100, 50}}));
+
+  Frustum zeroToOne = Frustum::fromMatrix(perspective(ToRads(90), 1, 1, 100), ClipDepth::zeroToOne);
+  EXPECT_TRUE(zeroToOne.intersects(Sphere{Vec3{0, 0, -50}, 1}));
+}
+
+TEST(culling, view_matrix)
+{
+  Mat4 viewProjection = perspective(ToRads(60), 16.0 / 9, 0.1, 1000) * translation(0, 0, -20);
+  Frustum frustum = Frustum::fromMatrix(viewProjection);
+
+  EXPECT_TRUE(frustum.intersects(Sphere{Vec3{0, 0, 0}, 1}));
+  EXPECT_FALSE(frustum.intersects(Sphere{Vec3{0, 0, 25}, 1}));
+}
+
+TEST(culling, aabb_transform)
+{
+  Aabb box{Vec3{-1, -2, -3}, Vec3{1, 2, 3}};
+  Mat4 transform = translation(5, 0, 0);
+  transform.block<0, 0, 3, 3>() = Mat3{0, -1, 0, 1, 0, 0, 0, 0, 2};
+
+  Aabb result = box.transformed(transform);
+  EXPECT_EQ(result.min, (Vec3{3, -1, -6}));
+  EXPECT_EQ(result.max, (Vec3{7, 1, 6}));
+
+  Aabb corners = Aabb::empty();
+  EXPECT_TRUE(corners.isEmpty());
+  for (int corner = 0; corner < 8; corner++)
+  {
+    Vec4 point{corner & 1 ? box.max.x() : box.min.x(),
+               corner & 2 ? box.max.y() : box.min.y(),
+               corner & 4 ? box.max.z() : box.min.z(),
+               1};
+    Vec4 transformed = transform * point;
+    corners.expand(Vec3{transformed.x(), transformed.y(), transformed.z()});
+  }
+  EXPECT_EQ(result.min, corners.min);
+  EXPECT_EQ(result.max, corners.max);
+
+  AabbArray boxes;
+  boxes.push_back(box);
+  boxes.push_back(Aabb{Vec3{0, 0, 0}, Vec3{1, 1, 1}});
+  boxes.transform(transform);
+  EXPECT_EQ(boxes[0].min, result.min);
+  EXPECT_EQ(boxes[1].center(), (Vec3{4.5, 0.5, 1}));
+}
+
+TEST(culling, batch_matches_scalar)
+{
+  Frustum frustum = Frustum::fromMatrix(perspective(ToRads(70), 1.5, 0.5, 200) * translation(3, -2, -40));
+
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<real_t> position(-120, 120);
+  std::uniform_real_distribution<real_t> size(0.1, 8);
+
+  AabbArray boxes;
+  SphereArray spheres;
+  std::vector<Aabb> scalarBoxes;
+  std::vector<Sphere> scalarSpheres;
+  for (int i = 0; i < 1000; i++)
+  {
+    Vec3 center{position(rng), position(rng), position(rng)};
+    Vec3 extent{size(rng), size(rng), size(rng)};
+    scalarBoxes.push_back(Aabb::fromCenterExtent(center, extent));
+    boxes.push_back(scalarBoxes.back());
+    scalarSpheres.push_back(Sphere{center, size(rng)});
+    spheres.push_back(scalarSpheres.back());
+  }
+
+  size_t words = (boxes.size() + Frustum::batch_size - 1) / Frustum::batch_size;
+  std::vector<uint64_t> boxMask(words);
+  std::vector<uint64_t> sphereMask(words);
+  frustum.cull(boxes, boxMask);
+  frustum.cull(spheres, sphereMask);
+
+  size_t visible = 0;
+  for (size_t i = 0; i < boxes.size(); i++)
+  {
+    bool boxVisible = (boxMask[i / 64] >> (i % 64)) & 1;
+    bool sphereVisible = (sphereMask[i / 64] >> (i % 64)) & 1;
+    EXPECT_EQ(boxVisible, frustum.intersects(scalarBoxes[i]));
+    EXPECT_EQ(sphereVisible, frustum.intersects(scalarSpheres[i]));
+    visible += boxVisible;
+  }
+  EXPECT_GT(visible, 0);
+  EXPECT_LT(visible, boxes.size());
+  EXPECT_EQ(boxMask.back() >> (boxes.size() % 64), 0);
+
+  std::vector<uint64_t> tooLarge(words + 2, ~uint64_t(0));
+  frustum.cull(spheres, tooLarge);
+  EXPECT_TRUE(std::equal(sphereMask.begin(), sphereMask.end(), tooLarge.begin()));
+  EXPECT_EQ(tooLarge[words], 0);
+  EXPECT_EQ(tooLarge[words + 1], 0);
+  frustum.cull(AabbArray{}, tooLarge);
+  EXPECT_EQ(tooLarge, std::vector<uint64_t>(words + 2, 0));
+
+  std::vector<uint64_t> tooSmall(words - 1);
+  EXPECT_THROW(frustum.cull(boxes, tooSmall), std::invalid_argument);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,276 @@
+#include <gtest/gtest.h>
+#include <pjmath/spatial.hpp>
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace pjmath;
+
+namespace
+{
+  std::vector<Vec3> randomPoints(size_t count, real_t range, std::mt19937 &rng)
+  {
+    std::uniform_real_distribution<real_t> coordinate(-range, range);
+    std::vector<Vec3> points;
+    for (size_t i = 0; i < count; i++)
+    {
+      points.push_back(Vec3{coordinate(rng), coordinate(rng), coordinate(rng)});
+    }
+    return points;
+  }
+
+  real_t distanceSquared(const Vec3 &a, const Vec3 &b)
+  {
+    Vec3 d = a - b;
+    return d.x() * d.x() + d.y() * d.y() + d.z() * d.z();
+  }
+
+  // Every live point sorted by distance then index, as the indices report them
+  std::vector<Neighbor> bruteForce(const std::vector<Vec3> &points, const std::vector<bool> &alive,
+                                   const Vec3 &query)
+  {
+    std::vector<Neighbor> all;
+    for (size_t i = 0; i < points.size(); i++)
+    {
+      if (alive.empty() || alive[i])
+      {
+        all.push_back(Neighbor{uint32_t(i), distanceSquared(points[i], query)});
+      }
+    }
+    std::sort(all.begin(), all.end(), [](const Neighbor &a, const Neighbor &b) {
+      return a.distanceSquared < b.distanceSquared ||
+             (a.distanceSquared == b.distanceSquared && a.index < b.index);
+    });
+    return all;
+  }
+
+  std::vector<Neighbor> nearestBruteForce(const std::vector<Vec3> &points, const std::vector<bool> &alive,
+                                          const Vec3 &query, size_t k)
+  {
+    std::vector<Neighbor> all = bruteForce(points, alive, query);
+    all.resize(std::min(k, all.size()));
+    return all;
+  }
+
+  std::vector<Neighbor> radiusBruteForce(const std::vector<Vec3> &points, const std::vector<bool> &alive,
+                                         const Vec3 &query, real_t radius)
+  {
+    std::vector<Neighbor> all = bruteForce(points, alive, query);
+    all.erase(std::find_if(all.begin(), all.end(),
+                           [radius](const Neighbor &n) { return n.distanceSquared > radius * radius; }),
+              all.end());
+    return all;
+  }
+
+  void expectSame(std::span<const Neighbor> expected, std::span<const Neighbor> actual)
+  {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+      EXPECT_EQ(expected[i].index, actual[i].index);
+      EXPECT_DOUBLE_EQ(expected[i].distanceSquared, actual[i].distanceSquared);
+    }
+  }
+}
+
+TEST(kd_tree, nearest)
+{
+  std::mt19937 rng(1);
+  std::vector<Vec3> points = randomPoints(5000, 10, rng);
+  KdTree tree{std::span<const Vec3>(points)};
+  EXPECT_EQ(tree.size(), 5000u);
+
+  for (const Vec3 &query : randomPoints(100, 12, rng))
+  {
+    expectSame(nearestBruteForce(points, {}, query, 1), tree.nearest(query, 1));
+    expectSame(nearestBruteForce(points, {}, query, 10), tree.nearest(query, 10));
+  }
+  EXPECT_EQ(tree.nearest(Vec3{0, 0, 0}, 6000).size(), 5000u);
+  EXPECT_TRUE(KdTree().nearest(Vec3{0, 0, 0}, 3).empty());
+}
+
+TEST(kd_tree, within_radius)
+{
+  std::mt19937 rng(2);
+  std::vector<Vec3> points = randomPoints(3000, 5, rng);
+  KdTree tree{std::span<const Vec3>(points)};
+
+  for (const Vec3 &query : randomPoints(100, 6, rng))
+  {
+    expectSame(radiusBruteForce(points, {}, query, 1.5), tree.withinRadius(query, 1.5));
+  }
+}
+
+TEST(kd_tree, batch)
+{
+  std::mt19937 rng(3);
+  std::vector<Vec3> points = randomPoints(4000, 10, rng);
+  std::vector<Vector3> vectors;
+  for (const Vec3 &point : points)
+  {
+    vectors.push_back(Vector3{point.x(), point.y(), point.z()});
+  }
+  KdTree tree{std::span<const Vector3>(vectors)};
+
+  std::vector<Vec3> queries = randomPoints(1000, 10, rng);
+  NeighborLists nearest = tree.nearest(std::span<const Vec3>(queries), 4);
+  NeighborLists within = tree.withinRadius(std::span<const Vec3>(queries), 1);
+  ASSERT_EQ(nearest.size(), queries.size());
+  ASSERT_EQ(within.size(), queries.size());
+  for (size_t i = 0; i < queries.size(); i++)
+  {
+    expectSame(nearestBruteForce(points, {}, queries[i], 4), nearest[i]);
+    expectSame(radiusBruteForce(points, {}, queries[i], 1), within[i]);
+  }
+}
+
+TEST(kd_tree, parallel_build)
+{
+  std::mt19937 rng(6);
+  std::vector<Vec3> points = randomPoints(200000, 10, rng);
+  KdTree tree{std::span<const Vec3>(points)};
+
+  for (const Vec3 &query : randomPoints(20, 10, rng))
+  {
+    expectSame(nearestBruteForce(points, {}, query, 3), tree.nearest(query, 3));
+  }
+}
+
+TEST(kd_tree, duplicate_points)
+{
+  std::vector<Vec3> points(100, Vec3{1, 2, 3});
+  KdTree tree{std::span<const Vec3>(points)};
+  std::vector<Neighbor> found = tree.nearest(Vec3{1, 2, 3}, 5);
+  ASSERT_EQ(found.size(), 5u);
+  for (uint32_t i = 0; i < 5; i++)
+  {
+    EXPECT_EQ(found[i].index, i);
+  }
+}
+
+TEST(hash_grid, matches_brute_force)
+{
+  std::mt19937 rng(4);
+  std::vector<Vec3> points = randomPoints(3000, 10, rng);
+  HashGrid grid(1.0, std::span<const Vec3>(points));
+  EXPECT_EQ(grid.size(), 3000u);
+
+  std::vector<Vec3> queries = randomPoints(200, 14, rng);
+  for (const Vec3 &query : queries)
+  {
+    expectSame(nearestBruteForce(points, {}, query, 8), grid.nearest(query, 8));
+    expectSame(radiusBruteForce(points, {}, query, 2.5), grid.withinRadius(query, 2.5));
+  }
+
+  NeighborLists nearest = grid.nearest(std::span<const Vec3>(queries), 3);
+  for (size_t i = 0; i < queries.size(); i++)
+  {
+    expectSame(nearestBruteForce(points, {}, queries[i], 3), nearest[i]);
+  }
+}
+
+TEST(hash_grid, incremental_updates)
+{
+  std::mt19937 rng(5);
+  std::vector<Vec3> points = randomPoints(500, 5, rng);
+  HashGrid grid(0.75);
+  for (const Vec3 &point : points)
+  {
+    grid.insert(point);
+  }
+  std::vector<bool> alive(points.size(), true);
+
+  std::uniform_int_distribution<uint32_t> pick(0, uint32_t(points.size() - 1));
+  for (size_t i = 0; i < 100; i++)
+  {
+    uint32_t id = pick(rng);
+    if (alive[id])
+    {
+      grid.remove(id);
+      alive[id] = false;
+    }
+  }
+  std::vector<Vec3> moves = randomPoints(200, 5, rng);
+  for (size_t i = 0; i < moves.size(); i++)
+  {
+    uint32_t id = uint32_t(i * 2);
+    if (alive[id])
+    {
+      grid.move(id, moves[i]);
+      points[id] = moves[i];
+    }
+  }
+  EXPECT_EQ(grid.size(), size_t(std::count(alive.begin(), alive.end(), true)));
+
+  for (const Vec3 &query : randomPoints(100, 6, rng))
+  {
+    expectSame(nearestBruteForce(points, alive, query, 5), grid.nearest(query, 5));
+    expectSame(radiusBruteForce(points, alive, query, 1.2), grid.withinRadius(query, 1.2));
+  }
+
+  uint32_t removed = uint32_t(std::find(alive.begin(), alive.end(), false) - alive.begin());
+  EXPECT_FALSE(grid.contains(removed));
+  EXPECT_THROW(grid.remove(removed), std::out_of_range);
+  uint32_t reused = grid.insert(Vec3{1, 1, 1});
+  EXPECT_LT(reused, points.size());
+  EXPECT_EQ(grid.position(reused), (Vec3{1, 1, 1}));
+}
+
+TEST(hash_grid, empty_cells_are_erased)
+{
+  std::mt19937 rng(9);
+  std::vector<Vec3> points = randomPoints(300, 4, rng);
+  HashGrid grid(0.5, std::span<const Vec3>(points));
+  size_t occupied = grid.cellCount();
+
+  // A walker crossing many cells only ever occupies one extra cell
+  uint32_t walker = grid.insert(Vec3{-20, -20, -20});
+  for (int step = 0; step < 200; step++)
+  {
+    grid.move(walker, Vec3{-20 + 0.3 * step, -20 + 0.2 * step, 40 - 0.3 * step});
+    ASSERT_LE(grid.cellCount(), occupied + 1);
+  }
+  grid.remove(walker);
+  EXPECT_EQ(grid.cellCount(), occupied);
+
+  // Far cells vacated by moves no longer widen the searched range, results stay exact
+  std::vector<bool> alive(points.size(), true);
+  for (size_t i = 0; i < 50; i++)
+  {
+    grid.move(uint32_t(i), Vec3{30, 30, 30});
+    grid.move(uint32_t(i), points[i]);
+  }
+  EXPECT_EQ(grid.cellCount(), occupied);
+  for (const Vec3 &query : randomPoints(50, 6, rng))
+  {
+    expectSame(nearestBruteForce(points, alive, query, 4), grid.nearest(query, 4));
+    expectSame(radiusBruteForce(points, alive, query, 0.9), grid.withinRadius(query, 0.9));
+  }
+
+  for (uint32_t id = 0; id < points.size(); id++)
+  {
+    grid.remove(id);
+  }
+  EXPECT_EQ(grid.cellCount(), 0u);
+  EXPECT_TRUE(grid.nearest(Vec3{0, 0, 0}, 3).empty());
+  uint32_t last = grid.insert(Vec3{1, 2, 3});
+  ASSERT_EQ(grid.nearest(Vec3{0, 0, 0}, 3).size(), 1u);
+  EXPECT_EQ(grid.nearest(Vec3{0, 0, 0}, 3)[0].index, last);
+}
+
+TEST(hash_grid, invalid)
+{
+  EXPECT_THROW(HashGrid(0), std::invalid_argument);
+  HashGrid grid(1e-3);
+  EXPECT_THROW(grid.insert(Vec3{1e6, 0, 0}), std::out_of_range);
+  EXPECT_EQ(grid.size(), 0u);
+  EXPECT_TRUE(grid.nearest(Vec3{0, 0, 0}, 1).empty());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
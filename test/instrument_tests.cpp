@@ -0,0 +1,84 @@
+#include <pjmath/divisors.hpp>
+#include <pjmath/instrument.hpp>
+#include <pjmath/mat4.hpp>
+#include <pjmath/vector.hpp>
+#include <gtest/gtest.h>
+
+#include <thread>
+
+using namespace pjmath;
+using namespace pjmath::instrument;
+
+static_assert(enabled);
+
+TEST(PJ_INSTRUMENT_TEST, counters)
+{
+  reset();
+  Mat4 a = Mat4::identity();
+  Mat4 b = Mat4::filled(2);
+  EXPECT_EQ(snapshot()[Counter::mat_multiply], 0u);
+
+  Mat4 product = a * b;
+  a += b;
+  a.addScaled(b, 2);
+  Vector3 v{3, 4, 0};
+  v.Normalize();
+  divisorsOf(12);
+
+  Snapshot counts = snapshot();
+  EXPECT_EQ(counts[Counter::mat_multiply], 1u);
+  EXPECT_EQ(counts[Counter::mat_elementwise], 2u);
+  EXPECT_EQ(counts[Counter::vector_normalize], 1u);
+  EXPECT_EQ(counts[Counter::divisors], 1u);
+  EXPECT_EQ(product, b);
+
+  reset();
+  EXPECT_EQ(snapshot()[Counter::mat_multiply], 0u);
+}
+
+TEST(PJ_INSTRUMENT_TEST, copies)
+{
+  reset();
+  Mat4 a = Mat4::identity();
+  uint64_t before = snapshot()[Counter::mat_copy];
+  Mat4 b = a;
+  b = a;
+  EXPECT_EQ(snapshot()[Counter::mat_copy], before + 2);
+}
+
+TEST(PJ_INSTRUMENT_TEST, threads_and_timers)
+{
+  resetAll();
+  {
+    PJMATH_SCOPED_TIMER("outer");
+    PJMATH_SCOPED_TIMER("inner");
+  }
+  std::thread worker([] {
+    Mat4 a = Mat4::identity();
+    for (int i = 0; i < 10; i++)
+    {
+      a = a * a;
+    }
+    PJMATH_SCOPED_TIMER("inner");
+    EXPECT_EQ(snapshot()[Counter::mat_multiply], 10u);
+  });
+  worker.join();
+
+  // The worker exited, its counts live on in the total
+  EXPECT_EQ(snapshot()[Counter::mat_multiply], 0u);
+  Snapshot total = totalSnapshot();
+  EXPECT_EQ(total[Counter::mat_multiply], 10u);
+  EXPECT_EQ(total.timers.at("inner").calls, 2u);
+  EXPECT_EQ(total.timers.at("outer").calls, 1u);
+  EXPECT_EQ(snapshot().timers.at("inner").calls, 1u);
+
+  resetAll();
+  EXPECT_EQ(totalSnapshot()[Counter::mat_multiply], 0u);
+  EXPECT_TRUE(totalSnapshot().timers.empty());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,221 @@
+#include <pjmath/interpolate.hpp>
+#include <pjmath/vec3.hpp>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace pjmath;
+
+namespace
+{
+  std::array<real_t, 4> rotation(const std::array<real_t, 3> &axis, real_t angle)
+  {
+    real_t s = std::sin(angle / 2);
+    return {axis[0] * s, axis[1] * s, axis[2] * s, std::cos(angle / 2)};
+  }
+
+  void set(SoAVec4Array &array, size_t i, const std::array<real_t, 4> &q)
+  {
+    for (size_t k = 0; k < 4; k++)
+    {
+      array.column(k)[i] = q[k];
+    }
+  }
+
+  // Quaternions q and -q are the same rotation
+  real_t rotationDistance(const SoAVec4Array &array, size_t i, const std::array<real_t, 4> &q)
+  {
+    real_t dot = 0;
+    for (size_t k = 0; k < 4; k++)
+    {
+      dot += array.column(k)[i] * q[k];
+    }
+    return 1 - std::fabs(dot);
+  }
+
+  struct Arcs
+  {
+    SoAVec4Array a{0};
+    SoAVec4Array b{0};
+    std::vector<real_t> t{};
+    std::vector<std::array<real_t, 4>> expected{};
+  };
+
+  /**
+   * Pairs of rotations about random axes, with the rotation along the shorter arc at t.
+   */
+  Arcs randomArcs(size_t count)
+  {
+    std::mt19937 random(3);
+    std::normal_distribution<real_t> normal;
+    std::uniform_real_distribution<real_t> uniform(0, 1);
+    Arcs arcs;
+    arcs.a.resize(count);
+    arcs.b.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+      std::array<real_t, 3> axis = {normal(random), normal(random), normal(random)};
+      real_t length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+      for (real_t &x : axis)
+      {
+        x /= length;
+      }
+      real_t from = 6 * uniform(random);
+      // Mix of wide arcs, arcs across the hemisphere boundary and nearly parallel rotations
+      real_t span = i % 3 == 0 ? 1e-7 * uniform(random) : 6 * uniform(random) - 3;
+      real_t t = uniform(random);
+      set(arcs.a, i, rotation(axis, from));
+      // Flipping the sign of every other endpoint must not change the result
+      std::array<real_t, 4> to = rotation(axis, from + span);
+      if (i % 2 == 1)
+      {
+        to = {-to[0], -to[1], -to[2], -to[3]};
+      }
+      set(arcs.b, i, to);
+      arcs.t.push_back(t);
+      arcs.expected.push_back(rotation(axis, from + span * t));
+    }
+    return arcs;
+  }
+}
+
+TEST(PJ_INTERPOLATE_TEST, lerp_per_element)
+{
+  SoAVec3Array a(3);
+  SoAVec3Array b(3);
+  a[0] = Vec3{0, 0, 0};
+  b[0] = Vec3{2, 4, 6};
+  a[1] = Vec3{1, 1, 1};
+  b[1] = Vec3{-1, -1, -1};
+  a[2] = Vec3{5, 6, 7};
+  b[2] = Vec3{8, 9, 10};
+  std::vector<real_t> t = {0.5, 0.25, 1};
+  SoAVec3Array out(0);
+  lerp(a, b, t, out);
+  EXPECT_EQ(Vec3(out[0]), (Vec3{1, 2, 3}));
+  EXPECT_EQ(Vec3(out[1]), (Vec3{0.5, 0.5, 0.5}));
+  EXPECT_EQ(Vec3(out[2]), (Vec3{8, 9, 10}));
+
+  std::vector<real_t> wrongSize(2);
+  EXPECT_THROW(lerp(a, b, wrongSize, out), std::invalid_argument);
+}
+
+TEST(PJ_INTERPOLATE_TEST, slerp_follows_shorter_arc)
+{
+  Arcs arcs = randomArcs(1000);
+  SoAVec4Array out(0);
+  slerp(arcs.a, arcs.b, arcs.t, out);
+  ASSERT_EQ(out.size(), arcs.t.size());
+  for (size_t i = 0; i < out.size(); i++)
+  {
+    EXPECT_LT(rotationDistance(out, i, arcs.expected[i]), 1e-13) << i;
+    real_t x = out.x()[i], y = out.y()[i], z = out.z()[i], w = out.w()[i];
+    EXPECT_NEAR(x * x + y * y + z * z + w * w, 1, 1e-15);
+  }
+}
+
+TEST(PJ_INTERPOLATE_TEST, slerp_in_place_and_endpoints)
+{
+  Arcs arcs = randomArcs(100);
+  std::vector<real_t> zeros(arcs.t.size(), 0);
+  SoAVec4Array start(0);
+  slerp(arcs.a, arcs.b, zeros, start);
+  for (size_t i = 0; i < start.size(); i++)
+  {
+    for (size_t k = 0; k < 4; k++)
+    {
+      EXPECT_NEAR(start.column(k)[i], arcs.a.column(k)[i], 1e-15);
+    }
+  }
+
+  SoAVec4Array expected(0);
+  slerp(arcs.a, arcs.b, arcs.t, expected);
+  slerp(arcs.a, arcs.b, arcs.t, arcs.a);
+  for (size_t k = 0; k < 4; k++)
+  {
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+      EXPECT_EQ(arcs.a.column(k)[i], expected.column(k)[i]);
+    }
+  }
+}
+
+TEST(PJ_INTERPOLATE_TEST, nlerp_stays_on_the_arc)
+{
+  Arcs arcs = randomArcs(1000);
+  SoAVec4Array nlerped(0);
+  SoAVec4Array slerped(0);
+  nlerp(arcs.a, arcs.b, arcs.t, nlerped);
+  slerp(arcs.a, arcs.b, arcs.t, slerped);
+  for (size_t i = 0; i < nlerped.size(); i++)
+  {
+    real_t x = nlerped.x()[i], y = nlerped.y()[i], z = nlerped.z()[i], w = nlerped.w()[i];
+    EXPECT_NEAR(x * x + y * y + z * z + w * w, 1, 1e-15);
+    // Same arc, so nlerp and slerp agree up to the speed along it
+    std::array<real_t, 4> s = {slerped.x()[i], slerped.y()[i], slerped.z()[i], slerped.w()[i]};
+    EXPECT_LT(rotationDistance(nlerped, i, s), 0.03) << i;
+  }
+}
+
+TEST(PJ_INTERPOLATE_TEST, hermite_reproduces_cubics)
+{
+  // f(t) = t³ - t, f(0) = 0, f(1) = 0, f'(0) = -1, f'(1) = 2
+  SoAVecArray<1> p0(5), m0(5), p1(5), m1(5), out(0);
+  std::vector<real_t> t;
+  for (size_t i = 0; i < 5; i++)
+  {
+    m0.x()[i] = -1;
+    m1.x()[i] = 2;
+    t.push_back(real_t(i) / 4);
+  }
+  hermite(p0, m0, p1, m1, t, out);
+  for (size_t i = 0; i < 5; i++)
+  {
+    EXPECT_NEAR(out.x()[i], t[i] * t[i] * t[i] - t[i], 1e-15);
+  }
+}
+
+TEST(PJ_INTERPOLATE_TEST, catmull_rom_interpolates_keys)
+{
+  SoAVec3Array p0(3), p1(3), p2(3), p3(3), out(0);
+  for (size_t i = 0; i < 3; i++)
+  {
+    // Evenly spaced keys on a line, the curve must stay on it at constant speed
+    real_t offset = real_t(i);
+    p0[i] = Vec3{offset - 1, 2 * (offset - 1), 5};
+    p1[i] = Vec3{offset, 2 * offset, 5};
+    p2[i] = Vec3{offset + 1, 2 * (offset + 1), 5};
+    p3[i] = Vec3{offset + 2, 2 * (offset + 2), 5};
+  }
+  std::vector<real_t> t = {0, 0.3, 1};
+  catmullRom(p0, p1, p2, p3, t, out);
+  EXPECT_EQ(Vec3(out[0]), Vec3(p1[0]));
+  EXPECT_NEAR(out.x()[1], 1.3, 1e-15);
+  EXPECT_NEAR(out.y()[1], 2.6, 1e-15);
+  EXPECT_EQ(out.z()[1], 5);
+  EXPECT_EQ(Vec3(out[2]), Vec3(p2[2]));
+
+  // Matches the Hermite curve with tangents (p2 - p0) / 2 and (p3 - p1) / 2
+  SoAVec3Array q0(1), q1(1), q2(1), q3(1), m0(1), m1(1), viaHermite(0), viaCatmullRom(0);
+  q0[0] = Vec3{0, 1, -2};
+  q1[0] = Vec3{1, 3, 0};
+  q2[0] = Vec3{4, 2, 1};
+  q3[0] = Vec3{5, -1, 7};
+  m0[0] = Vec3{2, 0.5, 1.5};
+  m1[0] = Vec3{2, -2, 3.5};
+  std::vector<real_t> s = {0.6};
+  hermite(q1, m0, q2, m1, s, viaHermite);
+  catmullRom(q0, q1, q2, q3, s, viaCatmullRom);
+  for (size_t k = 0; k < 3; k++)
+  {
+    EXPECT_NEAR(viaHermite.column(k)[0], viaCatmullRom.column(k)[0], 1e-14);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,85 @@
+#include <pjmath/mat_chain.hpp>
+#include <pjmath/mat3.hpp>
+#include <pjmath/vec3.hpp>
+#include <gtest/gtest.h>
+
+#include <type_traits>
+
+using namespace pjmath;
+
+namespace
+{
+  template <typename M>
+  M sequence(int start)
+  {
+    M m;
+    for (size_t i = 0; i < m.size(); i++)
+    {
+      m[i] = typename M::value_type((start + int(i) * 7) % 11 - 5);
+    }
+    return m;
+  }
+}
+
+TEST(PJ_MAT_TEST, test_chain_order_is_optimal)
+{
+  using A = Mat<int, 3, 64>;
+  using B = Mat<int, 64, 64>;
+  using V = Mat<int, 64, 1>;
+  using Chain = MatChain<A, B, V>;
+  static_assert(Chain::left_to_right_cost == 3 * 64 * 64 + 3 * 64 * 1);
+  static_assert(Chain::optimal_cost == 64 * 64 * 1 + 3 * 64 * 1);
+  static_assert(Chain::split(0, 2) == 0);
+
+  // Textbook example, 10x30 30x5 5x60 is cheapest as (AB)C
+  using Textbook = MatChain<Mat<int, 10, 30>, Mat<int, 30, 5>, Mat<int, 5, 60>>;
+  static_assert(Textbook::optimal_cost == 4500);
+  static_assert(Textbook::split(0, 2) == 1);
+
+  // 30x35 35x15 15x5 5x10 10x20 20x25 from Cormen et al., ((A(BC))((DE)F))
+  using Clrs = MatChain<Mat<int, 30, 35>, Mat<int, 35, 15>, Mat<int, 15, 5>, Mat<int, 5, 10>, Mat<int, 10, 20>,
+                        Mat<int, 20, 25>>;
+  static_assert(Clrs::optimal_cost == 15125);
+  static_assert(Clrs::split(0, 5) == 2);
+  static_assert(Clrs::split(0, 2) == 0);
+  static_assert(Clrs::split(3, 5) == 4);
+}
+
+TEST(PJ_MAT_TEST, test_chain_matches_left_to_right)
+{
+  auto a = sequence<Mat<int, 3, 64>>(1);
+  auto b = sequence<Mat<int, 64, 64>>(2);
+  auto v = sequence<Mat<int, 64, 1>>(3);
+
+  auto lazy = chain(a, b) * v;
+  static_assert(std::is_same_v<decltype(lazy)::Product, decltype(a * b * v)>);
+  EXPECT_EQ(lazy.eval(), a * b * v);
+  Mat<int, 3, 1> converted = chain(a, b, v);
+  EXPECT_EQ(converted, a * b * v);
+}
+
+TEST(PJ_MAT_TEST, test_chain_keeps_product_types)
+{
+  Mat3 r{0, -1, 0, 1, 0, 0, 0, 0, 1};
+  Mat3 s{2, 0, 0, 0, 3, 0, 0, 0, 4};
+  Vec3 x{1, 2, 3};
+  static_assert(std::is_same_v<decltype(chain(r, s) * x)::Product, Vec3>);
+  static_assert(std::is_same_v<decltype(chain(r, s))::Product, Mat3>);
+  Vec3 y = chain(r, s) * x;
+  EXPECT_EQ(y, r * s * x);
+  EXPECT_EQ(chain(r).eval(), r);
+}
+
+TEST(PJ_MAT_TEST, test_chain_with_views)
+{
+  auto a = sequence<Mat<int, 4, 4>>(4);
+  auto b = sequence<Mat<int, 4, 2>>(5);
+  auto c = sequence<Mat<int, 2, 4>>(6);
+  EXPECT_EQ(chain(a.transposedView(), b, c).eval(), a.transposedView() * b * c);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,166 @@
+#include <pjmath/decomposition.hpp>
+#include <pjmath/mat3.hpp>
+#include <pjmath/vec3.hpp>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+using namespace pjmath;
+
+namespace
+{
+  template <size_t M, size_t N>
+  Mat<double, M, N> randomMat(std::mt19937 &rng)
+  {
+    std::uniform_real_distribution<double> value(-1, 1);
+    Mat<double, M, N> mat;
+    for (double &e : mat)
+    {
+      e = value(rng);
+    }
+    return mat;
+  }
+
+  template <size_t M, size_t N>
+  void expectNear(const Mat<double, M, N> &expected, const Mat<double, M, N> &actual, double tolerance)
+  {
+    for (size_t i = 0; i < M * N; i++)
+    {
+      EXPECT_NEAR(expected[i], actual[i], tolerance) << "element " << i;
+    }
+  }
+
+  template <size_t N>
+  void testLuSolve(std::mt19937 &rng)
+  {
+    Mat<double, N, N> a = randomMat<N, N>(rng);
+    Mat<double, N, 2> b = randomMat<N, 2>(rng);
+    Lu lu(a);
+    ASSERT_FALSE(lu.isSingular());
+    expectNear(b, Mat<double, N, 2>(a * lu.solve(b)), 1e-9);
+  }
+
+  template <size_t N>
+  void testCholeskySolve(std::mt19937 &rng)
+  {
+    Mat<double, N, N> g = randomMat<N, N>(rng);
+    Mat<double, N, N> a = g * g.transposed() + Mat<double, N, N>::identity();
+    Mat<double, N, 1> b = randomMat<N, 1>(rng);
+    Cholesky cholesky(a);
+    ASSERT_TRUE(cholesky.isPositiveDefinite());
+    expectNear(a, Mat<double, N, N>(cholesky.lower() * cholesky.lower().transposed()), 1e-12);
+    expectNear(b, Mat<double, N, 1>(a * cholesky.solve(b)), 1e-9);
+  }
+}
+
+TEST(PJ_DECOMPOSITION_TEST, lu_solve)
+{
+  std::mt19937 rng(1);
+  testLuSolve<1>(rng);
+  testLuSolve<3>(rng);
+  testLuSolve<6>(rng);
+  testLuSolve<8>(rng);
+  testLuSolve<12>(rng);
+  testLuSolve<40>(rng);
+}
+
+TEST(PJ_DECOMPOSITION_TEST, lu_determinant_and_pivoting)
+{
+  Mat3 a{0, 2, 1,
+         1, 1, 0,
+         2, 0, 3};
+  Lu lu(a);
+  EXPECT_NEAR(lu.determinant(), -8, 1e-12);
+  EXPECT_EQ(lu.pivots()[0], 2u);
+
+  Vec3 x = solve(a, Vec3{3, 2, 5});
+  EXPECT_NEAR(x.x(), 1, 1e-12);
+  EXPECT_NEAR(x.y(), 1, 1e-12);
+  EXPECT_NEAR(x.z(), 1, 1e-12);
+}
+
+TEST(PJ_DECOMPOSITION_TEST, lu_singular)
+{
+  Mat3 a{1, 2, 3,
+         2, 4, 6,
+         1, 0, 1};
+  Lu lu(a);
+  EXPECT_TRUE(lu.isSingular());
+  EXPECT_EQ(lu.determinant(), 0);
+  EXPECT_THROW(lu.solve(Vec3{1, 2, 3}), std::invalid_argument);
+
+  Mat<double, 20, 20> big;
+  big.at(0, 0) = 1;
+  EXPECT_TRUE(Lu(big).isSingular());
+}
+
+TEST(PJ_DECOMPOSITION_TEST, blocked_lu_matches_fixed_size)
+{
+  constexpr size_t n = 70;
+  std::mt19937 rng(2);
+  Mat<double, n, n> a = randomMat<n, n>(rng);
+  Mat<double, n, 1> b = randomMat<n, 1>(rng);
+
+  std::vector<double> factors(a.begin(), a.end());
+  std::vector<size_t> pivots(n);
+  ASSERT_TRUE(luFactor(std::span<double>(factors), n, std::span<size_t>(pivots)));
+  std::vector<double> x(b.begin(), b.end());
+  luSolve(std::span<const double>(factors), n, std::span<const size_t>(pivots), std::span<double>(x), 1);
+
+  Mat<double, n, 1> fixed = Lu(a).solve(b);
+  for (size_t i = 0; i < n; i++)
+  {
+    EXPECT_NEAR(fixed[i], x[i], 1e-9);
+  }
+
+  EXPECT_THROW(luFactor(std::span<double>(factors), n + 1, std::span<size_t>(pivots)), std::invalid_argument);
+}
+
+TEST(PJ_DECOMPOSITION_TEST, cholesky)
+{
+  std::mt19937 rng(3);
+  testCholeskySolve<2>(rng);
+  testCholeskySolve<6>(rng);
+  testCholeskySolve<16>(rng);
+
+  Mat3 indefinite{1, 2, 0,
+                  2, 1, 0,
+                  0, 0, 1};
+  Cholesky cholesky(indefinite);
+  EXPECT_FALSE(cholesky.isPositiveDefinite());
+  EXPECT_THROW(cholesky.solve(Vec3{1, 1, 1}), std::invalid_argument);
+}
+
+TEST(PJ_DECOMPOSITION_TEST, qr)
+{
+  std::mt19937 rng(4);
+  Mat<double, 7, 4> a = randomMat<7, 4>(rng);
+  Qr qr(a);
+  ASSERT_FALSE(qr.isRankDeficient());
+
+  Mat<double, 7, 4> q = qr.q();
+  expectNear(a, Mat<double, 7, 4>(q * qr.r()), 1e-12);
+  expectNear(Mat<double, 4, 4>::identity(), Mat<double, 4, 4>(q.transposed() * q), 1e-12);
+
+  // Least squares solution satisfies the normal equations
+  Mat<double, 7, 1> b = randomMat<7, 1>(rng);
+  Mat<double, 4, 1> x = qr.solve(b);
+  Mat<double, 4, 1> residual = a.transposed() * (a * x - b);
+  expectNear(Mat<double, 4, 1>(), residual, 1e-12);
+
+  Mat<double, 10, 10> square = randomMat<10, 10>(rng);
+  Mat<double, 10, 1> rhs = randomMat<10, 1>(rng);
+  expectNear(rhs, Mat<double, 10, 1>(square * Qr(square).solve(rhs)), 1e-9);
+
+  Mat<double, 3, 2> dependent{1, 0,
+                              2, 0,
+                              3, 0};
+  EXPECT_TRUE(Qr(dependent).isRankDeficient());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,144 @@
+#include <pjmath/eigen.hpp>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace pjmath;
+
+namespace
+{
+  Mat3 randomRotation(std::mt19937 &rng)
+  {
+    std::normal_distribution<real_t> normal;
+    real_t w = normal(rng), x = normal(rng), y = normal(rng), z = normal(rng);
+    real_t n = std::sqrt(w * w + x * x + y * y + z * z);
+    w /= n, x /= n, y /= n, z /= n;
+    return Mat3{1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y),
+                2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x),
+                2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y)};
+  }
+
+  Mat3 withEigenvalues(const Mat3 &rotation, real_t a, real_t b, real_t c)
+  {
+    Mat3 diagonal{a, 0, 0, 0, b, 0, 0, 0, c};
+    return rotation * diagonal * rotation.transposed();
+  }
+
+  void expectDecomposes(const Mat3 &a, const SymmetricEigen &eigen, real_t tolerance)
+  {
+    EXPECT_LE(eigen.values[0], eigen.values[1]);
+    EXPECT_LE(eigen.values[1], eigen.values[2]);
+
+    Mat3 diagonal{eigen.values[0], 0, 0, 0, eigen.values[1], 0, 0, 0, eigen.values[2]};
+    Mat3 rebuilt = eigen.vectors * diagonal * eigen.vectors.transposed();
+    Mat3 gram = eigen.vectors.transposed() * eigen.vectors;
+    Mat3 identity = Mat3::identity();
+    for (size_t i = 0; i < 9; i++)
+    {
+      EXPECT_NEAR(a[i], rebuilt[i], tolerance);
+      EXPECT_NEAR(identity[i], gram[i], tolerance);
+    }
+
+    const real_t *v = eigen.vectors.data();
+    real_t det = v[0] * (v[4] * v[8] - v[5] * v[7]) - v[1] * (v[3] * v[8] - v[5] * v[6]) +
+                 v[2] * (v[3] * v[7] - v[4] * v[6]);
+    EXPECT_NEAR(det, 1, tolerance);
+  }
+}
+
+TEST(PJ_EIGEN_TEST, random_symmetric)
+{
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<real_t> value(-10, 10);
+  for (size_t i = 0; i < 500; i++)
+  {
+    real_t xx = value(rng), yy = value(rng), zz = value(rng), xy = value(rng), xz = value(rng), yz = value(rng);
+    Mat3 a{xx, xy, xz, xy, yy, yz, xz, yz, zz};
+    SymmetricEigen analytic = symmetricEigen(a);
+    SymmetricEigen jacobi = symmetricEigenJacobi(a);
+    expectDecomposes(a, analytic, 1e-10);
+    expectDecomposes(a, jacobi, 1e-10);
+    for (size_t k = 0; k < 3; k++)
+    {
+      EXPECT_NEAR(analytic.values[k], jacobi.values[k], 1e-10);
+    }
+  }
+}
+
+TEST(PJ_EIGEN_TEST, repeated_eigenvalues)
+{
+  std::mt19937 rng(2);
+  for (size_t i = 0; i < 50; i++)
+  {
+    Mat3 rotation = randomRotation(rng);
+    for (Mat3 a : {withEigenvalues(rotation, 1, 1, 2), withEigenvalues(rotation, -3, 5, 5),
+                   withEigenvalues(rotation, 2, 2 + 1e-9, 7), withEigenvalues(rotation, 4, 4, 4)})
+    {
+      SymmetricEigen eigen = symmetricEigen(a);
+      expectDecomposes(a, eigen, 1e-10);
+    }
+  }
+
+  SymmetricEigen zero = symmetricEigen(Mat3{});
+  EXPECT_EQ(zero.values, (Vec3{0, 0, 0}));
+  EXPECT_EQ(zero.vectors, Mat3::identity());
+}
+
+TEST(PJ_EIGEN_TEST, scale_invariance)
+{
+  std::mt19937 rng(3);
+  Mat3 rotation = randomRotation(rng);
+  for (real_t scale : {1e-150, 1e-20, 1.0, 1e20, 1e150})
+  {
+    Mat3 a = withEigenvalues(rotation, -1 * scale, 0.5 * scale, 2 * scale);
+    SymmetricEigen eigen = symmetricEigen(a);
+    EXPECT_NEAR(eigen.values[0] / scale, -1, 1e-12);
+    EXPECT_NEAR(eigen.values[1] / scale, 0.5, 1e-12);
+    EXPECT_NEAR(eigen.values[2] / scale, 2, 1e-12);
+  }
+}
+
+TEST(PJ_EIGEN_TEST, batch)
+{
+  std::mt19937 rng(4);
+  std::uniform_real_distribution<real_t> value(-1, 1);
+  SymmetricMat3Array matrices;
+  std::vector<Mat3> reference;
+  for (size_t i = 0; i < 1000; i++)
+  {
+    real_t xx = value(rng), yy = value(rng), zz = value(rng), xy = value(rng), xz = value(rng), yz = value(rng);
+    if (i % 7 == 0)
+    {
+      xy = xz = yz = 0;
+      yy = xx;
+    }
+    matrices.push_back(std::array<real_t, 6>{xx, yy, zz, xy, xz, yz});
+    reference.push_back(Mat3{xx, xy, xz, xy, yy, yz, xz, yz, zz});
+  }
+
+  SoAVec3Array values;
+  SoAVecArray<9> vectors;
+  symmetricEigen(matrices, values, vectors);
+  ASSERT_EQ(values.size(), reference.size());
+  ASSERT_EQ(vectors.size(), reference.size());
+  for (size_t i = 0; i < reference.size(); i++)
+  {
+    SymmetricEigen expected = symmetricEigen(reference[i]);
+    for (size_t k = 0; k < 3; k++)
+    {
+      EXPECT_EQ(values.column(k)[i], expected.values[k]);
+    }
+    for (size_t k = 0; k < 9; k++)
+    {
+      EXPECT_EQ(vectors.column(k)[i], expected.vectors[k]);
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,108 @@
+
+#include <gtest/gtest.h>
+#include <pjmath/batch.hpp>
+#include <pjmath/mat4.hpp>
+#include <pjmath/vec3.hpp>
+
+#include <vector>
+
+using namespace pjmath;
+
+TEST(mat_fused, members)
+{
+  Mat<int, 2, 2> mat{1, 2, 3, 4};
+  Mat<int, 2, 2> other{5, 6, 7, 8};
+
+  mat.addScaled(other, 2);
+  EXPECT_EQ(mat, (Mat<int, 2, 2>{11, 14, 17, 20}));
+
+  mat.madd(other, Mat<int, 2, 2>{1, 0, -1, 2});
+  EXPECT_EQ(mat, (Mat<int, 2, 2>{16, 14, 10, 36}));
+
+  mat.fma(Mat<int, 2, 2>::filled(2), other);
+  EXPECT_EQ(mat, (Mat<int, 2, 2>{37, 34, 27, 80}));
+
+  Mat4 from = Mat4::zero();
+  Mat4 to = Mat4::filled(8);
+  Mat4 &result = from.lerp(to, 0.25);
+  EXPECT_EQ(&result, &from);
+  EXPECT_EQ(from, Mat4::filled(2));
+
+  Vec3 a{0, 10, -4};
+  Vec3 b{4, 20, 4};
+  EXPECT_EQ(lerp(a, b, 0.5), (Vec3{2, 15, 0}));
+  EXPECT_EQ(lerp(a, b, 0), a);
+}
+
+TEST(mat_fused, matches_unfused)
+{
+  Vec3 position{1.5, -2.25, 3.125};
+  Vec3 velocity{0.1, 0.2, -0.3};
+  real_t dt = 1.0 / 60;
+
+  Vec3 expected = position + velocity * dt;
+  position.addScaled(velocity, dt);
+  for (size_t i = 0; i < position.size(); i++)
+  {
+    EXPECT_DOUBLE_EQ(position.at(i), expected.at(i));
+  }
+}
+
+TEST(mat_fused, batch)
+{
+  std::vector<Vec3> positions{{0, 0, 0}, {1, 1, 1}, {2, 4, 8}};
+  std::vector<Vec3> velocities{{1, 2, 3}, {-1, 0, 1}, {0.5, 0.5, 0.5}};
+
+  addScaled<Vec3>(positions, velocities, 2);
+  EXPECT_EQ(positions[0], (Vec3{2, 4, 6}));
+  EXPECT_EQ(positions[1], (Vec3{-1, 1, 3}));
+  EXPECT_EQ(positions[2], (Vec3{3, 5, 9}));
+
+  madd<Vec3>(positions, velocities, velocities);
+  EXPECT_EQ(positions[0], (Vec3{3, 8, 15}));
+
+  fma<Vec3>(positions, velocities, velocities);
+  EXPECT_EQ(positions[1], (Vec3{-1, 0, 5}));
+
+  std::vector<Mat4> from(4, Mat4::identity());
+  std::vector<Mat4> to(4, Mat4::filled(3));
+  std::vector<Mat4> out(4);
+  lerp<Mat4>(out, from, to, 0.5);
+  for (const Mat4 &mat : out)
+  {
+    EXPECT_EQ(mat.sum(), 4 * 2 + 12 * 1.5);
+  }
+
+  lerp<Mat4>(from, from, to, 1);
+  EXPECT_EQ(from[3], Mat4::filled(3));
+
+  std::vector<Vec3> shorter(2);
+  EXPECT_THROW(addScaled<Vec3>(shorter, velocities, 1), std::invalid_argument);
+}
+
+TEST(mat_fused, transform_points)
+{
+  Mat4 translate = Mat4::identity();
+  translate.at(0, 3) = 1;
+  translate.at(1, 1) = 2;
+  std::vector<Vec3> points{Vec3{1, 2, 3}, Vec3{-1, 0, 4}};
+  std::vector<Vec3> out(2);
+  transformPoints<Vec3>(translate, points, out);
+  EXPECT_EQ(out[0], (Vec3{2, 4, 3}));
+  EXPECT_EQ(out[1], (Vec3{0, 0, 4}));
+
+  Mat4 projective = Mat4::identity();
+  projective.at(3, 2) = 1;
+  projective.at(3, 3) = 0;
+  std::vector<Vector3> vectors{Vector3{2, 4, 2}};
+  transformPoints<Vector3>(projective, vectors, vectors);
+  EXPECT_EQ(vectors[0], (Vector3{1, 2, 1}));
+
+  EXPECT_THROW(transformPoints<Vec3>(translate, points, std::span<Vec3>(out.data(), 1)), std::invalid_argument);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
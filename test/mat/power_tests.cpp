@@ -0,0 +1,139 @@
+#include <pjmath/mat.hpp>
+#include <pjmath/mat3.hpp>
+#include <pjmath/modular.hpp>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+
+using namespace pjmath;
+
+namespace
+{
+  using Wide = unsigned __int128;
+
+  constexpr uint64_t prime = 1000000007;
+
+  // Reference product with a plain division per element
+  template <size_t N>
+  Mat<int64_t, N, N> multiplyMod(const Mat<int64_t, N, N> &lhs, const Mat<int64_t, N, N> &rhs, uint64_t modulus)
+  {
+    Mat<int64_t, N, N> product;
+    for (size_t row = 0; row < N; row++)
+    {
+      for (size_t column = 0; column < N; column++)
+      {
+        Wide sum = 0;
+        for (size_t k = 0; k < N; k++)
+        {
+          sum = (sum + Wide(uint64_t(lhs.at(row, k))) * uint64_t(rhs.at(k, column))) % modulus;
+        }
+        product.at(row, column) = int64_t(sum);
+      }
+    }
+    return product;
+  }
+
+  template <size_t N>
+  Mat<int64_t, N, N> powModReference(Mat<int64_t, N, N> base, uint64_t exponent, uint64_t modulus)
+  {
+    auto result = Mat<int64_t, N, N>::identity();
+    for (; exponent > 0; exponent >>= 1)
+    {
+      if (exponent & 1)
+      {
+        result = multiplyMod(result, base, modulus);
+      }
+      base = multiplyMod(base, base, modulus);
+    }
+    return result;
+  }
+
+  // Fibonacci numbers modulo m by fast doubling, F(2k) = F(k)(2F(k+1) - F(k)), F(2k+1) = F(k)² + F(k+1)²
+  std::pair<uint64_t, uint64_t> fibonacci(uint64_t n, uint64_t modulus)
+  {
+    if (n == 0)
+    {
+      return {0, 1};
+    }
+    auto [a, b] = fibonacci(n / 2, modulus);
+    uint64_t c = uint64_t(Wide(a) * ((2 * b + modulus - a) % modulus) % modulus);
+    uint64_t d = uint64_t((Wide(a) * a + Wide(b) * b) % modulus);
+    return n % 2 == 0 ? std::pair{c, d} : std::pair{d, (c + d) % modulus};
+  }
+}
+
+TEST(PJ_MAT_TEST, test_pow_small_exponents)
+{
+  Mat3 a{1, 2, 0, -1, 1, 3, 2, 0, 1};
+  EXPECT_EQ(a.pow(0), Mat3::identity());
+  EXPECT_EQ(a.pow(1), a);
+
+  Mat3 expected = Mat3::identity();
+  for (uint64_t exponent = 1; exponent <= 12; exponent++)
+  {
+    expected = expected * a;
+    EXPECT_EQ(a.pow(exponent), expected) << "exponent " << exponent;
+  }
+}
+
+TEST(PJ_MAT_TEST, test_pow_integer_matrix)
+{
+  Mat<int64_t, 2, 2> fib{1, 1, 1, 0};
+  Mat<int64_t, 2, 2> expected{165580141, 102334155, 102334155, 63245986};
+  EXPECT_EQ(fib.pow(40), expected);
+}
+
+TEST(PJ_MAT_TEST, test_pow_mod_fibonacci)
+{
+  Mat<int64_t, 2, 2> fib{1, 1, 1, 0};
+  for (uint64_t n : {uint64_t(1), uint64_t(2), uint64_t(90), uint64_t(1000000), uint64_t(1000000000000000000),
+                     ~uint64_t(0)})
+  {
+    auto power = fib.powMod(n, prime);
+    auto [fn, fn1] = fibonacci(n, prime);
+    EXPECT_EQ(uint64_t(power.at(0, 1)), fn) << "n = " << n;
+    EXPECT_EQ(uint64_t(power.at(0, 0)), fn1) << "n = " << n;
+  }
+}
+
+TEST(PJ_MAT_TEST, test_pow_mod_matches_reference)
+{
+  Mat<int64_t, 4, 4> a{3, -7, 12, 0, 5, 9, -1, 4, 2, 2, 8, -6, 1, 0, 11, 13};
+  Mat<int64_t, 4, 4> reduced;
+  // A large odd modulus exercises the full 128-bit accumulation in every product
+  const uint64_t modulus = (uint64_t(1) << 62) + 135;
+  for (size_t i = 0; i < a.size(); i++)
+  {
+    reduced[i] = (a[i] % int64_t(modulus) + int64_t(modulus)) % int64_t(modulus);
+  }
+
+  for (uint64_t exponent : {uint64_t(0), uint64_t(1), uint64_t(2), uint64_t(37), uint64_t(123456789123456789)})
+  {
+    EXPECT_EQ(a.powMod(exponent, modulus), powModReference(reduced, exponent, modulus)) << "exponent " << exponent;
+    EXPECT_EQ(a.powMod(exponent, prime), powModReference(a.powMod(1, prime), exponent, prime))
+        << "exponent " << exponent;
+  }
+}
+
+TEST(PJ_MAT_TEST, test_pow_mod_rejects_even_modulus)
+{
+  Mat<int64_t, 2, 2> a{1, 1, 1, 0};
+  EXPECT_THROW(a.powMod(10, 1u << 20), std::invalid_argument);
+  EXPECT_THROW(a.powMod(10, 1), std::invalid_argument);
+}
+
+TEST(PJ_MAT_TEST, test_scalar_pow_mod)
+{
+  EXPECT_EQ(powMod<int64_t>(2, 10, prime), 1024);
+  EXPECT_EQ(powMod<int64_t>(-2, 3, prime), int64_t(prime) - 8);
+  // Fermat's little theorem
+  EXPECT_EQ(powMod<uint64_t>(123456789, prime - 1, prime), 1u);
+  EXPECT_EQ(powMod<int64_t>(5, 0, prime), 1);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,210 @@
+#include <pjmath/sparse.hpp>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace pjmath;
+
+namespace
+{
+  using Mat34 = Mat<real_t, 3, 4>;
+
+  /**
+   * Laplacian of an n by n grid plus a small shift, symmetric positive definite
+   */
+  CsrMatrix gridLaplacian(size_t n)
+  {
+    CooBuilder builder(n * n, n * n);
+    builder.reserve(n * n * 5);
+    for (size_t i = 0; i < n; i++)
+    {
+      for (size_t j = 0; j < n; j++)
+      {
+        size_t row = i * n + j;
+        builder.add(row, row, 4.01);
+        if (i > 0)
+        {
+          builder.add(row, row - n, -1);
+        }
+        if (i + 1 < n)
+        {
+          builder.add(row, row + n, -1);
+        }
+        if (j > 0)
+        {
+          builder.add(row, row - 1, -1);
+        }
+        if (j + 1 < n)
+        {
+          builder.add(row, row + 1, -1);
+        }
+      }
+    }
+    return builder.toCsr();
+  }
+
+  CsrMatrix randomMatrix(size_t rows, size_t columns, size_t count, unsigned seed)
+  {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> row(0, rows - 1);
+    std::uniform_int_distribution<size_t> column(0, columns - 1);
+    std::uniform_real_distribution<real_t> value(-1, 1);
+    CooBuilder builder(rows, columns);
+    for (size_t k = 0; k < count; k++)
+    {
+      builder.add(row(rng), column(rng), value(rng));
+    }
+    return builder.toCsr();
+  }
+}
+
+TEST(PJ_SPARSE_TEST, builder)
+{
+  CooBuilder builder(3, 4);
+  builder.add(2, 3, 1);
+  builder.add(0, 1, 2);
+  builder.add(2, 0, 3);
+  builder.add(0, 1, 4);
+  EXPECT_EQ(builder.size(), 4u);
+  EXPECT_THROW(builder.add(3, 0, 1), std::out_of_range);
+
+  CsrMatrix csr = builder.toCsr();
+  EXPECT_EQ(csr.rows(), 3u);
+  EXPECT_EQ(csr.columns(), 4u);
+  EXPECT_EQ(csr.nonZeros(), 3u);
+  EXPECT_EQ(std::vector<size_t>(csr.rowOffsets().begin(), csr.rowOffsets().end()), (std::vector<size_t>{0, 1, 1, 3}));
+  EXPECT_EQ(std::vector<uint32_t>(csr.columnIndices().begin(), csr.columnIndices().end()),
+            (std::vector<uint32_t>{1, 0, 3}));
+  EXPECT_EQ(csr.at(0, 1), 6);
+  EXPECT_EQ(csr.at(1, 1), 0);
+  EXPECT_THROW(csr.at(0, 4), std::out_of_range);
+
+  CscMatrix csc = builder.toCsc();
+  EXPECT_EQ(csc.rows(), 3u);
+  EXPECT_EQ(csc.columns(), 4u);
+  EXPECT_EQ(csc.toDense<Mat34>(), csr.toDense<Mat34>());
+  EXPECT_EQ(csc.toCsr().toDense<Mat34>(), csr.toDense<Mat34>());
+}
+
+TEST(PJ_SPARSE_TEST, validation)
+{
+  EXPECT_NO_THROW(CsrMatrix(2, 2, {0, 1, 2}, {1, 0}, {1, 2}));
+  EXPECT_THROW(CsrMatrix(2, 2, {0, 1}, {1}, {1}), std::invalid_argument);
+  EXPECT_THROW(CsrMatrix(2, 2, {0, 2, 2}, {1, 1}, {1, 2}), std::invalid_argument);
+  EXPECT_THROW(CsrMatrix(2, 2, {0, 1, 2}, {1, 2}, {1, 2}), std::invalid_argument);
+  EXPECT_THROW(CscMatrix(2, 2, {0, 1, 2}, {0}, {1, 2}), std::invalid_argument);
+  EXPECT_THROW((CsrMatrix{}.toDense<Mat34>()), std::invalid_argument);
+}
+
+TEST(PJ_SPARSE_TEST, dense_round_trip)
+{
+  Mat34 dense{1, 0, 0, 2, 0, 0, 0, 0, 0, 3, 1e-9, 4};
+  CsrMatrix csr = CsrMatrix::fromDense(dense);
+  EXPECT_EQ(csr.nonZeros(), 5u);
+  EXPECT_EQ(csr.toDense<Mat34>(), dense);
+  EXPECT_EQ(CsrMatrix::fromDense(dense, 1e-6).nonZeros(), 4u);
+
+  CscMatrix csc = CscMatrix::fromDense(dense);
+  EXPECT_EQ(csc.toDense<Mat34>(), dense);
+  EXPECT_EQ(csc.at(2, 1), 3);
+  EXPECT_EQ(csr.transposed().toDense<Mat34::Transpose>(), dense.transposed());
+
+  std::vector<real_t> x{1, 2, 3, 4};
+  std::vector<real_t> y(3);
+  csr.multiply(x, y);
+  EXPECT_EQ(y[0], 9);
+  EXPECT_EQ(y[1], 0);
+  EXPECT_NEAR(y[2], 22 + 3e-9, 1e-14);
+  EXPECT_THROW(csr.multiply(y, x), std::invalid_argument);
+
+  std::vector<real_t> transposed(4);
+  csc.multiplyTransposed(y, transposed);
+  for (size_t j = 0; j < 4; j++)
+  {
+    EXPECT_DOUBLE_EQ(transposed[j], dense.at(0, j) * y[0] + dense.at(1, j) * y[1] + dense.at(2, j) * y[2]);
+  }
+}
+
+TEST(PJ_SPARSE_TEST, parallel_multiply)
+{
+  // Large enough to split across threads
+  size_t rows = 20000;
+  size_t columns = 15000;
+  CsrMatrix csr = randomMatrix(rows, columns, 400000, 1);
+  CscMatrix csc = csr.toCsc();
+
+  std::mt19937 rng(2);
+  std::uniform_real_distribution<real_t> value(-1, 1);
+  std::vector<real_t> x(columns);
+  for (real_t &v : x)
+  {
+    v = value(rng);
+  }
+
+  std::vector<real_t> expected(rows, 0);
+  for (size_t i = 0; i < rows; i++)
+  {
+    for (size_t k = csr.rowOffsets()[i]; k < csr.rowOffsets()[i + 1]; k++)
+    {
+      expected[i] += csr.values()[k] * x[csr.columnIndices()[k]];
+    }
+  }
+
+  std::vector<real_t> y(rows);
+  csr.multiply(x, y);
+  std::vector<real_t> scattered(rows);
+  csc.multiply(x, scattered);
+  for (size_t i = 0; i < rows; i++)
+  {
+    EXPECT_NEAR(y[i], expected[i], 1e-12);
+    EXPECT_NEAR(scattered[i], expected[i], 1e-12);
+  }
+
+  std::vector<real_t> back(columns);
+  csr.multiplyTransposed(y, back);
+  std::vector<real_t> gathered(columns);
+  csc.multiplyTransposed(y, gathered);
+  for (size_t j = 0; j < columns; j++)
+  {
+    EXPECT_NEAR(back[j], gathered[j], 1e-12);
+  }
+}
+
+TEST(PJ_SPARSE_TEST, conjugate_gradient)
+{
+  size_t n = 100;
+  CsrMatrix a = gridLaplacian(n);
+  std::vector<real_t> expected(n * n);
+  for (size_t i = 0; i < expected.size(); i++)
+  {
+    expected[i] = std::sin(real_t(i) * 0.01);
+  }
+  std::vector<real_t> b(n * n);
+  a.multiply(expected, b);
+
+  std::vector<real_t> x(n * n, 0);
+  ConjugateGradientResult result = conjugateGradient(a, b, x, 1e-12);
+  EXPECT_TRUE(result.converged);
+  EXPECT_LE(result.residual, 1e-12);
+  EXPECT_GT(result.iterations, 0u);
+  for (size_t i = 0; i < x.size(); i++)
+  {
+    EXPECT_NEAR(x[i], expected[i], 1e-9);
+  }
+
+  ConjugateGradientResult limited = conjugateGradient(a, b, std::span<real_t>(x.data(), x.size()), 0, 3);
+  EXPECT_LE(limited.iterations, 3u);
+
+  std::vector<real_t> zero(n * n, 0);
+  EXPECT_TRUE(conjugateGradient(a, zero, x).converged);
+  EXPECT_EQ(x, zero);
+  EXPECT_THROW(conjugateGradient(randomMatrix(3, 4, 5, 3), zero, x), std::invalid_argument);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
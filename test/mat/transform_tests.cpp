@@ -0,0 +1,168 @@
+#include <pjmath/transform.hpp>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace pjmath;
+
+namespace
+{
+  template <typename M>
+  void expectNear(const M &actual, const M &expected, real_t tolerance)
+  {
+    for (size_t i = 0; i < actual.size(); i++)
+    {
+      EXPECT_NEAR(actual[i], expected[i], tolerance) << "element " << i;
+    }
+  }
+
+  Mat4 embed(const Mat3 &r)
+  {
+    Mat4 m = Mat4::identity();
+    for (size_t row = 0; row < 3; row++)
+    {
+      for (size_t column = 0; column < 3; column++)
+      {
+        m.at(row, column) = r.at(row, column);
+      }
+    }
+    return m;
+  }
+
+  Vec4 axisAngle(const Vec3 &axis, real_t angle)
+  {
+    real_t s = std::sin(angle / 2);
+    return Vec4{axis.x() * s, axis.y() * s, axis.z() * s, std::cos(angle / 2)};
+  }
+}
+
+TEST(PJ_MAT_TEST, test_sin_cos)
+{
+  for (real_t x : {0.0, 0.5, -2.0, 100.0})
+  {
+    real_t s, c;
+    SinCos(x, s, c);
+    EXPECT_EQ(s, std::sin(x));
+    EXPECT_EQ(c, std::cos(x));
+  }
+}
+
+TEST(PJ_MAT_TEST, test_axis_rotations)
+{
+  const real_t angle = 0.7;
+  real_t s = std::sin(angle), c = std::cos(angle);
+  EXPECT_EQ(Mat3::rotationX(angle), (Mat3{1, 0, 0, 0, c, -s, 0, s, c}));
+  EXPECT_EQ(Mat3::rotationY(angle), (Mat3{c, 0, s, 0, 1, 0, -s, 0, c}));
+  EXPECT_EQ(Mat3::rotationZ(angle), (Mat3{c, -s, 0, s, c, 0, 0, 0, 1}));
+
+  // A quarter turn about z takes x to y
+  Vec3 turned = Mat3::rotationZ(std::acos(real_t(-1)) / 2) * Vec3{1, 0, 0};
+  EXPECT_NEAR(turned.x(), 0, 1e-15);
+  EXPECT_NEAR(turned.y(), 1, 1e-15);
+
+  expectNear(Mat3::rotation(Vec3{1, 0, 0}, angle), Mat3::rotationX(angle), 1e-16);
+  expectNear(Mat3::rotation(Vec3{0, 1, 0}, angle), Mat3::rotationY(angle), 1e-16);
+  expectNear(Mat3::rotation(Vec3{0, 0, 1}, angle), Mat3::rotationZ(angle), 1e-16);
+}
+
+TEST(PJ_MAT_TEST, test_quaternion_rotation)
+{
+  real_t k = 1 / std::sqrt(real_t(14));
+  Vec3 axis{1 * k, -2 * k, 3 * k};
+  const real_t angle = 2.1;
+  Mat3 r = Mat3::rotation(axis, angle);
+  expectNear(Mat3::fromQuaternion(axisAngle(axis, angle)), r, 1e-15);
+
+  Vec4 q = toQuaternion(r);
+  expectNear(q, axisAngle(axis, angle), 1e-15);
+  // Every branch of the conversion, including the rotations by pi with a zero trace
+  for (const Mat3 &rotation : {Mat3::rotationX(3.1), Mat3::rotationY(3.1), Mat3::rotationZ(3.1),
+                               Mat3::rotationX(std::acos(real_t(-1))), Mat3::identity()})
+  {
+    expectNear(Mat3::fromQuaternion(toQuaternion(rotation)), rotation, 1e-15);
+  }
+}
+
+TEST(PJ_MAT_TEST, test_from_trs_matches_products)
+{
+  Vec3 translation{1.5, -2, 3};
+  Mat3 rotation = Mat3::rotationZ(0.3) * Mat3::rotationX(-1.2);
+  Vec3 scale{2, 0.5, -3};
+
+  Mat4 t = Mat4::identity();
+  t.at(0, 3) = translation.x();
+  t.at(1, 3) = translation.y();
+  t.at(2, 3) = translation.z();
+  Mat4 s = Mat4::identity();
+  s.at(0, 0) = scale.x();
+  s.at(1, 1) = scale.y();
+  s.at(2, 2) = scale.z();
+
+  expectNear(Mat4::fromTRS(translation, rotation, scale), t * embed(rotation) * s, 1e-15);
+  expectNear(Mat4::fromTRS(translation, toQuaternion(rotation), scale), t * embed(rotation) * s, 1e-15);
+}
+
+TEST(PJ_MAT_TEST, test_decompose_trs)
+{
+  Vec3 translation{-4, 0.25, 9};
+  Mat3 rotation = Mat3::rotation(Vec3{0, 0.6, 0.8}, 1.1);
+  Vec3 scale{3, 0.5, 7};
+  TRS parts = decomposeTRS(Mat4::fromTRS(translation, rotation, scale));
+  expectNear(parts.translation, translation, 0);
+  expectNear(parts.rotation, rotation, 1e-15);
+  expectNear(parts.scale, scale, 1e-15);
+
+  // A mirror moves into the x scale, the rotation stays proper
+  Mat4 mirrored = Mat4::fromTRS(translation, rotation, Vec3{3, -0.5, 7});
+  TRS mirroredParts = decomposeTRS(mirrored);
+  EXPECT_LT(mirroredParts.scale.x(), 0);
+  EXPECT_GT(mirroredParts.scale.y(), 0);
+  expectNear(Mat4::fromTRS(mirroredParts.translation, mirroredParts.rotation, mirroredParts.scale), mirrored,
+             1e-15);
+}
+
+TEST(PJ_MAT_TEST, test_batch_trs)
+{
+  std::mt19937 random(11);
+  std::uniform_real_distribution<real_t> uniform(-2, 2);
+  size_t count = 10000;
+  std::vector<Vec3> translations;
+  std::vector<Vec4> rotations;
+  std::vector<Vec3> scales;
+  for (size_t i = 0; i < count; i++)
+  {
+    translations.push_back(Vec3{uniform(random), uniform(random), uniform(random)});
+    Vec3 axis{uniform(random), uniform(random), uniform(random)};
+    real_t length = std::sqrt(axis.x() * axis.x() + axis.y() * axis.y() + axis.z() * axis.z());
+    axis *= 1 / length;
+    rotations.push_back(axisAngle(axis, 3 * uniform(random)));
+    scales.push_back(Vec3{1 + std::fabs(uniform(random)), 0.5, 1 + std::fabs(uniform(random))});
+  }
+
+  std::vector<Mat4> transforms(count);
+  fromTRS(translations, rotations, scales, transforms);
+  std::vector<TRS> parts(count);
+  decomposeTRS(transforms, parts);
+  for (size_t i = 0; i < count; i++)
+  {
+    ASSERT_EQ(transforms[i], Mat4::fromTRS(translations[i], rotations[i], scales[i]));
+    expectNear(parts[i].scale, scales[i], 1e-14);
+    Vec4 expected = rotations[i];
+    if (expected.w() < 0)
+    {
+      expected *= -1;
+    }
+    expectNear(toQuaternion(parts[i].rotation), expected, 1e-14);
+  }
+
+  std::vector<TRS> tooFew(count - 1);
+  EXPECT_THROW(decomposeTRS(transforms, tooFew), std::invalid_argument);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
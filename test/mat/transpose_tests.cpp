@@ -0,0 +1,89 @@
+
+#include <gtest/gtest.h>
+#include <pjmath/mat3.hpp>
+#include <pjmath/mat4.hpp>
+
+using namespace pjmath;
+
+TEST(mat_transpose, in_place)
+{
+  Mat4 mat{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+  Mat4 expected{1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15, 4, 8, 12, 16};
+
+  Mat4 &result = mat.transpose();
+  EXPECT_EQ(&result, &mat);
+  EXPECT_EQ(mat, expected);
+
+  mat.transpose();
+  EXPECT_EQ(mat, expected.transposed());
+
+  auto diagonal = Mat<int, 5, 5>::diagonal(3);
+  diagonal.transpose();
+  EXPECT_EQ(diagonal, (Mat<int, 5, 5>::diagonal(3)));
+}
+
+TEST(mat_transpose, view)
+{
+  Mat<int, 2, 3> mat{1, 2, 3, 4, 5, 6};
+  auto view = mat.transposedView();
+
+  EXPECT_EQ(view.row_count, 3);
+  EXPECT_EQ(view.column_count, 2);
+  EXPECT_EQ(view.at(2, 1), 6);
+  EXPECT_EQ((Mat<int, 3, 2>(view)), mat.transposed());
+
+  view.at(0, 1) = 40;
+  EXPECT_EQ(mat.at(1, 0), 40);
+
+  auto twice = view.transposedView();
+  EXPECT_EQ((Mat<int, 2, 3>(twice)), mat);
+
+  auto column = mat.col(2).transposedView();
+  EXPECT_EQ((Mat<int, 1, 2>(column)), (Mat<int, 1, 2>{3, 6}));
+}
+
+TEST(mat_transpose, transposed_lhs_multiply)
+{
+  Mat<int, 3, 2> lhs{1, 2, 3, 4, 5, 6};
+  Mat<int, 3, 4> rhs{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+
+  Mat<int, 2, 4> expected = lhs.transposed() * rhs;
+  Mat<int, 2, 4> result = lhs.transposedView() * rhs;
+  EXPECT_EQ(result, expected);
+  EXPECT_EQ(expected, (Mat<int, 2, 4>{61, 70, 79, 88, 76, 88, 100, 112}));
+}
+
+TEST(mat_transpose, transposed_rhs_multiply)
+{
+  Mat<int, 2, 3> lhs{1, 2, 3, 4, 5, 6};
+  Mat<int, 4, 3> rhs{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+
+  Mat<int, 2, 4> expected = lhs * rhs.transposed();
+  Mat<int, 2, 4> result = lhs * rhs.transposedView();
+  EXPECT_EQ(result, expected);
+  EXPECT_EQ(expected, (Mat<int, 2, 4>{14, 32, 50, 68, 32, 77, 122, 167}));
+
+  Mat<int, 4, 2> swapped = rhs * lhs.transposedView();
+  EXPECT_EQ(swapped, expected.transposed());
+
+  Mat<int, 3, 2> other{1, 2, 3, 4, 5, 6};
+  Mat<int, 2, 4> both = other.transposedView() * rhs.transposedView();
+  EXPECT_EQ(both, (rhs * other).transposed());
+}
+
+TEST(mat_transpose, normal_matrix)
+{
+  Mat3 mat{2, 0, 1, 1, 3, 0, 0, 1, 4};
+
+  Mat3 gram = mat.transposedView() * mat;
+  EXPECT_EQ(gram, mat.transposed() * mat);
+
+  Mat3 outer = mat * mat.transposedView();
+  EXPECT_EQ(outer, mat * mat.transposed());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
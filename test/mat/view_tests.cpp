@@ -0,0 +1,109 @@
+
+#include <gtest/gtest.h>
+#include <pjmath/mat3.hpp>
+#include <pjmath/mat4.hpp>
+#include <pjmath/vec3.hpp>
+#include <pjmath/vec4.hpp>
+
+using namespace pjmath;
+
+TEST(mat_view, block_read_write)
+{
+  Mat4 mat{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+
+  Mat3 rotation = mat.block<0, 0, 3, 3>();
+  EXPECT_EQ(rotation, (Mat3{1, 2, 3, 5, 6, 7, 9, 10, 11}));
+
+  auto inner = mat.block<1, 1, 2, 2>();
+  EXPECT_EQ(inner.at(0, 0), 6);
+  EXPECT_EQ((inner.get<1, 1>()), 11);
+  EXPECT_EQ(inner.sum(), 6 + 7 + 10 + 11);
+
+  inner.fill(0);
+  EXPECT_EQ(mat.at(1, 1), 0);
+  EXPECT_EQ(mat.at(2, 2), 0);
+  EXPECT_EQ(mat.at(1, 0), 5);
+
+  mat.block<0, 0, 3, 3>() = Mat3::identity();
+  EXPECT_EQ((mat.block<0, 0, 3, 3>().sum()), 3);
+  EXPECT_EQ(mat.at(0, 3), 4);
+
+  EXPECT_THROW(inner.at(2, 0), std::out_of_range);
+}
+
+TEST(mat_view, rows_and_columns)
+{
+  Mat4 mat = Mat4::identity();
+
+  mat.block<0, 3, 3, 1>() = Vec3{7, 8, 9};
+  EXPECT_EQ(mat.at(0, 3), 7);
+  EXPECT_EQ(mat.at(1, 3), 8);
+  EXPECT_EQ(mat.at(2, 3), 9);
+  EXPECT_EQ(mat.at(3, 3), 1);
+
+  mat.col(3) += Vec4{1, 1, 1, 0};
+  EXPECT_EQ(mat.at(2, 3), 10);
+
+  mat.row(0) = mat.row(1);
+  EXPECT_EQ(mat.at(0, 0), 0);
+  EXPECT_EQ(mat.at(0, 1), 1);
+  EXPECT_EQ(mat.at(0, 3), 9);
+
+  mat.row(2) *= 2;
+  EXPECT_EQ(mat.at(2, 2), 2);
+  EXPECT_EQ(mat.at(2, 3), 20);
+
+  const Mat4 &constMat = mat;
+  Vec4 column = constMat.col(3);
+  EXPECT_EQ(column, (Vec4{9, 9, 20, 1}));
+
+  EXPECT_THROW(mat.row(4), std::out_of_range);
+  EXPECT_THROW(mat.col(4), std::out_of_range);
+}
+
+TEST(mat_view, element_wise)
+{
+  Mat<int, 3, 3> mat{1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+  Mat<int, 2, 2> sum = mat.block<0, 0, 2, 2>() + mat.block<1, 1, 2, 2>();
+  EXPECT_EQ(sum, (Mat<int, 2, 2>{6, 8, 12, 14}));
+
+  Mat<int, 1, 3> difference = mat.row(2) - mat.row(0);
+  EXPECT_EQ(difference, (Mat<int, 1, 3>{6, 6, 6}));
+
+  Mat<int, 3, 1> negated = -mat.col(0);
+  EXPECT_EQ(negated, (Mat<int, 3, 1>{-1, -4, -7}));
+
+  Mat<int, 3, 1> scaled = mat.col(1) * 2;
+  EXPECT_EQ(scaled, (Mat<int, 3, 1>{4, 10, 16}));
+
+  Mat<int, 2, 2> accumulated = Mat<int, 2, 2>::one();
+  accumulated += mat.block<1, 1, 2, 2>();
+  accumulated -= mat.block<0, 0, 2, 2>();
+  EXPECT_EQ(accumulated, (Mat<int, 2, 2>{5, 5, 5, 5}));
+}
+
+TEST(mat_view, multiply)
+{
+  Mat4 transform{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+  Vec3 vec{1, 2, 3};
+
+  Vec3 rotated = transform.block<0, 0, 3, 3>() * vec;
+  EXPECT_EQ(rotated, (Vec3{14, 38, 62}));
+
+  Mat3 rhs = Mat3::identity() * 2;
+  Mat3 scaled = transform.block<1, 1, 3, 3>() * rhs;
+  EXPECT_EQ(scaled, (Mat3{12, 14, 16, 20, 22, 24, 28, 30, 32}));
+
+  Mat<real_t, 1, 1> dot = transform.row(0) * transform.col(0);
+  EXPECT_EQ(dot.at(0), 1 + 10 + 27 + 52);
+
+  Vec4 column = transform * transform.col(3);
+  EXPECT_EQ(column, (Vec4{120, 280, 440, 600}));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
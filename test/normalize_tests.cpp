@@ -0,0 +1,88 @@
+
+#include <gtest/gtest.h>
+#include <pjmath/batch.hpp>
+#include <pjmath/vec3.hpp>
+#include <pjmath/vector.hpp>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace pjmath;
+
+namespace
+{
+  std::vector<Vector3> randomVectors(size_t count, real_t scale)
+  {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<real_t> dist(-scale, scale);
+    std::vector<Vector3> vectors(count);
+    for (Vector3 &v : vectors)
+    {
+      v = Vector3{dist(rng), dist(rng), dist(rng)};
+    }
+    return vectors;
+  }
+}
+
+TEST(normalize, exact_mode)
+{
+  std::vector<Vector3> vectors = randomVectors(1000, 100);
+  std::vector<Vector3> expected = vectors;
+  normalize<Vector3>(vectors);
+
+  for (size_t i = 0; i < vectors.size(); i++)
+  {
+    expected[i].Normalize();
+    EXPECT_NEAR(vectors[i].Norm(), 1, 4 * std::numeric_limits<real_t>::epsilon());
+    for (size_t k = 0; k < 3; k++)
+    {
+      EXPECT_NEAR(vectors[i][k], expected[i][k], 4 * std::numeric_limits<real_t>::epsilon());
+    }
+  }
+}
+
+TEST(normalize, fast_mode)
+{
+  for (real_t scale : {1e-10, 1.0, 1e10, 1e30})
+  {
+    std::vector<Vector3> vectors = randomVectors(999, scale);
+    std::vector<Vector3> original = vectors;
+    normalize<Vector3>(vectors, NormalizeMode::fast);
+
+    for (size_t i = 0; i < vectors.size(); i++)
+    {
+      EXPECT_NEAR(vectors[i].Norm(), 1, 2.5e-7);
+      EXPECT_NEAR(vectors[i].Dot(original[i].Normalized()), 1, 2.5e-7);
+    }
+  }
+}
+
+TEST(normalize, zero_length)
+{
+  for (NormalizeMode mode : {NormalizeMode::exact, NormalizeMode::fast})
+  {
+    std::vector<Vector3> vectors{Vector3::Zero(), Vector3{3, 0, 4}, Vector3::Zero(), Vector3{0, 2, 0}};
+    normalize<Vector3>(vectors, mode);
+    EXPECT_EQ(vectors[0], Vector3::Zero());
+    EXPECT_EQ(vectors[2], Vector3::Zero());
+    EXPECT_NEAR(vectors[1].x(), 0.6, 2.5e-7);
+    EXPECT_NEAR(vectors[1].z(), 0.8, 2.5e-7);
+    EXPECT_NEAR(vectors[3].y(), 1, 2.5e-7);
+  }
+}
+
+TEST(normalize, vec3)
+{
+  std::vector<Vec3> vectors{{0, 0, 5}, {1, 1, 1}};
+  normalize<Vec3>(vectors, NormalizeMode::fast);
+  EXPECT_NEAR(vectors[0].z(), 1, 2.5e-7);
+  EXPECT_NEAR(vectors[1].x(), 1 / std::sqrt(3.0), 2.5e-7);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
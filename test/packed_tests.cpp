@@ -0,0 +1,162 @@
+#include <pjmath/packed.hpp>
+#include <pjmath/vec3.hpp>
+#include <pjmath/vector.hpp>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace pjmath;
+
+TEST(PJ_PACKED_TEST, half_known_values)
+{
+  EXPECT_EQ(Half(1.0f).bits(), 0x3c00);
+  EXPECT_EQ(Half(-2.0f).bits(), 0xc000);
+  EXPECT_EQ(Half(65504.0f).bits(), 0x7bff);
+  EXPECT_EQ(Half(0.0f).bits(), 0x0000);
+  EXPECT_EQ(Half(-0.0f).bits(), 0x8000);
+  EXPECT_EQ(Half(std::ldexp(1.0f, -24)).bits(), 0x0001);
+  EXPECT_EQ(Half(std::ldexp(1.0f, -14)).bits(), 0x0400);
+  // 65520 is halfway between the largest half and the next power of two, it rounds to infinity
+  EXPECT_EQ(Half(65519.0f).bits(), 0x7bff);
+  EXPECT_EQ(Half(65520.0f).bits(), 0x7c00);
+  EXPECT_EQ(Half(std::numeric_limits<float>::infinity()).bits(), 0x7c00);
+  EXPECT_TRUE(std::isnan(float(Half(std::numeric_limits<float>::quiet_NaN()))));
+  // Ties round to even
+  EXPECT_EQ(float(Half(2049.0f)), 2048.0f);
+  EXPECT_EQ(float(Half(2051.0f)), 2052.0f);
+  EXPECT_EQ(Half(std::ldexp(1.0f, -25)).bits(), 0x0000);
+  EXPECT_EQ(Half(std::ldexp(3.0f, -25)).bits(), 0x0002);
+}
+
+TEST(PJ_PACKED_TEST, half_round_trips_every_encoding)
+{
+  for (uint32_t bits = 0; bits < 0x10000; bits++)
+  {
+    Half half = Half::fromBits(uint16_t(bits));
+    float value = float(half);
+    if (std::isnan(value))
+    {
+      continue;
+    }
+    EXPECT_EQ(Half(value).bits(), bits);
+  }
+}
+
+TEST(PJ_PACKED_TEST, bfloat16_known_values)
+{
+  EXPECT_EQ(BFloat16(1.0f).bits(), 0x3f80);
+  EXPECT_EQ(BFloat16(-1.5f).bits(), 0xbfc0);
+  // Keeps the float range with 8 significant bits
+  EXPECT_NEAR(float(BFloat16(3.0e38f)) / 3.0e38f, 1.0f, std::ldexp(1.0f, -9));
+  // 1 + 2^-8 is halfway between 1 and 1 + 2^-7, ties go to the even 1
+  EXPECT_EQ(float(BFloat16(1.0f + std::ldexp(1.0f, -8))), 1.0f);
+  EXPECT_EQ(float(BFloat16(1.0f + std::ldexp(3.0f, -8))), 1.0f + std::ldexp(1.0f, -6));
+  EXPECT_TRUE(std::isnan(float(BFloat16(std::numeric_limits<float>::quiet_NaN()))));
+  EXPECT_TRUE(std::isnan(float(BFloat16(std::numeric_limits<float>::signaling_NaN()))));
+}
+
+TEST(PJ_PACKED_TEST, batch_matches_scalar)
+{
+  std::mt19937 random(5);
+  std::uniform_real_distribution<real_t> exponent(-30, 17);
+  std::uniform_int_distribution<int> sign(0, 1);
+  // An odd count leaves a tail after the eight-wide conversion loop
+  std::vector<Vector3> vectors(1001);
+  for (Vector3 &v : vectors)
+  {
+    for (real_t &x : v)
+    {
+      x = (sign(random) ? -1 : 1) * std::exp2(exponent(random));
+    }
+  }
+  vectors[0] = Vector3{0, -0.0, 1e9};
+
+  std::vector<Half3> halves(vectors.size());
+  std::vector<BFloat16x3> bfloats(vectors.size());
+  encodeHalf<Vector3>(vectors, halves);
+  encodeBFloat16<Vector3>(vectors, bfloats);
+
+  std::vector<Vector3> fromHalves(vectors.size());
+  std::vector<Vector3> fromBFloats(vectors.size());
+  decodeHalf<Vector3>(halves, fromHalves);
+  decodeBFloat16<Vector3>(bfloats, fromBFloats);
+
+  for (size_t i = 0; i < vectors.size(); i++)
+  {
+    for (size_t k = 0; k < 3; k++)
+    {
+      float value = float(vectors[i][k]);
+      ASSERT_EQ(halves[i][k].bits(), Half(value).bits()) << i;
+      ASSERT_EQ(bfloats[i][k].bits(), BFloat16(value).bits()) << i;
+      ASSERT_EQ(fromHalves[i][k], real_t(float(Half(value)))) << i;
+      ASSERT_EQ(fromBFloats[i][k], real_t(float(BFloat16(value)))) << i;
+    }
+  }
+}
+
+TEST(PJ_PACKED_TEST, batch_rejects_mismatched_sizes)
+{
+  std::vector<Vec3> vectors(4);
+  std::vector<Half3> halves(3);
+  EXPECT_THROW(encodeHalf<Vec3>(vectors, halves), std::invalid_argument);
+}
+
+TEST(PJ_PACKED_TEST, octahedral_error_bound)
+{
+  std::mt19937 random(9);
+  std::normal_distribution<real_t> normal;
+  std::vector<Vec3> directions = {Vec3{1, 0, 0}, Vec3{-1, 0, 0}, Vec3{0, 1, 0}, Vec3{0, -1, 0},
+                                  Vec3{0, 0, 1}, Vec3{0, 0, -1}, Vec3{1, 1, -1}, Vec3{-1, 1, -1e-12}};
+  for (size_t i = 0; i < 20000; i++)
+  {
+    directions.push_back(Vec3{normal(random), normal(random), normal(random)});
+  }
+  for (Vec3 &d : directions)
+  {
+    real_t length = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    d = Vec3{d[0] / length, d[1] / length, d[2] / length};
+  }
+
+  std::vector<Octahedral> packed(directions.size());
+  std::vector<Vec3> decoded(directions.size());
+  encodeOctahedral<Vec3>(directions, packed);
+  decodeOctahedral<Vec3>(packed, decoded);
+
+  real_t worst = 0;
+  for (size_t i = 0; i < directions.size(); i++)
+  {
+    const Vec3 &a = directions[i];
+    const Vec3 &b = decoded[i];
+    real_t length = std::sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2]);
+    EXPECT_NEAR(length, 1, 1e-15);
+    real_t cx = a[1] * b[2] - a[2] * b[1];
+    real_t cy = a[2] * b[0] - a[0] * b[2];
+    real_t cz = a[0] * b[1] - a[1] * b[0];
+    real_t angle = std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), a[0] * b[0] + a[1] * b[1] + a[2] * b[2]);
+    worst = std::max(worst, angle);
+  }
+  EXPECT_LT(worst, 7e-5);
+  for (size_t i = 0; i < 6; i++)
+  {
+    EXPECT_EQ(decoded[i], directions[i]);
+  }
+}
+
+TEST(PJ_PACKED_TEST, octahedral_zero_vector_is_up)
+{
+  std::vector<Vector3> zero = {Vector3{0, 0, 0}};
+  std::vector<Octahedral> packed(1);
+  std::vector<Vector3> decoded(1);
+  encodeOctahedral<Vector3>(zero, packed);
+  decodeOctahedral<Vector3>(packed, decoded);
+  EXPECT_EQ(decoded[0], (Vector3{0, 0, 1}));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
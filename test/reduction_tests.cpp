@@ -0,0 +1,174 @@
+
+#include <gtest/gtest.h>
+#include <pjmath/batch.hpp>
+#include <pjmath/dispatch.hpp>
+#include <pjmath/mat.hpp>
+#include <pjmath/thread_pool.hpp>
+#include <pjmath/vec3.hpp>
+#include <pjmath/vector.hpp>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace pjmath;
+
+namespace
+{
+  // Sums to exactly 1 but loses it entirely when added naively in order
+  std::vector<double> cancellingTerms(size_t pairs)
+  {
+    std::vector<double> terms{1};
+    for (size_t i = 0; i < pairs; i++)
+    {
+      terms.push_back(1e16);
+      terms.push_back(-1e16);
+    }
+    return terms;
+  }
+}
+
+TEST(reduction, modes_agree_on_exact_sums)
+{
+  std::vector<double> values;
+  for (int i = 0; i < 1000; i++)
+  {
+    values.push_back(i);
+  }
+  for (Summation mode : {Summation::fast, Summation::pairwise, Summation::kahan})
+  {
+    EXPECT_EQ(kernels::sum(values.data(), values.size(), mode), 499500);
+    EXPECT_EQ(kernels::dot(values.data(), values.data(), 10, mode), 285);
+  }
+
+  std::vector<int> integers(77, 3);
+  EXPECT_EQ(kernels::sum(integers.data(), integers.size(), Summation::kahan), 231);
+}
+
+TEST(reduction, compensated_sum)
+{
+  std::vector<double> terms = cancellingTerms(20);
+  EXPECT_EQ(kernels::sum(terms.data(), terms.size(), Summation::kahan), 1);
+
+  std::vector<double> small(1 << 16, 0.1);
+  double exact = 0.1 * small.size();
+  double naive = 0;
+  for (double value : small)
+  {
+    naive += value;
+  }
+  double pairwise = kernels::sum(small.data(), small.size(), Summation::pairwise);
+  double kahan = kernels::sum(small.data(), small.size(), Summation::kahan);
+  EXPECT_LT(std::abs(pairwise - exact), std::abs(naive - exact));
+  EXPECT_DOUBLE_EQ(kahan, exact);
+}
+
+TEST(reduction, compensated_dot)
+{
+  std::vector<double> a{1e8 + 1, 1e8 - 1, 1};
+  std::vector<double> b{1e8 + 1, -(1e8 - 1), -4e8};
+  // (1e8 + 1)^2 - (1e8 - 1)^2 = 4e8, so the exact dot product is zero
+  EXPECT_EQ(kernels::dot(a.data(), b.data(), a.size(), Summation::kahan), 0);
+
+  // (1 + 2^-30)(1 - 2^-30) rounds to one, only the recovered product error is left
+  std::vector<double> c{1 + 0x1p-30, 1};
+  std::vector<double> d{1 - 0x1p-30, -1};
+  EXPECT_EQ(kernels::dot(c.data(), d.data(), c.size(), Summation::kahan), -0x1p-60);
+  std::vector<float> e{1 + 0x1p-12f, 1};
+  std::vector<float> f{1 - 0x1p-12f, -1};
+  EXPECT_EQ(kernels::dot(e.data(), f.data(), e.size(), Summation::kahan), -0x1p-24f);
+}
+
+TEST(reduction, mat_sum)
+{
+  auto mat = Mat<float, 12, 12>::filled(0.1f);
+  EXPECT_FLOAT_EQ(mat.sum(), 14.4f);
+  EXPECT_FLOAT_EQ(mat.sum(Summation::pairwise), 14.4f);
+  EXPECT_FLOAT_EQ(mat.sum(Summation::kahan), 14.4f);
+  EXPECT_FLOAT_EQ(mat.sum(Summation::reproducible), 14.4f);
+}
+
+TEST(reduction, vector_dot)
+{
+  Vector3 a{1, 2, 3};
+  Vector3 b{4, -5, 6};
+  EXPECT_EQ(a.Dot(b), 12);
+  EXPECT_EQ(a.Dot(b, Summation::kahan), 12);
+  EXPECT_EQ(a.NormSquared(Summation::pairwise), 14);
+
+  Vector<3, std::nullptr_t, float> f{0.5f, 0.25f, 2.0f};
+  EXPECT_TRUE((std::is_same_v<decltype(f.Dot(f)), float>));
+  EXPECT_FLOAT_EQ(f.Dot(f), 4.3125f);
+}
+
+TEST(reduction, batch_dot)
+{
+  std::vector<Vector3> a;
+  std::vector<Vector3> b;
+  for (int i = 0; i < 100; i++)
+  {
+    a.push_back(Vector3{real_t(i), 1, -1});
+    b.push_back(Vector3{2, real_t(i), 3});
+  }
+  std::vector<real_t> out(a.size());
+  dot<Vector3>(a, b, out);
+  for (size_t i = 0; i < a.size(); i++)
+  {
+    EXPECT_EQ(out[i], a[i].Dot(b[i]));
+  }
+
+  std::vector<Vec3> c{{1, 2, 3}, {0, 1, 0}};
+  std::vector<real_t> vecOut(2);
+  dot<Vec3>(c, c, vecOut);
+  EXPECT_EQ(vecOut[0], 14);
+  EXPECT_EQ(vecOut[1], 1);
+}
+
+TEST(reduction, reproducible_across_threads)
+{
+  std::mt19937 random(3);
+  std::uniform_real_distribution<double> uniform(-1e3, 1e3);
+  std::vector<double> a(1000003), b(a.size());
+  for (size_t i = 0; i < a.size(); i++)
+  {
+    a[i] = uniform(random) * std::exp(uniform(random) / 100);
+    b[i] = uniform(random);
+  }
+  double expectedSum = kernels::sum(a.data(), a.size(), Summation::reproducible);
+  double expectedDot = kernels::dot(a.data(), b.data(), a.size(), Summation::reproducible);
+
+  Isa initial = activeIsa();
+  for (size_t workers : {1, 2, 3, 7})
+  {
+    ThreadPool pool(workers);
+    setExecutor(&pool);
+    for (Isa isa : {Isa::baseline, Isa::sse42, Isa::avx2, Isa::avx512})
+    {
+      if (!isaSupported(isa))
+      {
+        continue;
+      }
+      setIsa(isa);
+      for (size_t n : {0, 1000, 1024, 5000})
+      {
+        EXPECT_EQ(sum(std::span<const double>(a.data(), n), Summation::reproducible),
+                  kernels::sum(a.data(), n, Summation::reproducible));
+      }
+      double s = sum(a, Summation::reproducible);
+      EXPECT_EQ(std::memcmp(&s, &expectedSum, sizeof(s)), 0) << workers << " " << isaName(isa);
+      double d = dot(a, b, Summation::reproducible);
+      EXPECT_EQ(std::memcmp(&d, &expectedDot, sizeof(d)), 0) << workers << " " << isaName(isa);
+    }
+    setExecutor(nullptr);
+  }
+  setIsa(initial);
+
+  // Below one block the tree is a single leaf, the fast mode reduction
+  EXPECT_EQ(kernels::sum(a.data(), 1000, Summation::reproducible), kernels::sum(a.data(), 1000));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
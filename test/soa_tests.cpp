@@ -0,0 +1,136 @@
+
+#include <gtest/gtest.h>
+#include <pjmath/soa.hpp>
+#include <pjmath/vec3.hpp>
+#include <pjmath/vector.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace pjmath;
+
+TEST(soa, layout)
+{
+  SoAVec3Array array(100);
+  EXPECT_EQ(array.size(), 100);
+  for (size_t k = 0; k < 3; k++)
+  {
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(array.column(k).data()) % simd_alignment, 0);
+  }
+
+  array.push_back(Vector3{1, 2, 3});
+  EXPECT_EQ(array.size(), 101);
+  EXPECT_EQ(array.z()[100], 3);
+
+  array.clear();
+  EXPECT_TRUE(array.empty());
+}
+
+TEST(soa, element_proxy)
+{
+  SoAVec3Array array(2);
+  array[0] = Vector3{1, 2, 3};
+  array[1] = Vec3{4, 5, 6};
+  array[0].y() = 20;
+
+  Vector3 first = array[0];
+  Vec3 second = array[1];
+  EXPECT_EQ(first, (Vector3{1, 20, 3}));
+  EXPECT_EQ(second, (Vec3{4, 5, 6}));
+
+  array[0] = array[1];
+  EXPECT_EQ(array.x()[0], 4);
+
+  const SoAVec3Array &constArray = array;
+  EXPECT_EQ(constArray[1].z(), 6);
+
+  SoAVec2Array flat(1);
+  flat[0] = Vector2{7, 8};
+  EXPECT_EQ(flat.y()[0], 8);
+
+  SoAVec4Array wide(1);
+  wide[0].w() = 9;
+  EXPECT_EQ(static_cast<Vector4>(wide[0]), (Vector4{0, 0, 0, 9}));
+}
+
+TEST(soa, aos_conversion)
+{
+  std::vector<Vector3> vectors{{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+  auto array = SoAVec3Array::fromAoS<Vector3>(vectors);
+  EXPECT_EQ(array.size(), 3);
+  EXPECT_EQ(array.y()[2], 8);
+
+  std::vector<Vec3> back(3);
+  array.toAoS<Vec3>(back);
+  EXPECT_EQ(back[1], (Vec3{4, 5, 6}));
+
+  std::vector<Vec3> wrongSize(2);
+  EXPECT_THROW(array.toAoS<Vec3>(wrongSize), std::invalid_argument);
+}
+
+TEST(soa, arithmetic)
+{
+  std::vector<Vector3> a{{1, 2, 3}, {0, 1, 0}, {3, 0, 4}};
+  std::vector<Vector3> b{{1, 1, 1}, {1, 0, 0}, {0, 0, 1}};
+  auto lhs = SoAVec3Array::fromAoS<Vector3>(a);
+  auto rhs = SoAVec3Array::fromAoS<Vector3>(b);
+
+  std::vector<real_t> dots(3);
+  lhs.dot(rhs, dots);
+  for (size_t i = 0; i < 3; i++)
+  {
+    EXPECT_EQ(dots[i], a[i].Dot(b[i]));
+  }
+
+  SoAVec3Array crossed;
+  lhs.cross(rhs, crossed);
+  for (size_t i = 0; i < 3; i++)
+  {
+    EXPECT_EQ(static_cast<Vector3>(crossed[i]), a[i].Cross(b[i]));
+  }
+
+  lhs.cross(rhs, lhs);
+  EXPECT_EQ(static_cast<Vector3>(lhs[0]), a[0].Cross(b[0]));
+
+  lhs = SoAVec3Array::fromAoS<Vector3>(a);
+  lhs += rhs;
+  EXPECT_EQ(static_cast<Vector3>(lhs[0]), (Vector3{2, 3, 4}));
+  lhs -= rhs;
+  lhs *= 2;
+  EXPECT_EQ(static_cast<Vector3>(lhs[2]), (Vector3{6, 0, 8}));
+  lhs.addScaled(rhs, -2);
+  EXPECT_EQ(static_cast<Vector3>(lhs[1]), (Vector3{-2, 2, 0}));
+
+  std::vector<real_t> lengths(3);
+  lhs.lengthsSquared(lengths);
+  EXPECT_EQ(lengths[2], 6 * 6 + 6 * 6);
+
+  SoAVec3Array shorter(2);
+  EXPECT_THROW(lhs += shorter, std::invalid_argument);
+}
+
+TEST(soa, normalize)
+{
+  for (NormalizeMode mode : {NormalizeMode::exact, NormalizeMode::fast})
+  {
+    SoAVec3Array array;
+    for (int i = 0; i < 200; i++)
+    {
+      array.push_back(Vector3{real_t(i), real_t(i % 7), -1});
+    }
+    array.push_back(Vector3::Zero());
+    array.normalize(mode);
+
+    for (size_t i = 0; i < 200; i++)
+    {
+      EXPECT_NEAR(static_cast<Vector3>(array[i]).Norm(), 1, 2.5e-7);
+    }
+    EXPECT_EQ(static_cast<Vector3>(array[200]), Vector3::Zero());
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,181 @@
+#include <pjmath/statistics.hpp>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+using namespace pjmath;
+
+namespace
+{
+  std::vector<Vec3> randomPoints(size_t count, real_t offset, unsigned seed)
+  {
+    std::mt19937 rng(seed);
+    std::normal_distribution<real_t> normal;
+    std::vector<Vec3> points;
+    for (size_t i = 0; i < count; i++)
+    {
+      real_t a = normal(rng), b = normal(rng), c = normal(rng);
+      points.push_back(Vec3{offset + 3 * a, offset + a + 0.5 * b, offset - 2 * c + b});
+    }
+    return points;
+  }
+
+  /**
+   * Two pass reference in long double
+   */
+  void referenceStatistics(const std::vector<Vec3> &points, Vec3 &mean, Mat3 &covariance)
+  {
+    long double sum[3] = {0, 0, 0};
+    for (const Vec3 &p : points)
+    {
+      for (size_t k = 0; k < 3; k++)
+      {
+        sum[k] += p[k];
+      }
+    }
+    long double m[3] = {sum[0] / points.size(), sum[1] / points.size(), sum[2] / points.size()};
+    long double c[9] = {};
+    for (const Vec3 &p : points)
+    {
+      for (size_t i = 0; i < 3; i++)
+      {
+        for (size_t j = 0; j < 3; j++)
+        {
+          c[i * 3 + j] += (p[i] - m[i]) * (p[j] - m[j]);
+        }
+      }
+    }
+    mean = Vec3{real_t(m[0]), real_t(m[1]), real_t(m[2])};
+    for (size_t k = 0; k < 9; k++)
+    {
+      covariance[k] = real_t(c[k] / points.size());
+    }
+  }
+
+  void expectMatches(const PointStatistics &statistics, const std::vector<Vec3> &points, real_t tolerance)
+  {
+    Vec3 mean;
+    Mat3 covariance;
+    referenceStatistics(points, mean, covariance);
+    ASSERT_EQ(statistics.count(), points.size());
+    for (size_t k = 0; k < 3; k++)
+    {
+      EXPECT_NEAR(statistics.mean()[k], mean[k], tolerance);
+    }
+    Mat3 actual = statistics.covariance();
+    for (size_t k = 0; k < 9; k++)
+    {
+      EXPECT_NEAR(actual[k], covariance[k], tolerance);
+    }
+  }
+}
+
+TEST(PJ_STATISTICS_TEST, empty)
+{
+  PointStatistics statistics;
+  EXPECT_EQ(statistics.count(), 0u);
+  EXPECT_EQ(statistics.covariance(), Mat3{});
+  EXPECT_EQ(statistics.sampleCovariance(), Mat3{});
+  EXPECT_TRUE(statistics.bounds().isEmpty());
+
+  PointStatistics other;
+  other.add(Vec3{1, 2, 3});
+  statistics.merge(PointStatistics{});
+  other.merge(statistics);
+  EXPECT_EQ(other.count(), 1u);
+  EXPECT_EQ(other.mean(), (Vec3{1, 2, 3}));
+  EXPECT_EQ(other.sampleCovariance(), Mat3{});
+}
+
+TEST(PJ_STATISTICS_TEST, single_points)
+{
+  std::vector<Vec3> points = randomPoints(1000, 0, 1);
+  PointStatistics statistics;
+  for (const Vec3 &p : points)
+  {
+    statistics.add(p);
+  }
+  expectMatches(statistics, points, 1e-12);
+
+  Aabb bounds = Aabb::empty();
+  for (const Vec3 &p : points)
+  {
+    bounds.expand(p);
+  }
+  EXPECT_EQ(statistics.bounds().min, bounds.min);
+  EXPECT_EQ(statistics.bounds().max, bounds.max);
+
+  Mat3 sample = statistics.sampleCovariance();
+  Mat3 population = statistics.covariance();
+  EXPECT_NEAR(sample[4], population[4] * 1000 / 999, 1e-12);
+}
+
+TEST(PJ_STATISTICS_TEST, large_offset)
+{
+  // The naive sum of squares loses every significant digit here
+  std::vector<Vec3> points = randomPoints(10000, 1e9, 2);
+  PointStatistics statistics;
+  statistics.add(std::span<const Vec3>(points));
+  expectMatches(statistics, points, 1e-6);
+}
+
+TEST(PJ_STATISTICS_TEST, merge_is_associative)
+{
+  std::vector<Vec3> points = randomPoints(3000, 5, 3);
+  std::span<const Vec3> all(points);
+  PointStatistics a, b, c;
+  a.add(all.subspan(0, 700));
+  b.add(all.subspan(700, 1));
+  c.add(all.subspan(701));
+
+  PointStatistics left = a;
+  left.merge(b);
+  left.merge(c);
+  PointStatistics right = b;
+  right.merge(c);
+  PointStatistics combined = a;
+  combined.merge(right);
+
+  expectMatches(left, points, 1e-10);
+  expectMatches(combined, points, 1e-10);
+  for (size_t k = 0; k < 9; k++)
+  {
+    EXPECT_NEAR(left.covariance()[k], combined.covariance()[k], 1e-12);
+  }
+}
+
+TEST(PJ_STATISTICS_TEST, parallel)
+{
+  std::vector<Vec3> points = randomPoints(200000, -40, 4);
+  PointStatistics statistics = pointStatistics(std::span<const Vec3>(points));
+  expectMatches(statistics, points, 1e-9);
+
+  SoAVec3Array soa = SoAVec3Array::fromAoS(std::span<const Vec3>(points));
+  PointStatistics columns = pointStatistics(soa);
+  EXPECT_EQ(columns.count(), statistics.count());
+  EXPECT_EQ(columns.mean(), statistics.mean());
+  EXPECT_EQ(columns.covariance(), statistics.covariance());
+  EXPECT_EQ(columns.bounds().min, statistics.bounds().min);
+  EXPECT_EQ(columns.bounds().max, statistics.bounds().max);
+}
+
+TEST(PJ_STATISTICS_TEST, column_size_mismatch)
+{
+  std::vector<real_t> x{1, 2, 3}, y{4, 5, 6}, z{7, 8};
+  PointStatistics statistics;
+  EXPECT_THROW(statistics.add(x, y, z), std::invalid_argument);
+  EXPECT_THROW(statistics.add(z, x, y), std::invalid_argument);
+  EXPECT_EQ(statistics.count(), 0u);
+
+  z.push_back(9);
+  statistics.add(x, y, z);
+  EXPECT_EQ(statistics.count(), 3u);
+  EXPECT_EQ(statistics.mean(), (Vec3{2, 5, 8}));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
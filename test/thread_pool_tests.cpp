@@ -0,0 +1,142 @@
+#include <pjmath/thread_pool.hpp>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace pjmath;
+
+namespace
+{
+  /**
+   * Forwards to a pool and counts the loops it is given
+   */
+  class CountingExecutor : public Executor
+  {
+  public:
+    explicit CountingExecutor(ThreadPool &pool) : pool_(pool)
+    {
+    }
+
+    void parallelFor(size_t begin, size_t end, size_t grain, RangeFunction body) override
+    {
+      loops++;
+      pool_.parallelFor(begin, end, grain, body);
+    }
+
+    size_t concurrency() const override
+    {
+      return pool_.concurrency();
+    }
+
+    std::atomic<size_t> loops{0};
+
+  private:
+    ThreadPool &pool_;
+  };
+}
+
+TEST(PJ_THREAD_POOL_TEST, covers_range_once)
+{
+  ThreadPool pool(3);
+  EXPECT_EQ(pool.concurrency(), 4u);
+  for (size_t grain : {1, 7, 100, 5000})
+  {
+    std::vector<std::atomic<int>> hits(10007);
+    std::atomic<size_t> smallest{hits.size()};
+    auto body = [&](size_t first, size_t last) {
+      size_t size = last - first;
+      size_t seen = smallest.load();
+      while (size < seen && !smallest.compare_exchange_weak(seen, size))
+      {
+      }
+      for (size_t i = first; i < last; i++)
+      {
+        hits[i]++;
+      }
+    };
+    pool.parallelFor(3, hits.size(), grain, RangeFunction(body));
+    for (size_t i = 0; i < hits.size(); i++)
+    {
+      ASSERT_EQ(hits[i], i < 3 ? 0 : 1);
+    }
+    EXPECT_GE(smallest.load(), std::min(grain, hits.size() - 3));
+  }
+}
+
+TEST(PJ_THREAD_POOL_TEST, nested_loops)
+{
+  ThreadPool pool(3);
+  std::atomic<size_t> total{0};
+  auto inner = [&](size_t first, size_t last) { total += last - first; };
+  auto outer = [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; i++)
+    {
+      pool.parallelFor(0, 1000, 10, RangeFunction(inner));
+    }
+  };
+  pool.parallelFor(0, 64, 1, RangeFunction(outer));
+  EXPECT_EQ(total.load(), 64000u);
+}
+
+TEST(PJ_THREAD_POOL_TEST, exceptions)
+{
+  ThreadPool pool(2);
+  std::atomic<size_t> ran{0};
+  auto body = [&](size_t first, size_t) {
+    ran++;
+    if (first == 0)
+    {
+      throw std::runtime_error("first chunk");
+    }
+  };
+  EXPECT_THROW(pool.parallelFor(0, 100, 1, RangeFunction(body)), std::runtime_error);
+  EXPECT_GE(ran.load(), 1u);
+
+  // The pool keeps working after a failed loop
+  std::atomic<size_t> sum{0};
+  auto count = [&](size_t first, size_t last) { sum += last - first; };
+  pool.parallelFor(0, 100, 1, RangeFunction(count));
+  EXPECT_EQ(sum.load(), 100u);
+}
+
+TEST(PJ_THREAD_POOL_TEST, executor_hook)
+{
+  ThreadPool pool(2);
+  CountingExecutor executor(pool);
+  setExecutor(&executor);
+  EXPECT_EQ(&currentExecutor(), &executor);
+
+  std::vector<int> values(10000, 1);
+  std::atomic<int> sum{0};
+  parallelFor(0, values.size(), 100, [&](size_t first, size_t last) {
+    int partial = 0;
+    for (size_t i = first; i < last; i++)
+    {
+      partial += values[i];
+    }
+    sum += partial;
+  });
+  EXPECT_EQ(sum.load(), 10000);
+  EXPECT_EQ(executor.loops.load(), 1u);
+
+  // Ranges below two grains run inline
+  parallelFor(0, 10, 100, [&](size_t first, size_t last) { sum += int(last - first); });
+  EXPECT_EQ(executor.loops.load(), 1u);
+
+  bool a = false;
+  bool b = false;
+  parallelInvoke([&] { a = true; }, [&] { b = true; });
+  EXPECT_TRUE(a && b);
+  EXPECT_EQ(executor.loops.load(), 2u);
+
+  setExecutor(nullptr);
+  EXPECT_EQ(&currentExecutor(), &ThreadPool::global());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
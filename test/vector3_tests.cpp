@@ -1,7 +1,9 @@
 #include <gtest/gtest.h>
 
+#include "pjmath/batch.hpp"
 #include "pjmath/vector.hpp"
 #include <cmath>
+#include <vector>
 
 using namespace pjmath;
 
@@ -64,6 +66,30 @@ TEST(PJ_MATH_TEST, STATIC_MEMBER_TEST)
   std::for_each(one.begin(), one.end(), [](real_t x) { EXPECT_FLOAT_EQ(x, 1); });
 }
 
+TEST(PJ_MATH_TEST, FUSED_TEST)
+{
+  Vector3 vec{1, 2, 3};
+  vec.AddScaled(Vector3{2, 2, 2}, .5);
+  EXPECT_EQ(vec, (Vector3{2, 3, 4}));
+
+  vec.Madd(Vector3{1, 2, 3}, Vector3{3, 2, 1});
+  EXPECT_EQ(vec, (Vector3{5, 7, 7}));
+
+  vec.Fma(Vector3{2, 2, 2}, Vector3{-10, -14, -14});
+  EXPECT_EQ(vec, Vector3::Zero());
+
+  vec.Lerp(Vector3{4, 8, 12}, .25);
+  EXPECT_EQ(vec, (Vector3{1, 2, 3}));
+
+  EXPECT_EQ(lerp(Vector3::Zero(), Vector3::One(), .5), (Vector3{.5, .5, .5}));
+
+  std::vector<Vector3> positions{{0, 0, 0}, {1, 2, 3}};
+  std::vector<Vector3> velocities{{1, 1, 1}, {-2, -4, -6}};
+  addScaled<Vector3>(positions, velocities, .5);
+  EXPECT_EQ(positions[0], (Vector3{.5, .5, .5}));
+  EXPECT_EQ(positions[1], Vector3::Zero());
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);